@@ -0,0 +1,347 @@
+/**
+ * @file bench.c
+ * @brief Throughput benchmark of the headless simulation over a sweep of scenarios.
+ *
+ * Runs every combination of the ant counts, food counts, thread counts, topologies and pipeline modes given on the
+ * command line with the same seed and writes one CSV row per scenario: ticks per second, the time per tick of the
+ * parts of a tick (see simulation_timings_t) and the peak resident memory. Every scenario runs in its own process, so
+ * scenarios never share memory or state and one that runs out of memory only fails its own row. The columns never
+ * change order, so results of two commits can be diffed directly.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include <strings.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "main/simulation.h"
+
+// Longest list of values of one swept option
+#define BENCH_MAX_VALUES 16
+#define BENCH_DEFAULT_ANTS "100,1000,10000,100000,1000000"
+#define BENCH_DEFAULT_FOOD "10,100"
+#define BENCH_DEFAULT_TOPOLOGIES "per-ant,groups,shared"
+// Wall-clock seconds every scenario runs for after its warm-up tick
+#define BENCH_DEFAULT_SECONDS 2.0
+#define BENCH_DEFAULT_SEED 1
+// Share of the physical memory a scenario may reserve before its allocations fail
+#define BENCH_MEMORY_SHARE 0.75
+
+/**
+ * @brief A list of values of one swept option.
+ */
+typedef struct {
+  int values[BENCH_MAX_VALUES]; /**< The values */
+  int count;                    /**< Number of values */
+} bench_list_t;
+
+/**
+ * @brief Benchmark options.
+ */
+typedef struct {
+  bench_list_t ants;       /**< Ant counts */
+  bench_list_t food;       /**< Food counts per session */
+  bench_list_t threads;    /**< Thread counts, 0 resolved to one per core */
+  bench_list_t topologies; /**< Network topologies */
+  bench_list_t pipeline;   /**< Pipeline modes, 0 off and 1 on */
+  double seconds;          /**< Wall-clock seconds per scenario */
+  long max_ticks;          /**< Most timed ticks per scenario, 0 for no limit */
+  unsigned int seed;       /**< Random seed of every scenario */
+  double memory_limit_mb;  /**< Address space limit of a scenario in MiB */
+  const char *out_path;    /**< CSV file, or NULL for stdout */
+} bench_options_t;
+
+/**
+ * @brief What a scenario process reports back.
+ */
+typedef struct {
+  double setup_seconds;         /**< Time simulation_init took */
+  double seconds;               /**< Time of the timed ticks */
+  simulation_timings_t timings; /**< Time in the parts of the timed ticks */
+} bench_result_t;
+
+static bool parse_options(int argc, char **argv, bench_options_t *options);
+static bool parse_list(const char *text, bench_list_t *list, bool (*parse)(const char *, int *));
+static bool parse_count(const char *text, int *value);
+static bool parse_topology(const char *text, int *value);
+static bool parse_pipeline(const char *text, int *value);
+static void print_usage(const char *program);
+static void run_scenario(const bench_options_t *bench, const simulation_options_t *options, FILE *csv);
+static void measure(const bench_options_t *bench, const simulation_options_t *options, int fd);
+
+/** @brief Run the benchmark.
+ *
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @return Exit code of the benchmark.
+ */
+int main(int argc, char **argv) {
+  bench_options_t bench;
+  if (!parse_options(argc, argv, &bench)) {
+    return EXIT_FAILURE;
+  }
+
+  FILE *csv = bench.out_path ? fopen(bench.out_path, "w") : stdout;
+  if (!csv) {
+    fprintf(stderr, "Could not open %s\n", bench.out_path);
+    return EXIT_FAILURE;
+  }
+  fprintf(csv, "ants,food,threads,topology,pipeline,status,setup_s,ticks,seconds,ticks_per_second,ant_steps_per_second,"
+               "ants_ms,move_ms,train_ms,world_ms,statistics_ms,peak_rss_mb\n");
+  fflush(csv);
+
+  for (int a = 0; a < bench.ants.count; a++) {
+    for (int f = 0; f < bench.food.count; f++) {
+      for (int t = 0; t < bench.threads.count; t++) {
+        for (int n = 0; n < bench.topologies.count; n++) {
+          for (int p = 0; p < bench.pipeline.count; p++) {
+            const simulation_options_t options = {
+                .headless = true,
+                .seed = bench.seed,
+                .ants = bench.ants.values[a],
+                .food = bench.food.values[f],
+                .topology = bench.topologies.values[n],
+                .groups = ANN_GROUPS,
+                .threads = bench.threads.values[t],
+                .pipeline = bench.pipeline.values[p],
+            };
+            run_scenario(&bench, &options, csv);
+          }
+        }
+      }
+    }
+  }
+
+  if (csv != stdout) {
+    fclose(csv);
+  }
+  return EXIT_SUCCESS;
+}
+
+// Run one scenario in a child process and write its row
+static void run_scenario(const bench_options_t *bench, const simulation_options_t *options, FILE *csv) {
+  fprintf(stderr, "%d ants, %d food, %d threads, %s%s: ", options->ants, options->food, options->threads,
+          simulation_topology_name(options->topology), options->pipeline ? ", pipelined" : "");
+  fflush(NULL);
+
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    exit(EXIT_FAILURE);
+  }
+  const pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    exit(EXIT_FAILURE);
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    measure(bench, options, fds[1]);
+  }
+  close(fds[1]);
+
+  bench_result_t result;
+  const bool reported = read(fds[0], &result, sizeof(result)) == (ssize_t)sizeof(result);
+  close(fds[0]);
+  int status = 0;
+  struct rusage usage = {0};
+  wait4(pid, &status, 0, &usage);
+
+  const char *outcome = "ok";
+  if (WIFSIGNALED(status)) {
+    outcome = "killed";
+  } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !reported) {
+    outcome = "failed";
+  }
+  // ru_maxrss is in KiB on Linux
+  const double peak_rss_mb = usage.ru_maxrss / 1024.0;
+
+  fprintf(csv, "%d,%d,%d,%s,%s,%s", options->ants, options->food, options->threads,
+          simulation_topology_name(options->topology), options->pipeline ? "on" : "off", outcome);
+  if (strcmp(outcome, "ok") == 0) {
+    const simulation_timings_t *timings = &result.timings;
+    const double per_tick = 1e3 / timings->ticks;
+    fprintf(csv, ",%.3f,%ld,%.3f,%.1f,%.0f,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f\n", result.setup_seconds, timings->ticks,
+            result.seconds, timings->ticks / result.seconds, timings->ticks * (double)options->ants / result.seconds,
+            timings->ants * per_tick, timings->move * per_tick, timings->train * per_tick, timings->world * per_tick,
+            timings->statistics * per_tick, peak_rss_mb);
+    fprintf(stderr, "%.1f ticks/s, %.1f MiB\n", timings->ticks / result.seconds, peak_rss_mb);
+  } else {
+    fprintf(csv, ",,,,,,,,,,,%.1f\n", peak_rss_mb);
+    fprintf(stderr, "%s\n", outcome);
+  }
+  fflush(csv);
+}
+
+// Body of a scenario process, reports the result through fd and exits without cleaning up
+static void measure(const bench_options_t *bench, const simulation_options_t *options, int fd) {
+  // The simulation prints its progress, the benchmark only its rows
+  if (!freopen("/dev/null", "w", stdout)) {
+    _exit(EXIT_FAILURE);
+  }
+  const rlim_t limit = (rlim_t)(bench->memory_limit_mb * 1024.0 * 1024.0);
+  setrlimit(RLIMIT_AS, &(struct rlimit){limit, limit});
+
+  bench_result_t result;
+  const double setup_start = monotonic_seconds();
+  simulation_init(options);
+  result.setup_seconds = monotonic_seconds() - setup_start;
+
+  // The first tick touches every network and buffer for the first time, it is not timed
+  simulation_tick(FIXED_DELTA);
+  const simulation_timings_t warm = simulation_get_timings();
+
+  const double start = monotonic_seconds();
+  double session_time = FIXED_DELTA;
+  long ticks = 0;
+  do {
+    simulation_tick(FIXED_DELTA);
+    ticks++;
+    session_time += FIXED_DELTA;
+    if (session_time >= RESET_TIME) {
+      session_time = 0.0;
+      simulation_reset();
+    }
+    result.seconds = monotonic_seconds() - start;
+  } while (result.seconds < bench->seconds && (bench->max_ticks <= 0 || ticks < bench->max_ticks));
+
+  const simulation_timings_t end = simulation_get_timings();
+  result.timings = (simulation_timings_t){
+      .ticks = end.ticks - warm.ticks,
+      .ants = end.ants - warm.ants,
+      .move = end.move - warm.move,
+      .train = end.train - warm.train,
+      .world = end.world - warm.world,
+      .statistics = end.statistics - warm.statistics,
+  };
+  const bool written = write(fd, &result, sizeof(result)) == (ssize_t)sizeof(result);
+  _exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static bool parse_options(int argc, char **argv, bench_options_t *options) {
+  const int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  const double memory_mb = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+  *options = (bench_options_t){
+      .threads = {{1, MAX(1, cores)}, cores > 1 ? 2 : 1},
+      .pipeline = {{0}, 1},
+      .seconds = BENCH_DEFAULT_SECONDS,
+      .seed = BENCH_DEFAULT_SEED,
+      .memory_limit_mb = memory_mb * BENCH_MEMORY_SHARE,
+  };
+  bool valid = parse_list(BENCH_DEFAULT_ANTS, &options->ants, parse_count) &&
+               parse_list(BENCH_DEFAULT_FOOD, &options->food, parse_count) &&
+               parse_list(BENCH_DEFAULT_TOPOLOGIES, &options->topologies, parse_topology);
+
+  for (int i = 1; valid && i < argc; i++) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      print_usage(argv[0]);
+      exit(EXIT_SUCCESS);
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "Missing value for %s\n", arg);
+      print_usage(argv[0]);
+      return false;
+    }
+
+    const char *value = argv[++i];
+    if (strcmp(arg, "--ants") == 0) {
+      valid = parse_list(value, &options->ants, parse_count);
+    } else if (strcmp(arg, "--food") == 0) {
+      valid = parse_list(value, &options->food, parse_count);
+    } else if (strcmp(arg, "--threads") == 0) {
+      valid = parse_list(value, &options->threads, parse_count);
+      for (int t = 0; valid && t < options->threads.count; t++) {
+        options->threads.values[t] = options->threads.values[t] == 0 ? cores : options->threads.values[t];
+      }
+    } else if (strcmp(arg, "--topology") == 0) {
+      valid = parse_list(value, &options->topologies, parse_topology);
+    } else if (strcmp(arg, "--pipeline") == 0) {
+      valid = parse_list(value, &options->pipeline, parse_pipeline);
+    } else if (strcmp(arg, "--seconds") == 0) {
+      options->seconds = atof(value);
+      valid = options->seconds > 0.0;
+    } else if (strcmp(arg, "--ticks") == 0) {
+      options->max_ticks = atol(value);
+      valid = options->max_ticks > 0;
+    } else if (strcmp(arg, "--seed") == 0) {
+      options->seed = (unsigned int)strtoul(value, NULL, 10);
+    } else if (strcmp(arg, "--memory-limit") == 0) {
+      options->memory_limit_mb = atof(value);
+      valid = options->memory_limit_mb > 0.0;
+    } else if (strcmp(arg, "--out") == 0) {
+      options->out_path = value;
+    } else {
+      fprintf(stderr, "Unknown option %s\n", arg);
+      print_usage(argv[0]);
+      return false;
+    }
+
+    if (!valid) {
+      fprintf(stderr, "Invalid value %s for %s\n", value, arg);
+      print_usage(argv[0]);
+    }
+  }
+
+  return valid;
+}
+
+// Comma separated values, each checked by parse
+static bool parse_list(const char *text, bench_list_t *list, bool (*parse)(const char *, int *)) {
+  char buffer[256];
+  if (strlen(text) >= sizeof(buffer)) {
+    return false;
+  }
+  strcpy(buffer, text);
+
+  list->count = 0;
+  for (char *save = NULL, *item = strtok_r(buffer, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+    if (list->count == BENCH_MAX_VALUES || !parse(item, &list->values[list->count])) {
+      return false;
+    }
+    list->count++;
+  }
+  return list->count > 0;
+}
+
+static bool parse_count(const char *text, int *value) {
+  char *end;
+  const long parsed = strtol(text, &end, 10);
+  *value = (int)parsed;
+  return *end == '\0' && parsed >= 0 && parsed <= INT32_MAX;
+}
+
+static bool parse_topology(const char *text, int *value) {
+  for (int t = 0; t < TOPOLOGY_COUNT; t++) {
+    if (strcasecmp(text, simulation_topology_name(t)) == 0) {
+      *value = t;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parse_pipeline(const char *text, int *value) {
+  *value = strcmp(text, "on") == 0;
+  return *value || strcmp(text, "off") == 0;
+}
+
+static void print_usage(const char *program) {
+  printf("Usage: %s [options]\n"
+         "Runs every combination of the listed values headless and writes one CSV row per scenario.\n"
+         "  --ants LIST           Ant counts (default %s)\n"
+         "  --food LIST           Food sources per session (default %s)\n"
+         "  --threads LIST        Thread counts, 0 for one per core (default 1 and one per core)\n"
+         "  --topology LIST       Network topologies (default %s)\n"
+         "  --pipeline LIST       Pipeline modes, off and/or on (default off)\n"
+         "  --seconds SECONDS     Wall-clock time per scenario after a warm-up tick (default %.0f)\n"
+         "  --ticks N             Most timed ticks per scenario (default no limit)\n"
+         "  --seed N              Random seed of every scenario (default %d)\n"
+         "  --memory-limit MIB    Address space per scenario (default %.0f%% of the physical memory)\n"
+         "  --out PATH            CSV file (default stdout)\n"
+         "  --help                Show this help\n",
+         program, BENCH_DEFAULT_ANTS, BENCH_DEFAULT_FOOD, BENCH_DEFAULT_TOPOLOGIES, BENCH_DEFAULT_SECONDS,
+         BENCH_DEFAULT_SEED, BENCH_MEMORY_SHARE * 100.0);
+}
@@ -5,27 +5,57 @@
 
 #include "main/simulation.h"
 
-static ant_logic_t ant_decision(ant_t *ant, double delta_time);
+/**
+ * @brief The rotation of a turn and the angle an ant aims within, for one tick length.
+ */
+typedef struct {
+  double delta_time; /**< Tick length in seconds */
+  double cos;        /**< Cosine of the turn angle */
+  double sin;        /**< Sine of the turn angle */
+  double aim_cos;    /**< Cosine of the angle to a target below which the teacher keeps going straight */
+} turn_t;
+
+// Every tick has the same length, the trigonometry of a turn only runs again when it changes
+static const turn_t *get_turn(double delta_time) {
+  static _Thread_local turn_t turn = {0.0, 1.0, 0.0, -2.0};
+  if (delta_time != turn.delta_time) {
+    const double angle = ANT_TURN_SPEED * delta_time;
+    // Targets at least 3/4 of a turn away are turned to, none are when that is beyond the back of the ant
+    const double aim = 0.75 * angle;
+    turn = (turn_t){delta_time, cos(angle), sin(angle), aim <= M_PI ? cos(aim) : -2.0};
+  }
+  return &turn;
+}
 
-ant_t *ant_create(vector2d_t pos, vector2d_t spawn, Texture2D *texture, double rotation) {
+// Turn to the side of the target when the angle to it is at least the aim of the turn
+static ant_turn_action_t turn_towards(const ant_t *ant, vector2d_t target, double delta_time) {
+  const vector2d_t direction = v2d_normalize(v2d_subtract(target, ant->pos));
+  if (v2d_dot(ant->heading, direction) > get_turn(delta_time)->aim_cos) {
+    return ANT_TURN_NONE;
+  }
+  return v2d_cross(ant->heading, direction) < 0.0 ? ANT_TURN_RIGHT : ANT_TURN_LEFT;
+}
+
+ant_t *ant_create(vector2d_t pos, vector2d_t spawn, double rotation, uint64_t seed) {
   ant_t *ant = (ant_t *)malloc(sizeof(ant_t));
   if (!ant) {
     return NULL;
   }
 
-  ant->texture = texture;
   ant->nearest_food = NULL;
   ant->net = NULL;
+  ant->group = 0;
   ant->pos = pos;
   ant->spawn = spawn;
-  ant->rotation = rotation;
+  ant->heading = v2d_from_angle(rotation);
   ant->has_food = false;
   ant->is_coliding = false;
+  rng_seed(&ant->rng, seed);
 
   return ant;
 }
 
-void ant_update_nearest_food(ant_t *ant) {
+void ant_update_nearest_food(ant_t *ant, const dyn_arr_food_t *food_list) {
   if (!ant) {
     return;
   }
@@ -34,8 +64,8 @@ void ant_update_nearest_food(ant_t *ant) {
 
   circled_t detector_circle = ant_get_detector_circle(ant);
   double nearest_distance = DBL_MAX;
-  for (int i = 0; i < g_food_list.length; i++) {
-    food_t *food = dyn_arr_get(g_food_list, i);
+  for (int i = 0; i < food_list->length; i++) {
+    food_t *food = dyn_arr_get(*food_list, i);
     bool collide = circle_collide_circle(detector_circle, (circled_t){food->pos, food->detection_radius});
     if (!collide) {
       continue;
@@ -81,22 +111,6 @@ ant_logic_t ant_train_update(ant_t *ant, double delta_time) {
   return logic;
 }
 
-void ant_draw(ant_t *ant) {
-  if (!ant) {
-    return;
-  }
-
-  const Vector2 center = {(ant->texture->width * ANT_SCALE) / 2.0f, (ant->texture->height * ANT_SCALE) / 2.0f};
-  const Rectangle source = {0, 0, ant->texture->width, ant->texture->height};
-  const Rectangle dest = {ant->pos.x, ant->pos.y, (ant->texture->width * ANT_SCALE),
-                          (ant->texture->height * ANT_SCALE)};
-  DrawTexturePro(*ant->texture, source, dest, center, ant->rotation * RAD2DEG, WHITE);
-
-  const circled_t detector_circle = ant_get_detector_circle(ant);
-  DrawCircleV(v2d_to_v2(detector_circle.center), detector_circle.radius,
-              ant->has_food ? (Color){0, 255, 0, 128} : (Color){255, 0, 0, 128});
-}
-
 void ant_free(ant_t *ant) {
   if (!ant) {
     return;
@@ -114,19 +128,28 @@ circled_t ant_get_detector_circle(ant_t *ant) {
 
   // Circle center position, accounting for rotation, position at head of the ant
   vector2d_t circle_pos = {
-      ant->pos.x + (ANT_DETECTOR_OFFSET * ANT_SCALE) * cos(ant->rotation),
-      ant->pos.y + (ANT_DETECTOR_OFFSET * ANT_SCALE) * sin(ant->rotation),
+      ant->pos.x + (ANT_DETECTOR_OFFSET * ANT_SCALE) * ant->heading.x,
+      ant->pos.y + (ANT_DETECTOR_OFFSET * ANT_SCALE) * ant->heading.y,
   };
   const circled_t circle = {circle_pos, ANT_DETECTOR_RADIUS * ANT_SCALE};
   return circle;
 }
 
+double ant_get_rotation(const ant_t *ant) { return ant ? v2d_angle(ant->heading) : 0.0; }
+
 void ant_turn(ant_t *ant, ant_turn_action_t turn_action, double delta_time) {
-  if (!ant) {
+  if (!ant || turn_action == ANT_TURN_NONE) {
     return;
   }
 
-  ant->rotation = constrain_angle(ant->rotation + ((double)turn_action - 1.0) * ANT_TURN_SPEED * delta_time);
+  const turn_t *turn = get_turn(delta_time);
+  const double sin_angle = ((double)turn_action - 1.0) * turn->sin;
+  const vector2d_t heading = {
+      turn->cos * ant->heading.x - sin_angle * ant->heading.y,
+      sin_angle * ant->heading.x + turn->cos * ant->heading.y,
+  };
+  // Rounding moves rotated vectors off the unit circle, normalizing keeps the length from drifting over many turns
+  ant->heading = v2d_normalize(heading);
 }
 
 bool ant_step(ant_t *ant, double delta_time) {
@@ -134,8 +157,8 @@ bool ant_step(ant_t *ant, double delta_time) {
     return false;
   }
 
-  ant->pos.x += ANT_SPEED * cos(ant->rotation) * delta_time;
-  ant->pos.y += ANT_SPEED * sin(ant->rotation) * delta_time;
+  ant->pos.x += ANT_SPEED * ant->heading.x * delta_time;
+  ant->pos.y += ANT_SPEED * ant->heading.y * delta_time;
 
   // Wrap around the world
   if (ant->pos.x < 0) {
@@ -153,34 +176,24 @@ bool ant_step(ant_t *ant, double delta_time) {
   return true;
 }
 
-bool ant_gather(ant_t *ant) {
-  if (!ant) {
-    return false;
-  }
-
-  if (!ant->nearest_food || ant->has_food) {
+bool ant_can_gather(const ant_t *ant) {
+  if (!ant || !ant->nearest_food || ant->has_food || ant->nearest_food->amount <= 0) {
     return false;
   }
 
   // Check if the ant has reached the food
-  if (circle_collide_point((circled_t){ant->nearest_food->pos, ant->nearest_food->radius}, ant->pos)) {
-    food_grab(ant->nearest_food);
-    ant->has_food = true;
-    if (ant->nearest_food->amount <= 0) {
-      for (int i = 0; i < g_food_list.length; i++) {
-        if (dyn_arr_get(g_food_list, i) == ant->nearest_food) {
-          dyn_arr_remove(g_food_list, i);
-          break;
-        }
-      }
-
-      food_free(ant->nearest_food);
-    }
+  return circle_collide_point((circled_t){ant->nearest_food->pos, ant->nearest_food->radius}, ant->pos);
+}
 
-    return true;
+bool ant_gather(ant_t *ant) {
+  // Empty food is removed by the caller once no ant points to it anymore
+  if (!ant_can_gather(ant)) {
+    return false;
   }
 
-  return false;
+  food_grab(ant->nearest_food);
+  ant->has_food = true;
+  return true;
 }
 
 bool ant_drop(ant_t *ant) {
@@ -197,54 +210,38 @@ bool ant_drop(ant_t *ant) {
   return false;
 }
 
-// Update the ant's logic and behavior.
-static ant_logic_t ant_decision(ant_t *ant, double delta_time) {
+ant_logic_t ant_decision(ant_t *ant, double delta_time) {
   if (!ant) {
     return (ant_logic_t){ANT_TURN_NONE, ANT_STEP_ACTION};
   }
 
-  const double max_turn = ANT_TURN_SPEED * delta_time;
-  double turn_strength = 0.0;
+  ant_turn_action_t turn_action = ANT_TURN_NONE;
   ant_action_t action = ANT_STEP_ACTION;
 
   // Collect food
   if (ant->has_food) {
     // Move towards the spawn point
-    const vector2d_t direction = v2d_normalize(v2d_subtract(ant->spawn, ant->pos));
-    const double angle_delta = constrain_angle(atan2(direction.y, direction.x) - ant->rotation);
-    turn_strength = fmin(1.0, fabs(angle_delta / max_turn)) * (angle_delta < 0 ? -1.0 : 1.0);
+    turn_action = turn_towards(ant, ant->spawn, delta_time);
 
     if (circle_collide_point((circled_t){ant->spawn, ANT_SPAWN_RADIUS}, ant->pos)) {
       action = ANT_DROP_ACTION;
-      turn_strength = 1.0;
+      turn_action = ANT_TURN_LEFT;
     }
   }
 
   // Gather food
   else if (ant->nearest_food) {
     // Move towards the closest food
-    const vector2d_t direction = v2d_normalize(v2d_subtract(ant->nearest_food->pos, ant->pos));
-    const double angle_delta = constrain_angle(atan2(direction.y, direction.x) - ant->rotation);
-    turn_strength = fmin(1.0, fabs(angle_delta / max_turn)) * (angle_delta < 0 ? -1.0 : 1.0);
+    turn_action = turn_towards(ant, ant->nearest_food->pos, delta_time);
 
     if (circle_collide_point((circled_t){ant->nearest_food->pos, ant->nearest_food->radius}, ant->pos)) {
       action = ANT_GATHER_ACTION;
     }
   }
 
-  else {
-    if (ant->is_coliding) {
-      turn_strength = 1.0;
-    } else {
-      turn_strength = 0.0;
-    }
-  }
-
-  ant_turn_action_t turn_action = ANT_TURN_NONE;
-  if (turn_strength >= 0.75) {
+  else if (ant->is_coliding) {
     turn_action = ANT_TURN_LEFT;
-  } else if (turn_strength <= -0.75) {
-    turn_action = ANT_TURN_RIGHT;
   }
+
   return (ant_logic_t){turn_action, action};
-}
\ No newline at end of file
+}
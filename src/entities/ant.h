@@ -54,12 +54,13 @@ typedef struct {
 typedef struct {
   vector2d_t spawn;      /**< The spawn position of the ant */
   vector2d_t pos;        /**< The current position of the ant */
-  Texture2D *texture;    /**< Pointer to the texture of the ant */
   food_t *nearest_food;  /**< The nearest detected food object (in food list) */
   neural_network_t *net; /**< Pointer to the neural network for the ant's behavior */
-  double rotation;       /**< The current rotation of the ant in radians (-π to π) */
+  int group;             /**< Index of the group of ants sharing the network */
+  vector2d_t heading;    /**< Unit vector the ant faces, the cosine and sine of its rotation */
   bool has_food;         /**< Whether the ant is currently carrying food */
   bool is_coliding;      /**< Whether the ant is currently colliding with something */
+  rng_t rng;             /**< Random number generator of the ant, its own stream of the run seed */
 } ant_t;
 
 typedef dyn_arr_def(ant_t *) dyn_arr_ant_t;
@@ -68,25 +69,20 @@ typedef dyn_arr_def(ant_t *) dyn_arr_ant_t;
  * @brief Create a new ant entity.
  *
  * @param pos The initial position of the ant.
- * @param texture The texture of the ant.
- * @param rotation The rotation of the ant in radians.
+ * @param spawn The spawn position of the ant.
+ * @param rotation The rotation of the ant in radians, turned into its heading.
+ * @param seed The seed of the random number generator of the ant.
  * @return A pointer to the newly created ant entity, or NULL on failure.
  */
-ant_t *ant_create(vector2d_t pos, vector2d_t spawn, Texture2D *texture, double rotation);
-
-/**
- * @brief Draw the ant entity.
- *
- * @param ant The ant entity to draw.
- */
-void ant_draw(ant_t *ant);
+ant_t *ant_create(vector2d_t pos, vector2d_t spawn, double rotation, uint64_t seed);
 
 /**
  * @brief Update the ant's nearest food.
  *
  * @param ant The ant entity to update.
+ * @param food_list The food of the world the ant lives in.
  */
-void ant_update_nearest_food(ant_t *ant);
+void ant_update_nearest_food(ant_t *ant, const dyn_arr_food_t *food_list);
 
 /**
  * @brief Update the ant entity.
@@ -96,6 +92,17 @@ void ant_update_nearest_food(ant_t *ant);
  */
 ant_logic_t ant_train_update(ant_t *ant, double delta_time);
 
+/**
+ * @brief Decide what the ant should do, without changing it.
+ *
+ * This is the teacher behavior the neural networks learn.
+ *
+ * @param ant The ant entity to decide for.
+ * @param delta_time The time since the last update.
+ * @return The logic the ant should run.
+ */
+ant_logic_t ant_decision(ant_t *ant, double delta_time);
+
 /**
  * @brief Run the ant's update logic.
  *
@@ -120,10 +127,18 @@ void ant_free(ant_t *ant);
  */
 circled_t ant_get_detector_circle(ant_t *ant);
 
+/**
+ * @brief Get the rotation of the ant, only drawing needs it as an angle.
+ *
+ * @param ant The ant entity.
+ * @return The rotation in radians (-π to π).
+ */
+double ant_get_rotation(const ant_t *ant);
+
 // Behavior functions
 
 /**
- * @brief Turn the ant.
+ * @brief Turn the ant by a fixed angle of ANT_TURN_SPEED * delta_time, rotating its heading.
  *
  * @param ant The ant entity to move.
  * @param turn_action The action to take for turning.
@@ -141,9 +156,20 @@ void ant_turn(ant_t *ant, ant_turn_action_t turn_action, double delta_time);
  */
 bool ant_step(ant_t *ant, double delta_time);
 
+/**
+ * @brief Check if an ant can gather from its nearest food, without changing anything.
+ *
+ * @param ant The ant entity.
+ *
+ * @return true if the ant carries nothing and has reached food that is not empty.
+ */
+bool ant_can_gather(const ant_t *ant);
+
 /**
  * @brief Gather food.
  *
+ * Food taken to zero stays in the food list, the caller removes it once no ant points to it anymore.
+ *
  * @param ant The ant entity to gather food.
  *
  * @return true if the ant gathered food, false otherwise.
@@ -0,0 +1,65 @@
+#include "entities/command.h"
+
+bool command_gather(command_buffer_t *buffer, ant_t *ant) {
+  if (!buffer || !ant_can_gather(ant)) {
+    return false;
+  }
+
+  dyn_arr_push(*buffer, ((command_t){COMMAND_GATHER, ant, ant->nearest_food}));
+  return true;
+}
+
+void command_remove_food(command_buffer_t *buffer, food_t *food) {
+  if (!buffer || !food) {
+    return;
+  }
+
+  dyn_arr_push(*buffer, ((command_t){COMMAND_REMOVE_FOOD, NULL, food}));
+}
+
+int command_apply(command_buffer_t *buffers, int count, dyn_arr_food_t *food_list) {
+  if (!buffers || !food_list) {
+    return 0;
+  }
+
+  // Removals are only marked here, food taken to zero is marked too, the list is compacted once at the end
+  bool removed = false;
+  for (int b = 0; b < count; b++) {
+    for (int i = 0; i < buffers[b].length; i++) {
+      const command_t *command = &dyn_arr_get(buffers[b], i);
+      switch (command->type) {
+      case COMMAND_GATHER:
+        // The claim of an earlier ant may have emptied the food
+        if (command->food->amount > 0 && !command->ant->has_food) {
+          food_grab(command->food);
+          command->ant->has_food = true;
+        }
+        removed |= command->food->amount <= 0;
+        break;
+      case COMMAND_REMOVE_FOOD:
+        command->food->amount = 0;
+        removed = true;
+        break;
+      }
+    }
+    dyn_arr_clear(buffers[b]);
+  }
+  if (!removed) {
+    return 0;
+  }
+
+  // Keep the order of the remaining food, nearest food lookups depend on it for ties
+  int kept = 0;
+  for (int i = 0; i < food_list->length; i++) {
+    food_t *food = dyn_arr_get(*food_list, i);
+    if (food->amount > 0) {
+      dyn_arr_get(*food_list, kept++) = food;
+    } else {
+      food_free(food);
+    }
+  }
+  const int removed_count = food_list->length - kept;
+  food_list->length = kept;
+
+  return removed_count;
+}
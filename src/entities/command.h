@@ -0,0 +1,70 @@
+/**
+ * @file command.h
+ * @brief Deferred structural changes to the world, recorded while ants update in parallel.
+ *
+ * During the parallel part of a tick ants only read the food list. Taking food and removing empty food are recorded
+ * into one command buffer per worker and applied on one thread at the end of the tick. The buffers are applied in
+ * worker order and every worker handles a contiguous range of ants, so commands run in ant order and the result does
+ * not depend on the number of threads.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include "entities/ant.h"
+
+/**
+ * @brief The kinds of deferred world changes.
+ */
+typedef enum {
+  COMMAND_GATHER,      /**< An ant takes one unit of its nearest food */
+  COMMAND_REMOVE_FOOD, /**< Food leaves the food list and is freed */
+} command_type_t;
+
+/**
+ * @brief One deferred world change.
+ */
+typedef struct {
+  command_type_t type; /**< What to change */
+  ant_t *ant;          /**< The acting ant, NULL for COMMAND_REMOVE_FOOD */
+  food_t *food;        /**< The food that is taken or removed */
+} command_t;
+
+typedef dyn_arr_def(command_t) command_buffer_t;
+
+/**
+ * @brief Record that an ant takes from its nearest food, if it can reach it.
+ *
+ * Several ants may claim the same food in one tick, when there is not enough left the ants applied first win.
+ *
+ * @param buffer The command buffer of the calling worker.
+ * @param ant The gathering ant.
+ * @return true if a command was recorded.
+ */
+bool command_gather(command_buffer_t *buffer, ant_t *ant);
+
+/**
+ * @brief Record that food is removed from the food list.
+ *
+ * @param buffer The command buffer of the calling worker.
+ * @param food The food to remove, freed when the commands are applied.
+ */
+void command_remove_food(command_buffer_t *buffer, food_t *food);
+
+/**
+ * @brief Apply and clear command buffers in order.
+ *
+ * Food emptied by gathering is removed as well. Removed food is freed, so every nearest_food pointer may dangle
+ * afterwards when this returns more than 0.
+ *
+ * @param buffers The command buffers, applied from first to last.
+ * @param count The number of command buffers.
+ * @param food_list The food list to take food from and remove food from.
+ * @return The number of removed food objects.
+ */
+int command_apply(command_buffer_t *buffers, int count, dyn_arr_food_t *food_list);
+
+#endif /* COMMAND_H */
@@ -43,13 +43,6 @@ food_t *food_create(vector2d_t pos, double radius, double detection_radius, int
  */
 void food_update(food_t *food, double delta_time);
 
-/**
- * @brief Draw the food object
- *
- * @param food Pointer to the food object
- */
-void food_draw(food_t *food);
-
 /**
  * @brief Destroy the food object
  *
@@ -0,0 +1,28 @@
+/**
+ * @file headless.c
+ * @brief Entry point of the headless ant simulation, built without raylib.
+ *
+ * Trains as fast as possible like AntMatrix --headless, see --help for all options.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "main/simulation.h"
+
+/** @brief Run the simulation without a window.
+ *
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @return Exit code of the simulation.
+ */
+int main(int argc, char **argv) {
+  simulation_options_t options;
+  if (!simulation_parse_options(argc, argv, &options)) {
+    return EXIT_FAILURE;
+  }
+
+  simulation_init(&options);
+  simulation_run_headless();
+  simulation_cleanup();
+  return EXIT_SUCCESS;
+}
@@ -8,7 +8,7 @@
  * @copyright Copyright (c) 2025
  *
  */
-#include "main/simulation.h"
+#include "render/app.h"
 
 /** @brief Start the simulation.
  *
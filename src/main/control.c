@@ -0,0 +1,170 @@
+#include "main/control.h"
+
+#include <math.h>
+
+/**
+ * @brief State of a simulation thread run by control_run.
+ */
+typedef struct {
+  bool running;            /**< Whether CONTROL_STOP has not been taken yet */
+  bool paused;             /**< Whether ticks only run for CONTROL_STEP */
+  bool auto_reset;         /**< Whether sessions restart every RESET_TIME */
+  double speed;            /**< Multiple of real time, 0 for as fast as possible */
+  long steps;              /**< Ticks still to run while paused */
+  long ticks;              /**< Ticks run so far */
+  double session_time;     /**< Simulated seconds of the current session */
+  double next_tick;        /**< Time the next tick is due at when paced */
+  double status_time;      /**< Time of the last status */
+  long status_ticks;       /**< Ticks since the last status */
+  double ticks_per_second; /**< Ticks per second over the last status interval */
+} control_state_t;
+
+static void run_command(control_state_t *state, const control_command_t *command);
+static void publish_status(control_channel_t *channel, control_state_t *state, double now);
+
+void control_init(control_channel_t *channel) {
+  if (!channel) {
+    return;
+  }
+
+  *channel = (control_channel_t){0};
+  spsc_init(&channel->queue, CONTROL_QUEUE_CAPACITY);
+  triple_buffer_init(&channel->status_buffer);
+}
+
+bool control_send(control_channel_t *channel, control_command_t command) {
+  const int slot = spsc_write_slot(&channel->queue);
+  if (slot < 0) {
+    return false;
+  }
+
+  channel->commands[slot] = command;
+  spsc_push(&channel->queue);
+  return true;
+}
+
+bool control_receive(control_channel_t *channel, control_command_t *command) {
+  const int slot = spsc_read_slot(&channel->queue);
+  if (slot < 0) {
+    return false;
+  }
+
+  *command = channel->commands[slot];
+  spsc_pop(&channel->queue);
+  return true;
+}
+
+void control_publish_status(control_channel_t *channel, const control_status_t *status) {
+  channel->status[triple_buffer_write_slot(&channel->status_buffer)] = *status;
+  triple_buffer_publish(&channel->status_buffer);
+}
+
+const control_status_t *control_status(control_channel_t *channel) {
+  return &channel->status[triple_buffer_acquire(&channel->status_buffer)];
+}
+
+void control_run(control_channel_t *channel) {
+  const double start = monotonic_seconds();
+  control_state_t state = {.running = true, .auto_reset = true, .next_tick = start, .status_time = start};
+
+  while (state.running) {
+    control_command_t command;
+    while (state.running && control_receive(channel, &command)) {
+      run_command(&state, &command);
+    }
+    if (!state.running) {
+      break;
+    }
+
+    // Paced ticks fall behind at most MAX_DELTA, a slow machine runs slower than asked instead of catching up
+    const double now = monotonic_seconds();
+    const bool due = state.speed <= 0.0 || now >= state.next_tick;
+    const bool tick = state.paused ? state.steps > 0 : due;
+    if (tick) {
+      state.steps -= state.paused;
+      simulation_tick(FIXED_DELTA);
+      state.ticks++;
+      state.status_ticks++;
+      state.session_time += FIXED_DELTA;
+      if (state.auto_reset && state.session_time >= RESET_TIME) {
+        state.session_time = 0.0;
+        simulation_reset();
+      }
+      if (state.speed > 0.0) {
+        state.next_tick = fmax(state.next_tick, now - MAX_DELTA) + FIXED_DELTA / state.speed;
+      }
+
+      // Copy the world only once the reader took the last copy
+      if (!simulation_snapshot_pending()) {
+        simulation_publish_snapshot();
+      }
+    }
+
+    if (now - state.status_time >= CONTROL_STATUS_INTERVAL) {
+      publish_status(channel, &state, now);
+    }
+    if (!tick) {
+      const double wait = state.paused ? CONTROL_IDLE_SLEEP : state.next_tick - now;
+      sleep_seconds(fmin(wait, CONTROL_IDLE_SLEEP));
+    }
+  }
+
+  publish_status(channel, &state, monotonic_seconds());
+}
+
+static void run_command(control_state_t *state, const control_command_t *command) {
+  switch (command->type) {
+  case CONTROL_STOP:
+    state->running = false;
+    break;
+  case CONTROL_RESET:
+    state->session_time = 0.0;
+    simulation_reset();
+    // Show the new session even while paused
+    simulation_publish_snapshot();
+    break;
+  case CONTROL_PAUSE:
+    state->paused = command->value != 0.0;
+    state->steps = 0;
+    state->next_tick = monotonic_seconds();
+    break;
+  case CONTROL_STEP:
+    state->steps += (long)command->value;
+    break;
+  case CONTROL_SETTINGS:
+    g_settings = command->settings;
+    break;
+  case CONTROL_SPEED:
+    state->speed = fmax(0.0, command->value);
+    state->next_tick = monotonic_seconds();
+    break;
+  case CONTROL_AUTO_RESET:
+    state->auto_reset = command->value != 0.0;
+    break;
+  case CONTROL_TOPOLOGY:
+    simulation_set_topology((network_topology_t)command->value);
+    break;
+  case CONTROL_SNAPSHOT:
+    simulation_publish_snapshot();
+    break;
+  }
+}
+
+static void publish_status(control_channel_t *channel, control_state_t *state, double now) {
+  const double elapsed = now - state->status_time;
+  if (elapsed > 0.0) {
+    state->ticks_per_second = state->status_ticks / elapsed;
+  }
+  state->status_ticks = 0;
+  state->status_time = now;
+
+  const control_status_t status = {
+      .stats = simulation_get_stats(),
+      .ticks_per_second = state->ticks_per_second,
+      .tick = state->ticks,
+      .paused = state->paused,
+      .training = g_settings.training,
+      .speed = state->speed,
+  };
+  control_publish_status(channel, &status);
+}
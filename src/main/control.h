@@ -0,0 +1,126 @@
+/**
+ * @file control.h
+ * @brief Lock-free control channel between a front end and a simulation running on its own thread.
+ *
+ * The front end sends commands through a single-producer single-consumer queue, the simulation thread runs them
+ * between ticks and publishes its status through a triple buffer. Neither side ever waits for the other, so a
+ * simulation running at full speed reacts within a tick and the front end always sees a status at most
+ * CONTROL_STATUS_INTERVAL old.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include "main/simulation.h"
+#include "util/spsc.h"
+#include "util/triplebuf.h"
+
+// Commands the front end can send before the simulation thread takes them, a power of two
+#define CONTROL_QUEUE_CAPACITY 64
+// Seconds between status publications of the simulation thread
+#define CONTROL_STATUS_INTERVAL 0.01
+// Longest sleep of a paused or paced simulation thread before it looks at the queue again
+#define CONTROL_IDLE_SLEEP 0.001
+
+/**
+ * @brief What a command asks the simulation thread to do.
+ */
+typedef enum {
+  CONTROL_STOP,       /**< Return from control_run */
+  CONTROL_RESET,      /**< Start a new session */
+  CONTROL_PAUSE,      /**< Pause if value is not 0, resume otherwise */
+  CONTROL_STEP,       /**< Run value more ticks, also while paused */
+  CONTROL_SETTINGS,   /**< Replace the training switches with settings */
+  CONTROL_SPEED,      /**< Run value times real time, 0 for as fast as possible */
+  CONTROL_AUTO_RESET, /**< Start a new session every RESET_TIME simulated seconds if value is not 0 */
+  CONTROL_TOPOLOGY,   /**< Replace all networks with ones shared as topology value says */
+  CONTROL_SNAPSHOT,   /**< Publish a snapshot now, even if the reader did not take the last one */
+} control_type_t;
+
+/**
+ * @brief A command for the simulation thread.
+ */
+typedef struct {
+  control_type_t type;            /**< What to do */
+  double value;                   /**< Argument of the command, see control_type_t */
+  simulation_settings_t settings; /**< Training switches of CONTROL_SETTINGS */
+} control_command_t;
+
+/**
+ * @brief What the simulation thread publishes about itself.
+ */
+typedef struct {
+  simulation_stats_t stats; /**< Training statistics */
+  double ticks_per_second;  /**< Ticks per second over the last status interval */
+  long tick;                /**< Ticks control_run has run so far */
+  bool paused;              /**< Whether the simulation is paused */
+  bool training;            /**< Whether the networks are training */
+  double speed;             /**< Multiple of real time the simulation runs at, 0 for as fast as possible */
+} control_status_t;
+
+/**
+ * @brief A command queue and a status buffer, shared by one front end thread and one simulation thread.
+ */
+typedef struct {
+  control_command_t commands[CONTROL_QUEUE_CAPACITY]; /**< Command slots of the queue */
+  spsc_ring_t queue;                                  /**< Front end to simulation thread */
+  control_status_t status[TRIPLE_BUFFER_SLOTS];       /**< Status slots of the status buffer */
+  triple_buffer_t status_buffer;                      /**< Simulation thread to front end */
+} control_channel_t;
+
+/**
+ * @brief Initialize a channel with no commands and an empty status.
+ *
+ * @param channel The channel.
+ */
+void control_init(control_channel_t *channel);
+
+/**
+ * @brief Queue a command, never blocks. Call from the front end thread.
+ *
+ * @param channel The channel.
+ * @param command The command.
+ * @return true on success, false if the queue is full.
+ */
+bool control_send(control_channel_t *channel, control_command_t command);
+
+/**
+ * @brief Take the oldest queued command, never blocks. Call from the simulation thread.
+ *
+ * @param channel The channel.
+ * @param command Output of the command.
+ * @return true if a command was taken, false if the queue is empty.
+ */
+bool control_receive(control_channel_t *channel, control_command_t *command);
+
+/**
+ * @brief Publish a status, never blocks. Call from the simulation thread.
+ *
+ * @param channel The channel.
+ * @param status The status, copied.
+ */
+void control_publish_status(control_channel_t *channel, const control_status_t *status);
+
+/**
+ * @brief Get the newest published status, never blocks. Call from the front end thread.
+ *
+ * @param channel The channel.
+ * @return The status, valid until the next call. It is all zero before the first status is published.
+ */
+const control_status_t *control_status(control_channel_t *channel);
+
+/**
+ * @brief Run the simulation and the commands of the channel until CONTROL_STOP.
+ *
+ * Runs on the simulation thread, starting unpaused at full speed with auto reset. Commands are taken before every
+ * tick, a snapshot is published after every tick the reader took the last one of (see simulation_publish_snapshot)
+ * and the status every CONTROL_STATUS_INTERVAL seconds and once more before returning.
+ *
+ * @param channel The channel.
+ */
+void control_run(control_channel_t *channel);
+
+#endif /* CONTROL_H */
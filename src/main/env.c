@@ -0,0 +1,117 @@
+#include "main/env.h"
+
+#include "main/simulation.h"
+
+// Ticks of a session, as long as the auto reset of the window
+#define ENV_SESSION_TICKS ((long)(RESET_TIME * TICK_RATE))
+
+static void observe_world(env_t *env, int w);
+static void reset_worlds(void *arg, int begin, int end, int worker);
+static void step_worlds(void *arg, int begin, int end, int worker);
+
+env_t *env_create(const env_config_t *config) {
+  if (!config || config->num_worlds <= 0 || config->ants <= 0 || config->food < 0 || config->threads < 0) {
+    return NULL;
+  }
+
+  env_t *env = calloc(1, sizeof(env_t));
+  if (!env) {
+    return NULL;
+  }
+  env->num_worlds = config->num_worlds;
+  env->ants = config->ants;
+  env->num_agents = config->num_worlds * config->ants;
+  env->scatter = config->scatter;
+  env->worlds = calloc(env->num_worlds, sizeof(world_t *));
+  env->observations = malloc((size_t)env->num_agents * ENV_OBSERVATION_SIZE * sizeof(double));
+  env->actions = malloc(env->num_agents * sizeof(ant_logic_t));
+  env->teacher = malloc(env->num_agents * sizeof(ant_logic_t));
+  env->session_reset = calloc(env->num_worlds, sizeof(bool));
+  env->pool = threadpool_create(config->threads);
+  if (!env->worlds || !env->observations || !env->actions || !env->teacher || !env->session_reset || !env->pool) {
+    env_free(env);
+    return NULL;
+  }
+
+  for (int w = 0; w < env->num_worlds; w++) {
+    env->worlds[w] = world_create(config->ants, config->food, config->seed + w);
+    if (!env->worlds[w]) {
+      env_free(env);
+      return NULL;
+    }
+  }
+  for (int a = 0; a < env->num_agents; a++) {
+    env->actions[a] = (ant_logic_t){ANT_TURN_NONE, ANT_STEP_ACTION};
+  }
+
+  return env;
+}
+
+void env_reset(env_t *env) {
+  // Every range holds whole worlds, a world is only ever touched by one thread
+  threadpool_parallel_for(env->pool, env->num_worlds, 1, reset_worlds, env);
+}
+
+void env_step(env_t *env) { threadpool_parallel_for(env->pool, env->num_worlds, 1, step_worlds, env); }
+
+void env_free(env_t *env) {
+  if (!env) {
+    return;
+  }
+
+  for (int w = 0; env->worlds && w < env->num_worlds; w++) {
+    world_free(env->worlds[w]);
+  }
+  threadpool_free(env->pool);
+  free(env->worlds);
+  free(env->observations);
+  free(env->actions);
+  free(env->teacher);
+  free(env->session_reset);
+  free(env);
+}
+
+static void reset_worlds(void *arg, int begin, int end, int worker) {
+  (void)worker;
+  env_t *env = arg;
+
+  for (int w = begin; w < end; w++) {
+    world_reset(env->worlds[w]);
+    env->session_reset[w] = true;
+    observe_world(env, w);
+  }
+}
+
+static void step_worlds(void *arg, int begin, int end, int worker) {
+  (void)worker;
+  env_t *env = arg;
+
+  for (int w = begin; w < end; w++) {
+    world_t *world = env->worlds[w];
+    const ant_logic_t *actions = &env->actions[w * env->ants];
+    for (int i = 0; i < env->ants; i++) {
+      world_act(dyn_arr_get(world->ants, i), actions[i], FIXED_DELTA, &world->commands);
+    }
+    world_finish_tick(world, &world->commands, 1);
+
+    env->session_reset[w] = world->session_ticks >= ENV_SESSION_TICKS;
+    if (env->session_reset[w]) {
+      world_reset(world);
+    }
+    observe_world(env, w);
+  }
+}
+
+// Write the observations and teacher actions of every ant of a world
+static void observe_world(env_t *env, int w) {
+  world_t *world = env->worlds[w];
+  for (int i = 0; i < env->ants; i++) {
+    const int agent = w * env->ants + i;
+    ant_t *ant = dyn_arr_get(world->ants, i);
+    if (env->scatter) {
+      world_scatter(world, ant);
+    }
+    world_observe(world, ant, &env->observations[(size_t)agent * ENV_OBSERVATION_SIZE]);
+    env->teacher[agent] = ant_decision(ant, FIXED_DELTA);
+  }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file env.h
+ * @brief Batched environment stepping many independent worlds in lockstep on a thread pool.
+ *
+ * Every world has its own ants, food and generators, so the worlds decorrelate the samples a learner sees. The
+ * observation, action and teacher buffers are allocated once, the caller reads and writes them in place: fill
+ * actions, call env_step, read the next observations. Agent a is ant a % ants of world a / ants.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef ENV_H
+#define ENV_H
+
+#include "main/world.h"
+#include "util/threadpool.h"
+
+#define ENV_OBSERVATION_SIZE WORLD_OBSERVATION_SIZE
+
+/**
+ * @brief Options of a batched environment.
+ */
+typedef struct {
+  int num_worlds; /**< Number of worlds */
+  int ants;       /**< Ants per world */
+  int food;       /**< Food sources per session of every world */
+  uint64_t seed;  /**< World w is seeded with seed + w */
+  int threads;    /**< Threads stepping the worlds, 0 for one per core */
+  bool scatter;   /**< Scatter the ants of random sessions before every observation, as training does */
+} env_config_t;
+
+/**
+ * @brief A batch of worlds and the buffers shared with the caller.
+ */
+typedef struct {
+  world_t **worlds;     /**< The worlds */
+  int num_worlds;       /**< Number of worlds */
+  int ants;             /**< Ants per world */
+  int num_agents;       /**< Ants over all worlds */
+  bool scatter;         /**< Scatter ants before observing, see env_config_t */
+  double *observations; /**< num_agents rows of ENV_OBSERVATION_SIZE values, written by the environment */
+  ant_logic_t *actions; /**< num_agents actions, written by the caller before every step */
+  ant_logic_t *teacher; /**< num_agents actions the teacher takes for the current observations */
+  bool *session_reset;  /**< num_worlds flags, set for the worlds that started a new session in the last step */
+  threadpool_t *pool;   /**< The threads stepping the worlds */
+} env_t;
+
+/**
+ * @brief Create the worlds and buffers of a batched environment, call env_reset before the first step.
+ *
+ * @param config The options.
+ * @return The environment, or NULL on invalid options or allocation failure.
+ */
+env_t *env_create(const env_config_t *config);
+
+/**
+ * @brief Start a new session in every world and write the first observations.
+ *
+ * @param env The environment.
+ */
+void env_reset(env_t *env);
+
+/**
+ * @brief Apply the actions to every world for one FIXED_DELTA tick and write the next observations.
+ *
+ * Worlds whose session reached RESET_TIME simulated seconds start a new one, their observations are the first of
+ * the new session.
+ *
+ * @param env The environment.
+ */
+void env_step(env_t *env);
+
+/**
+ * @brief Free the worlds, buffers and threads of an environment.
+ *
+ * @param env The environment to free.
+ */
+void env_free(env_t *env);
+
+#endif /* ENV_H */
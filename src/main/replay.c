@@ -0,0 +1,580 @@
+#include "main/replay.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main/simulation.h"
+
+/**
+ * @brief Growable bytes. The sizes are size_t because the events of a large colony outgrow the int sizes of dyn_arr.
+ */
+typedef struct {
+  unsigned char *data; /**< The bytes */
+  size_t length;       /**< Number of bytes used */
+  size_t capacity;     /**< Number of bytes allocated */
+} byte_array_t;
+
+// Actions the prefix code stores in 1, 2 and 3 bits: walking straight on, turning right and turning left
+static const unsigned char short_codes[3] = {ANT_TURN_NONE * 3 + ANT_STEP_ACTION, ANT_TURN_RIGHT * 3 + ANT_STEP_ACTION,
+                                             ANT_TURN_LEFT * 3 + ANT_STEP_ACTION};
+
+struct replay_recorder {
+  FILE *file;
+  int num_ants;
+  int packed_size; // Bytes of the actions of one tick, two ants per byte
+  long ticks;
+
+  // Events of the simulation thread waiting for the writer, each a 4-byte length and the raw event
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t queued;
+  pthread_cond_t drained;
+  byte_array_t pending;
+  bool closing;
+
+  // Only the simulation thread touches the event being built, only the writer the rest
+  byte_array_t event;
+  byte_array_t encoded;
+  unsigned char *previous;
+  unsigned char *coded;
+  bool failed;
+};
+
+static void *write_events(void *arg);
+static void encode_events(replay_recorder_t *recorder, const byte_array_t *batch);
+static void encode_tick(replay_recorder_t *recorder, const unsigned char *packed);
+static int prefix_code(const unsigned char *packed, int num_ants, unsigned char *coded);
+static void queue_event(replay_recorder_t *recorder);
+static bool bytes_init(byte_array_t *bytes);
+static void bytes_reserve(byte_array_t *bytes, size_t count);
+static void bytes_append(byte_array_t *bytes, const void *values, size_t count);
+static void bytes_push(byte_array_t *bytes, unsigned char value);
+static void bytes_free(byte_array_t *bytes);
+static void put_varint(byte_array_t *bytes, uint64_t value);
+static bool get_varint(FILE *file, uint64_t *value);
+static bool read_session(replay_player_t *player);
+static bool read_tick(replay_player_t *player);
+static bool read_run_length_coded(replay_player_t *player);
+static bool read_prefix_coded(replay_player_t *player);
+static void play_tick(replay_player_t *player, bool scattered);
+
+#pragma region recorder
+
+replay_recorder_t *replay_recorder_open(const char *path, const world_t *world, uint64_t seed) {
+  if (!path || !world) {
+    return NULL;
+  }
+
+  replay_recorder_t *recorder = calloc(1, sizeof(replay_recorder_t));
+  if (!recorder) {
+    return NULL;
+  }
+  recorder->num_ants = world->ants.length;
+  recorder->packed_size = (recorder->num_ants + 1) / 2;
+  recorder->previous = calloc(recorder->packed_size, 1);
+  recorder->coded = malloc(recorder->num_ants + 1);
+  recorder->file = fopen(path, "wb");
+  const bool buffers = bytes_init(&recorder->pending) & bytes_init(&recorder->event) & bytes_init(&recorder->encoded);
+  if (!recorder->previous || !recorder->coded || !recorder->file || !buffers) {
+    if (recorder->file) {
+      fclose(recorder->file);
+    }
+    free(recorder->previous);
+    free(recorder->coded);
+    bytes_free(&recorder->pending);
+    bytes_free(&recorder->event);
+    bytes_free(&recorder->encoded);
+    free(recorder);
+    return NULL;
+  }
+
+  byte_array_t *header = &recorder->encoded;
+  bytes_append(header, REPLAY_MAGIC, 4);
+  put_varint(header, REPLAY_VERSION);
+  put_varint(header, (uint64_t)recorder->num_ants);
+  put_varint(header, (uint64_t)world->food_per_session);
+  const double fixed_delta = FIXED_DELTA;
+  bytes_append(header, &seed, sizeof(seed));
+  bytes_append(header, &fixed_delta, sizeof(fixed_delta));
+  recorder->failed = fwrite(header->data, 1, header->length, recorder->file) != header->length;
+  header->length = 0;
+
+  pthread_mutex_init(&recorder->mutex, NULL);
+  pthread_cond_init(&recorder->queued, NULL);
+  pthread_cond_init(&recorder->drained, NULL);
+  if (pthread_create(&recorder->thread, NULL, write_events, recorder) != 0) {
+    fprintf(stderr, "Failed to create the replay writer thread\n");
+    exit(EXIT_FAILURE);
+  }
+  return recorder;
+}
+
+void replay_record_session(replay_recorder_t *recorder, const world_t *world) {
+  byte_array_t *event = &recorder->event;
+  event->length = 0;
+  bytes_push(event, REPLAY_EVENT_SESSION);
+  bytes_push(event, world->random_session);
+  put_varint(event, (uint64_t)world->food.length);
+  for (int i = 0; i < world->food.length; i++) {
+    const food_t *food = dyn_arr_get(world->food, i);
+    const double values[4] = {food->pos.x, food->pos.y, food->radius, food->detection_radius};
+    bytes_append(event, values, sizeof(values));
+    put_varint(event, (uint64_t)food->amount);
+  }
+  queue_event(recorder);
+}
+
+void replay_record_tick(replay_recorder_t *recorder, const world_t *world, const unsigned char *actions,
+                        bool scattered) {
+  byte_array_t *event = &recorder->event;
+  event->length = 0;
+  bytes_push(event, REPLAY_EVENT_TICK);
+  bytes_push(event, scattered ? REPLAY_TICK_SCATTERED : 0);
+  for (int i = 0; i < recorder->num_ants; i += 2) {
+    const unsigned char high = i + 1 < recorder->num_ants ? actions[i + 1] : 0;
+    bytes_push(event, (unsigned char)(actions[i] | high << 4));
+  }
+  queue_event(recorder);
+
+  recorder->ticks++;
+  if (recorder->ticks % REPLAY_CHECK_INTERVAL == 0) {
+    const uint64_t checksum = world_checksum(world);
+    event->length = 0;
+    bytes_push(event, REPLAY_EVENT_CHECKSUM);
+    bytes_append(event, &checksum, sizeof(checksum));
+    queue_event(recorder);
+  }
+}
+
+long replay_recorder_close(replay_recorder_t *recorder) {
+  if (!recorder) {
+    return 0;
+  }
+
+  pthread_mutex_lock(&recorder->mutex);
+  recorder->closing = true;
+  pthread_cond_signal(&recorder->queued);
+  pthread_mutex_unlock(&recorder->mutex);
+  pthread_join(recorder->thread, NULL);
+
+  byte_array_t *end = &recorder->encoded;
+  end->length = 0;
+  bytes_push(end, REPLAY_EVENT_END);
+  put_varint(end, (uint64_t)recorder->ticks);
+  bool failed = recorder->failed || fwrite(end->data, 1, end->length, recorder->file) != end->length;
+  failed |= fclose(recorder->file) != 0;
+  const long ticks = failed ? -1 : recorder->ticks;
+
+  pthread_mutex_destroy(&recorder->mutex);
+  pthread_cond_destroy(&recorder->queued);
+  pthread_cond_destroy(&recorder->drained);
+  bytes_free(&recorder->pending);
+  bytes_free(&recorder->event);
+  bytes_free(&recorder->encoded);
+  free(recorder->previous);
+  free(recorder->coded);
+  free(recorder);
+  return ticks;
+}
+
+// Hand the built event to the writer thread, waiting while it is too far behind
+static void queue_event(replay_recorder_t *recorder) {
+  const uint32_t length = (uint32_t)recorder->event.length;
+  pthread_mutex_lock(&recorder->mutex);
+  while (recorder->pending.length > REPLAY_MAX_PENDING) {
+    pthread_cond_wait(&recorder->drained, &recorder->mutex);
+  }
+  bytes_append(&recorder->pending, &length, sizeof(length));
+  bytes_append(&recorder->pending, recorder->event.data, recorder->event.length);
+  pthread_cond_signal(&recorder->queued);
+  pthread_mutex_unlock(&recorder->mutex);
+}
+
+// Writer thread, swaps the queued events out and encodes them while the simulation queues the next ones
+static void *write_events(void *arg) {
+  replay_recorder_t *recorder = arg;
+  byte_array_t batch;
+  if (!bytes_init(&batch)) {
+    fprintf(stderr, "Failed to allocate memory for the replay\n");
+    exit(EXIT_FAILURE);
+  }
+
+  pthread_mutex_lock(&recorder->mutex);
+  while (true) {
+    while (recorder->pending.length == 0 && !recorder->closing) {
+      pthread_cond_wait(&recorder->queued, &recorder->mutex);
+    }
+    if (recorder->pending.length == 0) {
+      break;
+    }
+    const byte_array_t events = recorder->pending;
+    recorder->pending = batch;
+    batch = events;
+    pthread_cond_broadcast(&recorder->drained);
+    pthread_mutex_unlock(&recorder->mutex);
+
+    encode_events(recorder, &batch);
+    batch.length = 0;
+    pthread_mutex_lock(&recorder->mutex);
+  }
+  pthread_mutex_unlock(&recorder->mutex);
+
+  bytes_free(&batch);
+  return NULL;
+}
+
+static void encode_events(replay_recorder_t *recorder, const byte_array_t *batch) {
+  recorder->encoded.length = 0;
+  for (size_t offset = 0; offset < batch->length;) {
+    uint32_t length;
+    memcpy(&length, batch->data + offset, sizeof(length));
+    const unsigned char *event = batch->data + offset + sizeof(length);
+    offset += sizeof(length) + length;
+
+    if (event[0] == REPLAY_EVENT_TICK) {
+      bytes_append(&recorder->encoded, event, 2);
+      encode_tick(recorder, event + 2);
+    } else {
+      bytes_append(&recorder->encoded, event, length);
+    }
+  }
+
+  const size_t written = fwrite(recorder->encoded.data, 1, recorder->encoded.length, recorder->file);
+  recorder->failed |= written != recorder->encoded.length;
+}
+
+// XOR with the previous tick and store pairs of unchanged and changed byte runs, a lone unchanged byte is kept in the
+// changed run. Ticks the prefix code stores in fewer bytes are stored that way
+static void encode_tick(replay_recorder_t *recorder, const unsigned char *packed) {
+  const size_t start = recorder->encoded.length;
+  const int size = recorder->packed_size;
+  unsigned char *previous = recorder->previous;
+  for (int i = 0; i < size; i++) {
+    previous[i] ^= packed[i];
+  }
+
+  int i = 0;
+  do {
+    const int unchanged_start = i;
+    while (i < size && previous[i] == 0) {
+      i++;
+    }
+    const int changed_start = i;
+    while (i < size && (previous[i] != 0 || (i + 1 < size && previous[i + 1] != 0))) {
+      i++;
+    }
+    put_varint(&recorder->encoded, (uint64_t)(changed_start - unchanged_start));
+    put_varint(&recorder->encoded, (uint64_t)(i - changed_start));
+    bytes_append(&recorder->encoded, previous + changed_start, i - changed_start);
+  } while (i < size);
+  memcpy(previous, packed, size);
+
+  // The size of the prefix code takes at most 5 varint bytes
+  const int coded_size = prefix_code(packed, recorder->num_ants, recorder->coded);
+  if ((size_t)coded_size + 5 < recorder->encoded.length - start) {
+    recorder->encoded.length = start;
+    recorder->encoded.data[start - 1] |= REPLAY_TICK_PREFIX_CODED;
+    put_varint(&recorder->encoded, (uint64_t)coded_size);
+    bytes_append(&recorder->encoded, recorder->coded, coded_size);
+  }
+}
+
+// The short codes are 0, 10 and 110, any other action is 111 and its 4 bits, least significant bit first. Returns the
+// number of bytes written, at most num_ants + 1
+static int prefix_code(const unsigned char *packed, int num_ants, unsigned char *coded) {
+  uint64_t bits = 0;
+  int count = 0;
+  int size = 0;
+  for (int i = 0; i < num_ants; i++) {
+    const unsigned char code = packed[i / 2] >> (i % 2 * 4) & 0xF;
+    if (code == short_codes[0]) {
+      count += 1;
+    } else if (code == short_codes[1]) {
+      bits |= 0x1ull << count;
+      count += 2;
+    } else if (code == short_codes[2]) {
+      bits |= 0x3ull << count;
+      count += 3;
+    } else {
+      bits |= (0x7ull | (uint64_t)code << 3) << count;
+      count += 7;
+    }
+    for (; count >= 8; count -= 8) {
+      coded[size++] = (unsigned char)bits;
+      bits >>= 8;
+    }
+  }
+  if (count > 0) {
+    coded[size++] = (unsigned char)bits;
+  }
+  return size;
+}
+
+#pragma endregion
+
+#pragma region player
+
+replay_player_t *replay_player_open(const char *path) {
+  FILE *file = path ? fopen(path, "rb") : NULL;
+  if (!file) {
+    return NULL;
+  }
+
+  char magic[4];
+  uint64_t version = 0;
+  uint64_t num_ants = 0;
+  uint64_t food_per_session = 0;
+  uint64_t seed = 0;
+  double fixed_delta = 0.0;
+  const bool valid = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                     memcmp(magic, REPLAY_MAGIC, sizeof(magic)) == 0 && get_varint(file, &version) &&
+                     version == REPLAY_VERSION && get_varint(file, &num_ants) && num_ants <= INT32_MAX &&
+                     get_varint(file, &food_per_session) && food_per_session <= INT32_MAX &&
+                     fread(&seed, sizeof(seed), 1, file) == 1 && fread(&fixed_delta, sizeof(fixed_delta), 1, file) == 1;
+  replay_player_t *player = valid ? calloc(1, sizeof(replay_player_t)) : NULL;
+  if (!player) {
+    fclose(file);
+    return NULL;
+  }
+
+  player->file = file;
+  player->fixed_delta = fixed_delta;
+  player->diverged_tick = -1;
+  player->world = world_create((int)num_ants, (int)food_per_session, seed);
+  player->actions = calloc((num_ants + 1) / 2, 1);
+  player->coded = malloc(num_ants + 1);
+  if (!player->world || !player->actions || !player->coded) {
+    replay_player_close(player);
+    return NULL;
+  }
+  return player;
+}
+
+bool replay_player_step(replay_player_t *player) {
+  while (!player->done) {
+    const int type = getc(player->file);
+    uint64_t value = 0;
+    switch (type) {
+    case REPLAY_EVENT_TICK:
+      if (read_tick(player)) {
+        return true;
+      }
+      player->done = true;
+      break;
+    case REPLAY_EVENT_SESSION:
+      player->done = !read_session(player);
+      break;
+    case REPLAY_EVENT_CHECKSUM:
+      player->done = fread(&value, sizeof(value), 1, player->file) != 1;
+      if (!player->done && player->diverged_tick < 0 && value != world_checksum(player->world)) {
+        player->diverged_tick = player->ticks;
+      }
+      break;
+    case REPLAY_EVENT_END:
+      player->complete = get_varint(player->file, &value) && (long)value == player->ticks;
+      player->done = true;
+      break;
+    default:
+      player->done = true;
+      break;
+    }
+  }
+  return false;
+}
+
+void replay_player_close(replay_player_t *player) {
+  if (!player) {
+    return;
+  }
+  fclose(player->file);
+  world_free(player->world);
+  free(player->actions);
+  free(player->coded);
+  free(player);
+}
+
+static bool read_session(replay_player_t *player) {
+  const int random_session = getc(player->file);
+  uint64_t count = 0;
+  if (random_session == EOF || !get_varint(player->file, &count) || count > INT32_MAX / sizeof(food_t)) {
+    return false;
+  }
+
+  food_t *food = malloc((count + 1) * sizeof(food_t));
+  bool valid = food != NULL;
+  for (uint64_t i = 0; valid && i < count; i++) {
+    double values[4];
+    uint64_t amount = 0;
+    valid = fread(values, sizeof(values), 1, player->file) == 1 && get_varint(player->file, &amount);
+    food[i] = (food_t){{values[0], values[1]}, values[2], values[3], (int)amount};
+  }
+  if (valid) {
+    world_restore_session(player->world, random_session != 0, food, (int)count);
+  }
+  free(food);
+  return valid;
+}
+
+static bool read_tick(replay_player_t *player) {
+  const int flags = getc(player->file);
+  if (flags == EOF) {
+    return false;
+  }
+  const bool valid = flags & REPLAY_TICK_PREFIX_CODED ? read_prefix_coded(player) : read_run_length_coded(player);
+  if (valid) {
+    play_tick(player, flags & REPLAY_TICK_SCATTERED);
+  }
+  return valid;
+}
+
+// Undo the run-length coding and the XOR with the previous tick
+static bool read_run_length_coded(replay_player_t *player) {
+  const int size = (player->world->ants.length + 1) / 2;
+  unsigned char literal[256];
+  int i = 0;
+  do {
+    uint64_t unchanged = 0;
+    uint64_t changed = 0;
+    if (!get_varint(player->file, &unchanged) || !get_varint(player->file, &changed) ||
+        unchanged + changed > (uint64_t)(size - i)) {
+      return false;
+    }
+    i += (int)unchanged;
+    for (int end = i + (int)changed; i < end;) {
+      const int chunk = MIN(end - i, (int)sizeof(literal));
+      if (fread(literal, 1, chunk, player->file) != (size_t)chunk) {
+        return false;
+      }
+      for (int j = 0; j < chunk; j++, i++) {
+        player->actions[i] ^= literal[j];
+      }
+    }
+  } while (i < size);
+  return true;
+}
+
+// Decode the prefix code of prefix_code
+static bool read_prefix_coded(replay_player_t *player) {
+  const int num_ants = player->world->ants.length;
+  uint64_t size = 0;
+  if (!get_varint(player->file, &size) || size > (uint64_t)num_ants + 1 ||
+      fread(player->coded, 1, size, player->file) != size) {
+    return false;
+  }
+
+  const uint64_t total_bits = size * 8;
+  uint64_t bit = 0;
+  memset(player->actions, 0, (num_ants + 1) / 2);
+  for (int i = 0; i < num_ants; i++) {
+    int ones = 0;
+    while (ones < 3 && bit < total_bits && (player->coded[bit / 8] >> bit % 8 & 1)) {
+      ones++;
+      bit++;
+    }
+    unsigned char code = 0;
+    if (ones < 3) {
+      code = short_codes[ones];
+      bit++;
+    } else {
+      for (int b = 0; b < 4; b++, bit++) {
+        code |= (bit < total_bits ? player->coded[bit / 8] >> bit % 8 & 1 : 0) << b;
+      }
+    }
+    if (bit > total_bits) {
+      return false;
+    }
+    player->actions[i / 2] |= code << (i % 2 * 4);
+  }
+  return true;
+}
+
+// The simulation tick without the networks: scatter, find the nearest food, act on the recorded actions
+static void play_tick(replay_player_t *player, bool scattered) {
+  world_t *world = player->world;
+  for (int i = 0; i < world->ants.length; i++) {
+    ant_t *ant = dyn_arr_get(world->ants, i);
+    if (scattered) {
+      world_scatter(world, ant);
+    }
+    ant_update_nearest_food(ant, &world->food);
+    const unsigned char code = player->actions[i / 2] >> (i % 2 * 4) & 0xF;
+    world_act(ant, replay_decode_action(code), player->fixed_delta, &world->commands);
+  }
+  world_finish_tick(world, &world->commands, 1);
+  player->ticks++;
+}
+
+#pragma endregion
+
+static bool bytes_init(byte_array_t *bytes) {
+  bytes->data = malloc(DYN_ARR_INIT_CAPACITY);
+  bytes->length = 0;
+  bytes->capacity = bytes->data ? DYN_ARR_INIT_CAPACITY : 0;
+  return bytes->data != NULL;
+}
+
+// Grow to fit count more bytes, doubling up to the largest object size
+static void bytes_reserve(byte_array_t *bytes, size_t count) {
+  if (count > (size_t)PTRDIFF_MAX - bytes->length) {
+    fprintf(stderr, "Replay event too large\n");
+    exit(EXIT_FAILURE);
+  }
+  const size_t needed = bytes->length + count;
+  if (needed <= bytes->capacity) {
+    return;
+  }
+  size_t capacity = bytes->capacity > 0 ? bytes->capacity : DYN_ARR_INIT_CAPACITY;
+  while (capacity < needed) {
+    capacity = capacity > (size_t)PTRDIFF_MAX / 2 ? needed : capacity * 2;
+  }
+  unsigned char *data = realloc(bytes->data, capacity);
+  if (!data) {
+    fprintf(stderr, "Failed to allocate memory for the replay\n");
+    exit(EXIT_FAILURE);
+  }
+  bytes->data = data;
+  bytes->capacity = capacity;
+}
+
+static void bytes_append(byte_array_t *bytes, const void *values, size_t count) {
+  bytes_reserve(bytes, count);
+  memcpy(bytes->data + bytes->length, values, count);
+  bytes->length += count;
+}
+
+static void bytes_push(byte_array_t *bytes, unsigned char value) {
+  bytes_reserve(bytes, 1);
+  bytes->data[bytes->length++] = value;
+}
+
+static void bytes_free(byte_array_t *bytes) {
+  free(bytes->data);
+  bytes->data = NULL;
+  bytes->length = 0;
+  bytes->capacity = 0;
+}
+
+static void put_varint(byte_array_t *bytes, uint64_t value) {
+  while (value >= 0x80) {
+    bytes_push(bytes, (unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  bytes_push(bytes, (unsigned char)value);
+}
+
+static bool get_varint(FILE *file, uint64_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    const int byte = getc(file);
+    if (byte == EOF) {
+      return false;
+    }
+    *value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file replay.h
+ * @brief Compact replay logs of simulation runs, recorded on a background thread and played back without networks.
+ *
+ * A replay stores what the ants did instead of what they saw: one 4-bit action per ant and tick, the food of every
+ * session and a checksum of the world every REPLAY_CHECK_INTERVAL ticks. Consecutive ticks mostly repeat the same
+ * actions, so a tick is stored as the XOR with the previous one, run-length coded with varints. In random sessions
+ * the scattered ants change their actions all the time, those ticks store the actions in a prefix code instead,
+ * walking straight on takes one bit. Everything else follows from the seed, playback moves the ants with the
+ * recorded actions and never runs a network, so it is as fast as the world update and verifies itself against the
+ * checksums.
+ *
+ * Layout: the header (REPLAY_MAGIC, version, ants, food per session, seed, tick seconds) followed by events, each a
+ * type byte and its payload. Counts are unsigned LEB128 varints, doubles and checksums are stored in host byte order.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+
+#include "main/world.h"
+
+#define REPLAY_MAGIC "AMRP"
+#define REPLAY_VERSION 2
+// Ticks between checksums of the world, playback reports the first tick a replay diverged at
+#define REPLAY_CHECK_INTERVAL 500
+// Bytes of events the simulation may queue for the writer thread before it waits
+#define REPLAY_MAX_PENDING (16 << 20)
+// Tick flags: the ants were scattered, the actions are prefix coded instead of run-length coded
+#define REPLAY_TICK_SCATTERED 1
+#define REPLAY_TICK_PREFIX_CODED 2
+
+/**
+ * @brief Events of a replay log.
+ */
+typedef enum {
+  REPLAY_EVENT_TICK = 1, /**< Flags (REPLAY_TICK_*) and the coded actions */
+  REPLAY_EVENT_SESSION,  /**< Random session flag, food count and the position, radii and amount of each food */
+  REPLAY_EVENT_CHECKSUM, /**< world_checksum after the previous tick */
+  REPLAY_EVENT_END,      /**< Number of ticks recorded, the log is complete */
+} replay_event_t;
+
+/**
+ * @brief Recorder writing a replay log, opaque.
+ */
+typedef struct replay_recorder replay_recorder_t;
+
+/**
+ * @brief A replay being played back.
+ */
+typedef struct {
+  world_t *world;         /**< The world the replay moves, owned by the player */
+  long ticks;             /**< Ticks played back */
+  long diverged_tick;     /**< First tick whose checksum did not match the recording, -1 if none */
+  bool done;              /**< Whether the end of the replay was reached */
+  bool complete;          /**< Whether the replay ended with an end event instead of being cut off */
+  double fixed_delta;     /**< Simulated seconds of a recorded tick */
+  FILE *file;             /**< The replay log */
+  unsigned char *actions; /**< Packed actions of the last tick, two ants per byte */
+  unsigned char *coded;   /**< Prefix coded actions of a tick being read */
+} replay_player_t;
+
+/**
+ * @brief Encode the decision an ant acted on as a 4-bit action.
+ *
+ * @param logic The decision.
+ * @return The action code, below 9.
+ */
+static inline unsigned char replay_encode_action(ant_logic_t logic) {
+  return (unsigned char)(logic.turn_action * 3 + logic.action);
+}
+
+/**
+ * @brief Decode a 4-bit action.
+ *
+ * @param code The action code from replay_encode_action.
+ * @return The decision.
+ */
+static inline ant_logic_t replay_decode_action(unsigned char code) {
+  return (ant_logic_t){(ant_turn_action_t)(code / 3), (ant_action_t)(code % 3)};
+}
+
+/**
+ * @brief Create a replay log and start its writer thread.
+ *
+ * @param path The file to write.
+ * @param world The recorded world, before its first session.
+ * @param seed The seed the world was created with.
+ * @return The recorder, or NULL if the file could not be created.
+ */
+replay_recorder_t *replay_recorder_open(const char *path, const world_t *world, uint64_t seed);
+
+/**
+ * @brief Record the session the world just started.
+ *
+ * @param recorder The recorder.
+ * @param world The world.
+ */
+void replay_record_session(replay_recorder_t *recorder, const world_t *world);
+
+/**
+ * @brief Record a finished tick, waits only if the writer thread is REPLAY_MAX_PENDING bytes behind.
+ *
+ * @param recorder The recorder.
+ * @param world The world after the tick.
+ * @param actions The action code of every ant, see replay_encode_action.
+ * @param scattered Whether the ants were scattered before observing, as training does.
+ */
+void replay_record_tick(replay_recorder_t *recorder, const world_t *world, const unsigned char *actions,
+                        bool scattered);
+
+/**
+ * @brief Write the remaining events and the end of the log, then free the recorder.
+ *
+ * @param recorder The recorder, may be NULL.
+ * @return The number of ticks recorded, or -1 if writing failed.
+ */
+long replay_recorder_close(replay_recorder_t *recorder);
+
+/**
+ * @brief Open a replay log and create its world.
+ *
+ * @param path The file to read.
+ * @return The player, or NULL if the file could not be read or is no replay.
+ */
+replay_player_t *replay_player_open(const char *path);
+
+/**
+ * @brief Play back the next tick and the sessions and checksums before it.
+ *
+ * @param player The player.
+ * @return true if a tick was played back, false at the end of the replay.
+ */
+bool replay_player_step(replay_player_t *player);
+
+/**
+ * @brief Close the replay log and free the player and its world.
+ *
+ * @param player The player, may be NULL.
+ */
+void replay_player_close(replay_player_t *player);
+
+#endif /* REPLAY_H */
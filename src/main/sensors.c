@@ -0,0 +1,137 @@
+#include "main/sensors.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "main/simulation.h"
+
+// Quantities a batch holds, each in its own array
+#define SENSOR_ARRAYS 11
+// Arrays start on cache lines, 8 doubles
+#define SENSOR_ALIGNMENT 64
+
+// enc of neural/nn.h, inlined so the loops using it vectorize
+static inline double encode(double x) { return 0.5 * (x + 1.0); }
+
+bool sensor_batch_init(sensor_batch_t *batch, int capacity) {
+  if (!batch || capacity <= 0) {
+    return false;
+  }
+  *batch = (sensor_batch_t){0};
+
+  const size_t bytes = (size_t)capacity * sizeof(double);
+  const size_t padded = (bytes + SENSOR_ALIGNMENT - 1) / SENSOR_ALIGNMENT * SENSOR_ALIGNMENT;
+  double *data = aligned_alloc(SENSOR_ALIGNMENT, SENSOR_ARRAYS * padded);
+  if (!data) {
+    return false;
+  }
+
+  double **arrays[SENSOR_ARRAYS] = {
+      &batch->x,      &batch->y,      &batch->heading_x,   &batch->heading_y, &batch->spawn_x, &batch->spawn_y,
+      &batch->food_x, &batch->food_y, &batch->food_radius, &batch->near_food, &batch->has_food,
+  };
+  for (int i = 0; i < SENSOR_ARRAYS; i++) {
+    *arrays[i] = (double *)((char *)data + i * padded);
+  }
+  batch->count = 0;
+  batch->capacity = capacity;
+  return true;
+}
+
+// The only pass over the ants themselves, everything after it reads the arrays
+void sensor_batch_load(sensor_batch_t *batch, const world_t *world, ant_t *const *ants, int count) {
+  batch->count = MIN(count, batch->capacity);
+  for (int i = 0; i < batch->count; i++) {
+    ant_t *ant = ants[i];
+    ant_update_nearest_food(ant, &world->food);
+    const food_t *food = ant->nearest_food;
+
+    batch->x[i] = ant->pos.x;
+    batch->y[i] = ant->pos.y;
+    batch->heading_x[i] = ant->heading.x;
+    batch->heading_y[i] = ant->heading.y;
+    batch->spawn_x[i] = ant->spawn.x;
+    batch->spawn_y[i] = ant->spawn.y;
+    batch->food_x[i] = food ? food->pos.x : 0.0;
+    batch->food_y[i] = food ? food->pos.y : 0.0;
+    batch->food_radius[i] = food ? food->radius : 0.0;
+    batch->near_food[i] = food ? 1.0 : 0.0;
+    batch->has_food[i] = ant->has_food ? 1.0 : 0.0;
+  }
+}
+
+/**
+ * The rows of world_observe for the spawn. Standing on the spawn, the direction falls back to behind the ant.
+ *
+ * The loop has no branches so it vectorizes: conditions become 0 or 1 and pick values by multiplying, and the build
+ * passes -fno-math-errno and -fno-trapping-math so the square root needs no error check. Multiplying by 0 can only
+ * flip the sign of a zero, which encode turns into the same value, so the results are those of world_observe.
+ */
+static void observe_spawn(int n, const double *restrict x, const double *restrict y, const double *restrict heading_x,
+                          const double *restrict heading_y, const double *restrict spawn_x,
+                          const double *restrict spawn_y, double *restrict on_spawn, double *restrict spawn_cos,
+                          double *restrict spawn_sin) {
+  const double radius_sqr = ANT_SPAWN_RADIUS * ANT_SPAWN_RADIUS;
+  for (int i = 0; i < n; i++) {
+    const double dx = spawn_x[i] - x[i];
+    const double dy = spawn_y[i] - y[i];
+    const double distance_sqr = dx * dx + dy * dy;
+    const double distance = sqrt(distance_sqr);
+    const double away = (double)(distance > 1e-9);
+    // Adds 1 only on the spawn, where the quotient is not used, and keeps it finite
+    const double divisor = distance + (1.0 - away);
+    on_spawn[i] = (double)(distance_sqr <= radius_sqr);
+    spawn_cos[i] = encode(away * (dx / divisor) - (1.0 - away) * heading_x[i]);
+    spawn_sin[i] = encode(away * (dy / divisor) - (1.0 - away) * heading_y[i]);
+  }
+}
+
+// The rows of world_observe for the nearest food, computed as for the spawn. Ants without food get 0 by multiplying
+// with near_food, the encoded directions are never negative so this gives +0.0 as world_observe does
+static void observe_food(int n, const double *restrict x, const double *restrict y, const double *restrict heading_x,
+                         const double *restrict heading_y, const double *restrict food_x, const double *restrict food_y,
+                         const double *restrict food_radius, const double *restrict near_food,
+                         double *restrict on_food, double *restrict food_cos, double *restrict food_sin) {
+  for (int i = 0; i < n; i++) {
+    const double dx = food_x[i] - x[i];
+    const double dy = food_y[i] - y[i];
+    const double distance_sqr = dx * dx + dy * dy;
+    const double distance = sqrt(distance_sqr);
+    const double away = (double)(distance > 1e-9);
+    const double divisor = distance + (1.0 - away);
+    on_food[i] = near_food[i] * (double)(distance_sqr <= food_radius[i] * food_radius[i]);
+    food_cos[i] = near_food[i] * encode(away * (dx / divisor) - (1.0 - away) * heading_x[i]);
+    food_sin[i] = near_food[i] * encode(away * (dy / divisor) - (1.0 - away) * heading_y[i]);
+  }
+}
+
+void sensor_batch_observe(const sensor_batch_t *batch, matrix_t *observations) {
+  const int n = batch->count;
+  const size_t row_bytes = (size_t)n * sizeof(double);
+  double *row[WORLD_OBSERVATION_SIZE];
+  for (int f = 0; f < WORLD_OBSERVATION_SIZE; f++) {
+    row[f] = observations->data + (size_t)f * n;
+  }
+  observations->rows = WORLD_OBSERVATION_SIZE;
+  observations->cols = n;
+
+  memcpy(row[0], batch->heading_x, row_bytes);
+  memcpy(row[1], batch->heading_y, row_bytes);
+  observe_spawn(n, batch->x, batch->y, batch->heading_x, batch->heading_y, batch->spawn_x, batch->spawn_y, row[2],
+                row[3], row[4]);
+  observe_food(n, batch->x, batch->y, batch->heading_x, batch->heading_y, batch->food_x, batch->food_y,
+               batch->food_radius, batch->near_food, row[5], row[6], row[7]);
+  memcpy(row[8], batch->near_food, row_bytes);
+  memcpy(row[9], batch->has_food, row_bytes);
+}
+
+void sensor_batch_free(sensor_batch_t *batch) {
+  if (!batch) {
+    return;
+  }
+  // The arrays share the allocation of the first
+  free(batch->x);
+  batch->x = NULL;
+  batch->count = 0;
+  batch->capacity = 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file sensors.h
+ * @brief Batched sensing: the observations of many ants computed together from structure-of-arrays copies.
+ *
+ * Loading a batch finds the nearest food of every ant and copies what its sensors read (position, heading, spawn,
+ * nearest food and load) into one array per quantity, the only pass that follows pointers. Observing then computes
+ * the observations of all ants in one branch-free loop the compiler vectorizes, and writes a feature-major matrix:
+ * row f holds value f of world_observe for every ant, the layout of the input layer of a network running a batch.
+ * The values are bit for bit those of world_observe.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "main/world.h"
+
+/**
+ * @brief What the sensors of a batch of ants read, one array of capacity values per quantity.
+ */
+typedef struct {
+  double *x;           /**< Position x */
+  double *y;           /**< Position y */
+  double *heading_x;   /**< Heading x, cosine of the rotation */
+  double *heading_y;   /**< Heading y, sine of the rotation */
+  double *spawn_x;     /**< Spawn x */
+  double *spawn_y;     /**< Spawn y */
+  double *food_x;      /**< Nearest food x, 0 without food */
+  double *food_y;      /**< Nearest food y, 0 without food */
+  double *food_radius; /**< Nearest food radius, 0 without food */
+  double *near_food;   /**< 1 if the ant detects food, else 0 */
+  double *has_food;    /**< 1 if the ant carries food, else 0 */
+  int count;           /**< Number of loaded ants */
+  int capacity;        /**< Maximum number of ants */
+} sensor_batch_t;
+
+/**
+ * @brief Allocate the arrays of a sensor batch.
+ *
+ * @param batch The batch to initialize.
+ * @param capacity The maximum number of ants per batch.
+ * @return true on success, false on invalid arguments or allocation failure.
+ */
+bool sensor_batch_init(sensor_batch_t *batch, int capacity);
+
+/**
+ * @brief Find the nearest food of ants and copy what they sense into the batch.
+ *
+ * Only touches the given ants, safe to call for different ants in parallel.
+ *
+ * @param batch The batch.
+ * @param world The world of the ants.
+ * @param ants The ants, at most the capacity of the batch.
+ * @param count The number of ants.
+ */
+void sensor_batch_load(sensor_batch_t *batch, const world_t *world, ant_t *const *ants, int count);
+
+/**
+ * @brief Compute the observations of the loaded ants.
+ *
+ * @param batch The loaded batch.
+ * @param observations Output with WORLD_OBSERVATION_SIZE rows and a column per loaded ant.
+ */
+void sensor_batch_observe(const sensor_batch_t *batch, matrix_t *observations);
+
+/**
+ * @brief Free the arrays of a sensor batch.
+ *
+ * @param batch The batch, may be NULL.
+ */
+void sensor_batch_free(sensor_batch_t *batch);
+
+#endif /* SENSORS_H */
@@ -1,32 +1,101 @@
 #include "main/simulation.h"
 
-#include <pthread.h>
-#include <stdatomic.h>
+#include <math.h>
+#include <strings.h>
 #include <time.h>
 
-#include "raymath.h"
-#include "util/gui.h"
+#include "entities/command.h"
+#include "main/replay.h"
+#include "main/sensors.h"
+#include "main/trainer.h"
+#include "neural/autotune.h"
+#include "neural/dataset.h"
+#include "neural/fedavg.h"
+#include "neural/sparse.h"
+#include "util/threadpool.h"
+#include "util/triplebuf.h"
+
+/**
+ * @brief Results of one worker for one tick, aligned so workers never write the same cache line.
+ */
+typedef struct {
+  _Alignas(64) int agreed; /**< Decisions matching the teacher */
+  int skipped;             /**< Samples active training skipped */
+  int trained;             /**< Samples trained on */
+  int frozen_delta;        /**< Change of the number of frozen networks */
+  int dropped;             /**< Pipelined samples of networks frozen since, neither graded nor trained on */
+  double move_seconds;     /**< Time the worker spent in pipelined sense, label and act stages */
+  double train_seconds;    /**< Time the worker spent in pipelined train stages */
+} tick_partial_t;
+
+/**
+ * @brief What the sense, label and act stages of one ant leave for its train stage.
+ */
+typedef struct {
+  double inputs[ANN_INPUTS]; /**< Observation of the ant */
+  double pred[ANN_OUTPUTS];  /**< Prediction of the network if it was frozen and drove the ant */
+  ant_logic_t logic;         /**< Decision of the teacher */
+  bool frozen;               /**< Whether the network was frozen and drove the ant */
+} ant_sample_t;
+
+/**
+ * @brief One pipelined tick: the movement of this tick and the training on the samples of the previous one.
+ */
+typedef struct {
+  double fixed_delta;                /**< Simulated seconds of the tick */
+  ant_sample_t *move_samples;        /**< Samples the movement stage writes, NULL to skip it */
+  const ant_sample_t *train_samples; /**< Samples the train stage learns from, NULL to skip it */
+  int slots;                         /**< Number of stage slots, one per worker */
+  int movers;                        /**< Slots running the movement stage, the others train */
+} pipeline_job_t;
 
 #pragma region function_declarations
 
-static void input(void);
-static void update(void);
-static void fixed_update(double fixed_delta);
-static void render(void);
-static void initialize(void);
-static void resize_window(int w, int h);
-static void render_present(void);
-
-static void *training_thread_func(void *arg);
-static void reset_simulation(void);
-static void train_ants(double fixed_delta);
+static void print_usage(const char *program);
+static void log_stats(void);
+
+static void tick_networks(void *arg, int begin, int end, int worker);
+static void tick_ant(int index, const matrix_t *observations, int column, double fixed_delta, int worker);
+static void drive_ants(const trainer_t *trainer, int first, const matrix_t *observations, double fixed_delta,
+                       int worker);
+static void tick_pipelined(double fixed_delta);
+static void train_pending_samples(void);
+static void run_pipeline(const pipeline_job_t *job);
+static void pipeline_slots(void *arg, int begin, int end, int worker);
+static void move_networks(const pipeline_job_t *job, int begin, int end, int worker);
+static void train_networks(const pipeline_job_t *job, int begin, int end, int worker);
+static void balance_pipeline(const pipeline_job_t *job, double move_seconds, double train_seconds);
+static void record_times(double start, double updated, double finished);
+static void record_stage_times(double *move_seconds, double *train_seconds);
+static matrix_t sense_ants(int first, int count, int worker);
+static void copy_column(const matrix_t *matrix, int column, double *values);
+static void label_ant(ant_t *ant, ant_sample_t *sample, double fixed_delta);
+static void act_ant(int index, const ant_sample_t *sample, const double *pred, double fixed_delta, int worker);
+static void record_tick(void);
+static void train_ant(int index, const ant_sample_t *sample, const double *pred, int worker);
+static int train_iterations(const ant_sample_t *sample);
+static void finish_training_tick(int samples);
 static neural_network_t *create_ant_net();
+static void free_trainers(void);
+static int topology_batch_size(network_topology_t topology_type, int members);
+static void tune_kernels(const neural_network_t *network);
 static void network_train_step(ant_t *ant, const double *inputs, const double *outputs);
+static ant_logic_t decode_logic(const double *pred);
+static void update_agreement(int agreed, int total);
+static void average_networks(void);
+static double sample_loss(const double *pred, const double *outputs);
+static double decision_margin(const double *pred, ant_logic_t logic);
+static void store_eval_sample(int index, const double *inputs, const double *outputs);
+static void advance_eval_samples(int count);
+static void free_snapshots(void);
+static double mean_learning_rate(void);
+static double mean_loss(void);
+static double evaluate_agreement(neural_network_t *network, sparse_network_t *sparse, int begin, int end);
+static double time_inference(neural_network_t *network, sparse_network_t *sparse, int begin, int end);
+static int eval_index(int i);
 
 #pragma endregion
 
-typedef enum { SINGLE_THREAD, MULTI_THREAD, ENDING_THREAD } simulation_mode_t;
-
 #pragma region setup
 
 /**
@@ -50,652 +119,1317 @@ typedef enum { SINGLE_THREAD, MULTI_THREAD, ENDING_THREAD } simulation_mode_t;
  * 4: gather
  * 5: drop
  */
-neural_network_t *ant_network = NULL;
-double learning_rate = LEARN_RATE;
-bool training = true;
-bool reset = false;
-bool auto_reset = true;
-bool warp = false;
-bool random_session = false;
-
-double tick_speed = 1.0;
-double frame_time_avg = 0.03333333333;
-
-dyn_arr_dbl_t input_list;
-dyn_arr_dbl_t output_list;
-
-ant_t *ant_data = NULL;
-dyn_arr_ant_t g_ant_list;
-dyn_arr_food_t g_food_list;
-
-int epoch = 0;
-const int starting_ants = 100;
-const int starting_food = 10;
-const int max_starting_food_amount = 200;
-const int min_starting_food_amount = 50;
-const double food_radius = 40;
-const double food_detection_radius = 300;
-const double min_food_distance = 400;
-const vector2d_t spawn = {WORLD_W / 2, WORLD_H / 2};
-
-int window_w = 1920;
-int window_h = 1080;
-float zoom = 1.0f;
-Vector2 target = {WORLD_W / 2.0f, WORLD_H / 2.0f};
-Vector2 prev_mouse_pos = {0, 0};
-RenderTexture2D offscreen;
-Texture2D ant_texture;
-Rectangle letterbox = {0, 0, SCREEN_W, SCREEN_H};
-
-pthread_t training_thread = {0};
-atomic_bool run_training_thread = false;
-atomic_bool training_thread_done = false;
-simulation_mode_t simulation_mode = SINGLE_THREAD;
+simulation_settings_t g_settings = {
+    .training = true,
+    .model_averaging = FEDAVG_ENABLED,
+    .auto_freeze = AUTO_FREEZE_ENABLED,
+    .active_training = ACTIVE_TRAINING_ENABLED,
+    .verbose = false,
+};
+
+// The world the ants live in, sessions and food placement draw from its generator and every ant from its own
+static world_t *world = NULL;
+
+// Debug output draws from its own generator so printing never changes a run
+static rng_t sample_rng;
+
+static long training_ticks = 0;
+static double teacher_agreement = 0.0;
+static long agreement_ticks = -1;
+
+// One trainer per network, ant->group indexes them
+static network_topology_t topology = ANN_TOPOLOGY;
+static int network_groups = ANN_GROUPS;
+static trainer_t *trainers = NULL;
+static int num_networks = 0;
+// The networks model averaging mixes, one slot per trainer
+static neural_network_t **averaged_networks = NULL;
+static int frozen_networks = 0;
+
+// Samples active training skipped and trained on, and the smoothed share of skipped samples
+static long skipped_samples = 0;
+static long trained_samples = 0;
+static double skip_rate = 0.0;
+
+// Teacher samples for the pruning report, oldest first once the buffer is full
+static double eval_inputs[PRUNE_EVAL_SAMPLES][ANN_INPUTS];
+static double eval_outputs[PRUNE_EVAL_SAMPLES][ANN_OUTPUTS];
+static int eval_count = 0;
+static int eval_next = 0;
+static long eval_seen = 0;
+
+// Ants are updated in parallel by network, every worker records its changes to the food in its own command buffer
+static threadpool_t *pool = NULL;
+static tick_partial_t *tick_partials = NULL;
+static command_buffer_t *commands = NULL;
+// Sensor batches of the workers and their observations, ANN_INPUTS x SENSE_BATCH values per worker
+static sensor_batch_t *sensor_batches = NULL;
+static double *sensed_observations = NULL;
+
+// Pipelined ticks (--pipeline) train on the samples of the previous tick while the ants move, see simulation_tick.
+// The stages never share a network: movement only runs the networks frozen at the start of the tick, training only the
+// others
+static ant_sample_t *pipeline_samples[2] = {NULL, NULL};
+static int pipeline_next = 0;
+static bool pipeline_pending = false;
+static bool *pipeline_frozen = NULL;
+static int pipeline_movers = 1;
+static double move_work = 0.0;
+static double train_work = 0.0;
+
+// Replay the run is recorded to (--record) with the action of every ant this tick, or the replay played back instead
+// of simulating (--replay)
+static replay_recorder_t *recorder = NULL;
+static unsigned char *tick_actions = NULL;
+static replay_player_t *player = NULL;
+
+// Saved network every network starts from (--model-in), or NULL for random ones
+static neural_network_t *initial_network = NULL;
+
+// Teacher samples streamed to a file (--dataset), every worker adds the samples it trains on as its own producer
+static dataset_writer_t *dataset = NULL;
+
+// Time spent in the parts of the ticks, for benchmarks
+static simulation_timings_t timings = {0};
+
+// Snapshots of the world for the render thread, the simulation fills one while the reader draws another
+static world_snapshot_t snapshots[TRIPLE_BUFFER_SLOTS];
+static triple_buffer_t snapshot_buffer;
+
+static simulation_options_t options = {0};
+static FILE *log_file = NULL;
+static double log_start_time = 0.0;
 
 #pragma endregion
 
-int start(int argc, char **argv) {
-  initialize();
-
-  while (!WindowShouldClose()) {
-    if (IsWindowResized()) {
-      resize_window(GetScreenWidth(), GetScreenHeight());
+// Write the requested outputs and free everything the simulation (not the window) owns
+void simulation_cleanup(void) {
+  if (pool) {
+    train_pending_samples();
+  }
+  if (options.model_out && num_networks > 0) {
+    if (neural_write(trainers[0].net, options.model_out)) {
+      printf("Wrote the network of the first ant to %s\n", options.model_out);
+    }
+  }
+  if (log_file) {
+    fclose(log_file);
+    log_file = NULL;
+  }
+  if (dataset) {
+    long dropped = 0;
+    const long samples = dataset_writer_close(dataset, &dropped);
+    if (samples >= 0) {
+      printf("Wrote %ld teacher samples to %s, dropped %ld\n", samples, options.dataset_path, dropped);
+    } else {
+      fprintf(stderr, "Failed to write the dataset %s\n", options.dataset_path);
     }
+    dataset = NULL;
+  }
+  if (recorder) {
+    const long recorded = replay_recorder_close(recorder);
+    if (recorded >= 0) {
+      printf("Recorded %ld ticks to %s\n", recorded, options.record_path);
+    } else {
+      fprintf(stderr, "Failed to write the replay %s\n", options.record_path);
+    }
+    recorder = NULL;
+  }
+  free(tick_actions);
+  tick_actions = NULL;
+  neural_free(initial_network);
+  initial_network = NULL;
+  if (player) {
+    if (player->diverged_tick >= 0) {
+      printf("Replay diverged from the recording by tick %ld\n", player->diverged_tick);
+    } else {
+      printf("Played back %ld ticks matching the recording%s\n", player->ticks,
+             player->done && !player->complete ? ", the replay was cut off" : "");
+    }
+    // The world belongs to the player
+    replay_player_close(player);
+    player = NULL;
+    world = NULL;
+  }
 
-    input();
-    update();
-    render();
-    render_present();
+  free_trainers();
+  free_snapshots();
+  for (int i = 0; commands && i < threadpool_size(pool); i++) {
+    dyn_arr_free(commands[i]);
+  }
+  free(commands);
+  commands = NULL;
+  for (int i = 0; sensor_batches && i < threadpool_size(pool); i++) {
+    sensor_batch_free(&sensor_batches[i]);
   }
+  free(sensor_batches);
+  sensor_batches = NULL;
+  free(sensed_observations);
+  sensed_observations = NULL;
+  free(tick_partials);
+  free(pipeline_samples[0]);
+  free(pipeline_samples[1]);
+  pipeline_samples[0] = pipeline_samples[1] = NULL;
+  threadpool_free(pool);
+  pool = NULL;
+  world_free(world);
+  world = NULL;
+  if (skipped_samples + trained_samples > 0) {
+    printf("Active training skipped %ld of %ld samples (%.1f%%)\n", skipped_samples,
+           skipped_samples + trained_samples, 100.0 * skipped_samples / (skipped_samples + trained_samples));
+  }
+}
 
-  if (simulation_mode == MULTI_THREAD || simulation_mode == ENDING_THREAD) {
-    atomic_store(&run_training_thread, false);
-    pthread_join(training_thread, NULL);
+void simulation_init(const simulation_options_t *simulation_options) {
+  options = *simulation_options;
+  timings = (simulation_timings_t){0};
+  topology = options.topology;
+  network_groups = options.groups;
+  g_settings.model_averaging |= options.model_averaging;
+
+  triple_buffer_init(&snapshot_buffer);
+  for (int i = 0; i < TRIPLE_BUFFER_SLOTS; i++) {
+    dyn_arr_init(snapshots[i].ants);
+    dyn_arr_init(snapshots[i].food);
+    snapshots[i].net = NULL;
   }
+  rng_seed_stream(&sample_rng, options.seed, UINT64_MAX);
 
-  UnloadRenderTexture(offscreen);
-  UnloadTexture(ant_texture);
+  if (options.log_path) {
+    log_file = fopen(options.log_path, "w");
+    if (!log_file) {
+      fprintf(stderr, "Could not open log file %s\n", options.log_path);
+      exit(EXIT_FAILURE);
+    }
+    fprintf(log_file, "tick,seconds,ticks_per_second,agreement,frozen_networks,skip_rate,learning_rate\n");
+  }
+  log_start_time = monotonic_seconds();
 
-  if (ant_data) {
-    for (int i = 0; i < g_ant_list.length; i++) {
-      ant_t *ant = dyn_arr_get(g_ant_list, i);
-      if (PER_ANT_NETWORK) {
-        neural_free(ant->net);
-      }
+  if (options.replay_path) {
+    player = replay_player_open(options.replay_path);
+    if (!player) {
+      fprintf(stderr, "Could not read the replay %s\n", options.replay_path);
+      exit(EXIT_FAILURE);
     }
-    free(ant_data);
+    world = player->world;
+    options.ants = world->ants.length;
+  } else {
+    world = world_create(options.ants, options.food, options.seed);
+  }
+  if (!world) {
+    fprintf(stderr, "Failed to create the world\n");
+    exit(EXIT_FAILURE);
   }
-  dyn_arr_free(g_ant_list);
 
-  for (int i = 0; i < g_food_list.length; i++) {
-    food_t *food = dyn_arr_get(g_food_list, i);
-    food_free(food);
+  pool = threadpool_create(options.threads);
+  tick_partials = aligned_alloc(_Alignof(tick_partial_t), threadpool_size(pool) * sizeof(tick_partial_t));
+  commands = calloc(threadpool_size(pool), sizeof(command_buffer_t));
+  if (!pool || !tick_partials || !commands) {
+    fprintf(stderr, "Failed to create the worker threads\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < threadpool_size(pool); i++) {
+    dyn_arr_init(commands[i]);
+  }
+  sensor_batches = calloc(threadpool_size(pool), sizeof(sensor_batch_t));
+  sensed_observations = malloc((size_t)threadpool_size(pool) * ANN_INPUTS * SENSE_BATCH * sizeof(double));
+  bool sensors_ready = sensor_batches && sensed_observations;
+  for (int i = 0; sensors_ready && i < threadpool_size(pool); i++) {
+    sensors_ready = sensor_batch_init(&sensor_batches[i], SENSE_BATCH);
+  }
+  if (!sensors_ready) {
+    fprintf(stderr, "Failed to allocate memory for the sensors\n");
+    exit(EXIT_FAILURE);
   }
-  dyn_arr_free(g_food_list);
-  dyn_arr_free(input_list);
-  dyn_arr_free(output_list);
-  if (ant_network) {
-    neural_free(ant_network);
+  if (options.pipeline) {
+    pipeline_samples[0] = malloc(options.ants * sizeof(ant_sample_t));
+    pipeline_samples[1] = malloc(options.ants * sizeof(ant_sample_t));
+    if (!pipeline_samples[0] || !pipeline_samples[1]) {
+      fprintf(stderr, "Failed to allocate memory for the pipeline\n");
+      exit(EXIT_FAILURE);
+    }
   }
 
-  CloseWindow();
+  // Playback needs no networks, the replay starts the sessions
+  if (player) {
+    printf("Playing back %s with %d ants\n", options.replay_path, world->ants.length);
+    return;
+  }
+  if (options.model_in) {
+    initial_network = neural_read(options.model_in);
+    if (!initial_network) {
+      fprintf(stderr, "Could not read the network %s\n", options.model_in);
+      exit(EXIT_FAILURE);
+    }
+  }
+  simulation_set_topology(topology);
+  tune_kernels(dyn_arr_get(world->ants, 0)->net);
+  if (options.record_path) {
+    recorder = replay_recorder_open(options.record_path, world, options.seed);
+    tick_actions = calloc(options.ants, sizeof(unsigned char));
+    if (!recorder || !tick_actions) {
+      fprintf(stderr, "Could not create the replay %s\n", options.record_path);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (options.dataset_path) {
+    dataset = dataset_writer_open(options.dataset_path, ANN_INPUTS, ANN_OUTPUTS, threadpool_size(pool));
+    if (!dataset) {
+      fprintf(stderr, "Could not create the dataset %s\n", options.dataset_path);
+      exit(EXIT_FAILURE);
+    }
+  }
+  simulation_reset();
+}
 
-  return 0;
+void simulation_tick(double fixed_delta) {
+  if (player) {
+    replay_player_step(player);
+    return;
+  }
+  if (options.pipeline && g_settings.training) {
+    tick_pipelined(fixed_delta);
+    return;
+  }
+  // The samples of the last pipelined tick are not lost when training is switched off
+  train_pending_samples();
+
+  const int num_ants = world->ants.length;
+  const double start = monotonic_seconds();
+
+  // Networks never share ants, so each worker takes whole networks and no network is trained by two threads
+  const int grain = MAX(1, (int)((long)ANTS_PER_THREAD_MIN * num_networks / num_ants));
+  memset(tick_partials, 0, threadpool_size(pool) * sizeof(tick_partial_t));
+  threadpool_parallel_for(pool, num_networks, grain, tick_networks, &fixed_delta);
+  const double updated = monotonic_seconds();
+  world_finish_tick(world, commands, threadpool_size(pool));
+  record_tick();
+  const double finished = monotonic_seconds();
+
+  if (g_settings.training) {
+    finish_training_tick(num_ants);
+  }
+  timings.ticks++;
+  record_times(start, updated, finished);
+}
+
+simulation_timings_t simulation_get_timings(void) { return timings; }
+
+// Add the time of the ant stages, the world and the statistics, which end now
+static void record_times(double start, double updated, double finished) {
+  timings.ants += updated - start;
+  timings.world += finished - updated;
+  timings.statistics += monotonic_seconds() - finished;
 }
 
-static void input() {
-  Vector2 dir = (Vector2){0, 0};
-  Vector2 mouse_delta = (Vector2){0, 0};
-  float zoom_delta = 0;
-  Vector2 mouse_pos = GetMousePosition();
-  mouse_pos.x = Remap(mouse_pos.x - letterbox.x, 0, window_w - 2 * letterbox.x, 0, SCREEN_W);
-  mouse_pos.y = Remap(mouse_pos.y - letterbox.y, 0, window_h - 2 * letterbox.y, 0, SCREEN_H);
-  mouse_pos = Vector2Scale(mouse_pos, WORLD_SCALE / (WORLD_SCALE * zoom));
+// Add and return the time of the slowest worker of each pipeline stage
+static void record_stage_times(double *move_seconds, double *train_seconds) {
+  *move_seconds = 0.0;
+  *train_seconds = 0.0;
+  for (int i = 0; i < threadpool_size(pool); i++) {
+    *move_seconds = fmax(*move_seconds, tick_partials[i].move_seconds);
+    *train_seconds = fmax(*train_seconds, tick_partials[i].train_seconds);
+  }
+  timings.move += *move_seconds;
+  timings.train += *train_seconds;
+}
 
-  if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
-    mouse_delta = Vector2Subtract(prev_mouse_pos, mouse_pos);
+// Sum the results of the workers and update the training statistics after the samples of a tick were trained on
+static void finish_training_tick(int samples) {
+  int agreed = 0;
+  int skipped = 0;
+  int trained = 0;
+  int frozen_delta = 0;
+  int dropped = 0;
+  for (int i = 0; i < threadpool_size(pool); i++) {
+    agreed += tick_partials[i].agreed;
+    skipped += tick_partials[i].skipped;
+    trained += tick_partials[i].trained;
+    frozen_delta += tick_partials[i].frozen_delta;
+    dropped += tick_partials[i].dropped;
   }
 
-  if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) {
-    dir.x -= 1;
+  advance_eval_samples(samples);
+  frozen_networks += frozen_delta;
+  if (frozen_delta != 0 && g_settings.auto_freeze && frozen_networks == num_networks) {
+    printf("All %d networks converged after %ld training ticks, training paused\n", num_networks, training_ticks);
   }
-  if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) {
-    dir.x += 1;
+
+  training_ticks++;
+  if (samples > dropped) {
+    update_agreement(agreed, samples - dropped);
   }
-  if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) {
-    dir.y -= 1;
+  skipped_samples += skipped;
+  trained_samples += trained;
+  if (skipped + trained > 0) {
+    skip_rate += AGREEMENT_SMOOTHING * ((double)skipped / (skipped + trained) - skip_rate);
   }
-  if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) {
-    dir.y += 1;
+  if (log_file && training_ticks % LOG_INTERVAL_TICKS == 0) {
+    log_stats();
   }
+  if (num_networks > 1 && g_settings.model_averaging && training_ticks % FEDAVG_INTERVAL == 0) {
+    average_networks();
+  }
+}
 
-  zoom_delta = GetMouseWheelMove();
-  if (zoom_delta != 0) {
-    Vector2 mouse_world_before_pos =
-        Vector2Add(mouse_pos, Vector2Subtract(target, Vector2Scale((Vector2){SCREEN_W / 2.0f, SCREEN_H / 2.0f},
-                                                                   WORLD_SCALE / (WORLD_SCALE * zoom))));
-
-    zoom += zoom_delta * 0.1f;
-    zoom = fmaxf(1.0f / WORLD_SCALE, fminf(zoom, 2.0f));
-    zoom = roundf(zoom * 100.0f) / 100.0f;
+// The ants of each network are sensed in batches of SENSE_BATCH, then decide, act and learn one by one in order
+static void tick_networks(void *arg, int begin, int end, int worker) {
+  const double fixed_delta = *(const double *)arg;
+
+  for (int n = begin; n < end; n++) {
+    const int end_ant = trainers[n].first_member + trainers[n].members;
+    for (int first = trainers[n].first_member; first < end_ant; first += SENSE_BATCH) {
+      const int count = MIN(SENSE_BATCH, end_ant - first);
+      const matrix_t observations = sense_ants(first, count, worker);
+      if (!g_settings.training) {
+        drive_ants(&trainers[n], first, &observations, fixed_delta, worker);
+        continue;
+      }
+      for (int i = 0; i < count; i++) {
+        tick_ant(first + i, &observations, i, fixed_delta, worker);
+      }
+    }
+  }
+}
 
-    Vector2 mouse_after_pos = GetMousePosition();
-    mouse_after_pos.x = Remap(mouse_after_pos.x - letterbox.x, 0, window_w - 2 * letterbox.x, 0, SCREEN_W);
-    mouse_after_pos.y = Remap(mouse_after_pos.y - letterbox.y, 0, window_h - 2 * letterbox.y, 0, SCREEN_H);
-    mouse_after_pos = Vector2Scale(mouse_after_pos, WORLD_SCALE / (WORLD_SCALE * zoom));
-    const Vector2 mouse_world_after_pos =
-        Vector2Add(mouse_after_pos, Vector2Subtract(target, Vector2Scale((Vector2){SCREEN_W / 2.0f, SCREEN_H / 2.0f},
-                                                                         WORLD_SCALE / (WORLD_SCALE * zoom))));
+// The network drives the sensed ants [first, first + observations->cols) without training, all in one batch
+static void drive_ants(const trainer_t *trainer, int first, const matrix_t *observations, double fixed_delta,
+                       int worker) {
+  const matrix_t preds = neural_run_batch(trainer->net, observations);
+  for (int i = 0; i < observations->cols; i++) {
+    ant_t *ant = dyn_arr_get(world->ants, first + i);
+    double pred[ANN_OUTPUTS];
+    copy_column(&preds, i, pred);
+    const ant_logic_t logic = decode_logic(pred);
+    if (tick_actions) {
+      tick_actions[first + i] = replay_encode_action(logic);
+    }
+    world_act(ant, logic, fixed_delta, &commands[worker]);
+    // Only the thread of the first network prints, as often as all ants together would
+    if (ant->group == 0 && rng_int(&sample_rng, 5000) < num_networks) {
+      double inputs[ANN_INPUTS];
+      copy_column(observations, i, inputs);
+      printf("Inputs: ");
+      for (int j = 0; j < ANN_INPUTS; j++) {
+        printf("%.3f ", inputs[j]);
+      }
+      printf("\nPred: ");
+      for (int j = 0; j < ANN_OUTPUTS; j++) {
+        printf("%.3f ", pred[j]);
+      }
+      printf("\n");
+    }
+  }
 
-    const Vector2 world_delta = Vector2Subtract(mouse_world_before_pos, mouse_world_after_pos);
-    target = Vector2Add(target, world_delta);
+  // The batch leaves net->output alone, the snapshots draw it for the first ant
+  if (first == 0) {
+    double inputs[ANN_INPUTS];
+    copy_column(observations, 0, inputs);
+    const vector_t inputs_vec = {inputs, ANN_INPUTS};
+    neural_run(trainer->net, &inputs_vec);
   }
+}
+
+// Decide, act and learn for one sensed ant, touching only the ant and its network
+static void tick_ant(int index, const matrix_t *observations, int column, double fixed_delta, int worker) {
+  ant_t *ant = dyn_arr_get(world->ants, index);
+  ant_sample_t sample;
+  copy_column(observations, column, sample.inputs);
+
+  // What the network would have done, before it learns from this tick
+  label_ant(ant, &sample, fixed_delta);
+  const vector_t inputs_vec = {sample.inputs, ANN_INPUTS};
+  const double *pred = neural_run(ant->net, &inputs_vec)->data;
+  sample.frozen = g_settings.auto_freeze && trainers[ant->group].convergence.frozen;
+  act_ant(index, &sample, pred, fixed_delta, worker);
+  train_ant(index, &sample, pred, worker);
+}
 
-  target = Vector2Add(target, Vector2Scale(dir, CAM_SPEED * GetFrameTime()));
-  target = Vector2Add(target, mouse_delta);
-  // Clamp target to world bounds with respect to zoom
-  target.x = fmaxf((SCREEN_W / 2.0f) * (WORLD_SCALE / (WORLD_SCALE * zoom)),
-                   fminf(WORLD_W - ((SCREEN_W / 2.0f) * (WORLD_SCALE / (WORLD_SCALE * zoom))), target.x));
-  target.y = fmaxf((SCREEN_H / 2.0f) * (WORLD_SCALE / (WORLD_SCALE * zoom)),
-                   fminf(WORLD_H - ((SCREEN_H / 2.0f) * (WORLD_SCALE / (WORLD_SCALE * zoom))), target.y));
+// Pipelined tick, the ants move on while their networks train on the samples of the previous tick. Training lags
+// movement by one tick, the networks drive nothing during training except frozen ones, which do not train
+static void tick_pipelined(double fixed_delta) {
+  // Networks frozen now drive their ants this tick and are left alone by the train stage, whatever it decides
+  for (int i = 0; i < num_networks; i++) {
+    pipeline_frozen[i] = g_settings.auto_freeze && trainers[i].convergence.frozen;
+  }
 
-  prev_mouse_pos = mouse_pos;
+  const double start = monotonic_seconds();
+  // At least one slot per stage, a single thread runs both in turn
+  const int slots = MAX(2, threadpool_size(pool));
+  const pipeline_job_t job = {
+      .fixed_delta = fixed_delta,
+      .move_samples = pipeline_samples[pipeline_next],
+      .train_samples = pipeline_pending ? pipeline_samples[!pipeline_next] : NULL,
+      .slots = slots,
+      .movers = MIN(pipeline_movers, slots - 1),
+  };
+  run_pipeline(&job);
+  const double updated = monotonic_seconds();
+  world_finish_tick(world, commands, threadpool_size(pool));
+  record_tick();
+  const double finished = monotonic_seconds();
+
+  double move_seconds;
+  double train_seconds;
+  record_stage_times(&move_seconds, &train_seconds);
+  if (job.train_samples) {
+    balance_pipeline(&job, move_seconds, train_seconds);
+    finish_training_tick(world->ants.length);
+  }
+  pipeline_next = !pipeline_next;
+  pipeline_pending = true;
+  timings.ticks++;
+  record_times(start, updated, finished);
 }
 
-static void update() {
-  const double scaled_delta = FIXED_DELTA / tick_speed;
-  static double simulated_time = 0.0;
-  static bool first = false;
-  static double last_time = 0.0;
-  static double simulation_time = 0.0;
+// Train on the samples of the last pipelined tick without moving the ants
+static void train_pending_samples(void) {
+  if (!pipeline_pending) {
+    return;
+  }
+
+  for (int i = 0; i < num_networks; i++) {
+    pipeline_frozen[i] = g_settings.auto_freeze && trainers[i].convergence.frozen;
+  }
+  const pipeline_job_t job = {
+      .train_samples = pipeline_samples[!pipeline_next],
+      .slots = threadpool_size(pool),
+      .movers = 0,
+  };
+  const double start = monotonic_seconds();
+  run_pipeline(&job);
+  const double finished = monotonic_seconds();
+  double move_seconds;
+  double train_seconds;
+  record_stage_times(&move_seconds, &train_seconds);
+  pipeline_pending = false;
+  finish_training_tick(world->ants.length);
+  record_times(start, finished, finished);
+}
 
-  if (reset) {
-    reset = false;
-    if (simulation_mode == SINGLE_THREAD) {
-      first = false;
-      simulation_time = 0.0;
-      simulated_time = 0.0;
+static void run_pipeline(const pipeline_job_t *job) {
+  memset(tick_partials, 0, threadpool_size(pool) * sizeof(tick_partial_t));
+  threadpool_parallel_for(pool, job->slots, 1, pipeline_slots, (void *)job);
+}
 
-      reset_simulation();
+// Each slot runs one stage for a contiguous range of networks, movers in ant order so the food commands are too
+static void pipeline_slots(void *arg, int begin, int end, int worker) {
+  const pipeline_job_t *job = arg;
+  const int trainers_count = job->slots - job->movers;
+
+  for (int slot = begin; slot < end; slot++) {
+    const double start = monotonic_seconds();
+    if (slot < job->movers && job->move_samples) {
+      move_networks(job, (int)((long)slot * num_networks / job->movers),
+                    (int)((long)(slot + 1) * num_networks / job->movers), worker);
+      tick_partials[worker].move_seconds += monotonic_seconds() - start;
+    } else if (slot >= job->movers && job->train_samples) {
+      const int trainer = slot - job->movers;
+      train_networks(job, (int)((long)trainer * num_networks / trainers_count),
+                     (int)((long)(trainer + 1) * num_networks / trainers_count), worker);
+      tick_partials[worker].train_seconds += monotonic_seconds() - start;
     }
   }
+}
 
-  if (!first) {
-    last_time = GetTime();
-    first = true;
+// Sense, label and act stages of the ants of networks [begin, end)
+static void move_networks(const pipeline_job_t *job, int begin, int end, int worker) {
+  for (int n = begin; n < end; n++) {
+    const int end_ant = trainers[n].first_member + trainers[n].members;
+    for (int first = trainers[n].first_member; first < end_ant; first += SENSE_BATCH) {
+      const int count = MIN(SENSE_BATCH, end_ant - first);
+      const matrix_t observations = sense_ants(first, count, worker);
+      // Frozen networks do not change during the tick, they run the whole batch at once
+      const bool frozen = pipeline_frozen[n];
+      const matrix_t preds = frozen ? neural_run_batch(trainers[n].net, &observations) : (matrix_t){NULL, 0, 0};
+
+      for (int i = 0; i < count; i++) {
+        ant_sample_t *sample = &job->move_samples[first + i];
+        copy_column(&observations, i, sample->inputs);
+        label_ant(dyn_arr_get(world->ants, first + i), sample, job->fixed_delta);
+        sample->frozen = frozen;
+        if (frozen) {
+          copy_column(&preds, i, sample->pred);
+        }
+        act_ant(first + i, sample, frozen ? sample->pred : NULL, job->fixed_delta, worker);
+      }
+    }
   }
-  const double current_time = GetTime();
-  const double delta_time = fmin(current_time - last_time, MAX_DELTA);
+}
 
-  last_time = current_time;
-  simulation_time += delta_time;
+// Train stage on the samples of the ants of networks [begin, end)
+static void train_networks(const pipeline_job_t *job, int begin, int end, int worker) {
+  if (begin >= end) {
+    return;
+  }
 
-  if (warp && simulation_mode == SINGLE_THREAD) {
-    if (tick_speed <= 1.1) {
-      tick_speed = WARP_SPEED;
-    } else {
-      // How much faster or slower than 15 FPS the simulation is running
-      const double alpha = 0.1;
-      frame_time_avg = alpha * frame_time_avg + (1 - alpha) * delta_time;
-      const double ratio = fmax(0.99, 1 / (15.0 * frame_time_avg));
-      if (ratio > 2.5) {
-        tick_speed *= 1.0075;
-      } else if (ratio > 1.2) {
-        tick_speed += 0.1;
-      } else if (ratio > 1.0) {
-        tick_speed -= 4;
-      } else if (ratio < 1.0) {
-        tick_speed *= ratio;
+  for (int i = trainers[begin].first_member; i < trainers[end - 1].first_member + trainers[end - 1].members; i++) {
+    ant_t *ant = dyn_arr_get(world->ants, i);
+    const ant_sample_t *sample = &job->train_samples[i];
+    const double *pred = sample->pred;
+    if (!sample->frozen) {
+      // The network froze since the sample was taken and the movement stage runs it now
+      if (pipeline_frozen[ant->group]) {
+        tick_partials[worker].dropped++;
+        continue;
       }
+      const vector_t inputs_vec = {(double *)sample->inputs, ANN_INPUTS};
+      pred = neural_run(ant->net, &inputs_vec)->data;
     }
-  } else {
-    tick_speed = 1.0;
+    train_ant(i, sample, pred, worker);
   }
+}
 
-  while (simulation_time >= scaled_delta) {
-    simulation_time -= scaled_delta;
-    simulated_time += FIXED_DELTA;
+// Move a slot between the stages if the measured work says the tick gets shorter
+static void balance_pipeline(const pipeline_job_t *job, double move_seconds, double train_seconds) {
+  if (job->slots < 3) {
+    return;
+  }
 
-    if (simulation_mode == SINGLE_THREAD) {
-      // Reset simulation every RESET_TIME (scaled by tick speed)
-      if (simulated_time >= RESET_TIME && auto_reset) {
-        reset_simulation();
-        simulated_time = 0.0;
-      }
+  move_work += PIPELINE_SMOOTHING * (move_seconds * job->movers - move_work);
+  train_work += PIPELINE_SMOOTHING * (train_seconds * (job->slots - job->movers) - train_work);
 
-      fixed_update(FIXED_DELTA);
+  double best_time = INFINITY;
+  for (int movers = MAX(1, job->movers - 1); movers <= MIN(job->slots - 1, job->movers + 1); movers++) {
+    const double time = fmax(move_work / movers, train_work / (job->slots - movers));
+    if (time < best_time) {
+      best_time = time;
+      pipeline_movers = movers;
     }
   }
+}
 
-  if (simulation_mode == ENDING_THREAD) {
-    if (atomic_load(&training_thread_done)) {
-      pthread_join(training_thread, NULL);
-      simulation_mode = SINGLE_THREAD;
-      atomic_store(&training_thread_done, false);
+// Sense stage of ants [first, first + count) of one network, scattered to random situations while training. Writes
+// the observations of the worker, one column per ant
+static matrix_t sense_ants(int first, int count, int worker) {
+  ant_t *const *ants = &dyn_arr_get(world->ants, first);
+  if (g_settings.training) {
+    for (int i = 0; i < count; i++) {
+      world_scatter(world, ants[i]);
     }
   }
-}
 
-static void fixed_update(double fixed_delta) { train_ants(fixed_delta); }
+  matrix_t observations = {sensed_observations + (size_t)worker * ANN_INPUTS * SENSE_BATCH, ANN_INPUTS, count};
+  sensor_batch_load(&sensor_batches[worker], world, ants, count);
+  sensor_batch_observe(&sensor_batches[worker], &observations);
+  return observations;
+}
 
-static void render() {
-  Camera2D cam = {0};
-  cam.target = target;
-  cam.offset = (Vector2){SCREEN_W / 2.0f, SCREEN_H / 2.0f};
-  cam.rotation = 0.0f;
-  cam.zoom = zoom;
+// Column of a feature-major matrix, the values of one ant
+static void copy_column(const matrix_t *matrix, int column, double *values) {
+  for (int row = 0; row < matrix->rows; row++) {
+    values[row] = matrix->data[(size_t)row * matrix->cols + column];
+  }
+}
 
-  Vector2 mouse_pos = GetMousePosition();
-  mouse_pos.x = Remap(mouse_pos.x - letterbox.x, 0, window_w - 2 * letterbox.x, 0, SCREEN_W);
-  mouse_pos.y = Remap(mouse_pos.y - letterbox.y, 0, window_h - 2 * letterbox.y, 0, SCREEN_H);
+// Label stage, what the teacher decides
+static void label_ant(ant_t *ant, ant_sample_t *sample, double fixed_delta) {
+  sample->logic = ant_decision(ant, fixed_delta);
+}
 
-  BeginTextureMode(offscreen);
-  BeginMode2D(cam);
-  ClearBackground(BROWN);
+// Act stage, frozen networks drive their ant, the teacher only grades them
+static void act_ant(int index, const ant_sample_t *sample, const double *pred, double fixed_delta, int worker) {
+  const ant_logic_t logic = sample->frozen ? decode_logic(pred) : sample->logic;
+  if (tick_actions) {
+    tick_actions[index] = replay_encode_action(logic);
+  }
+  world_act(dyn_arr_get(world->ants, index), logic, fixed_delta, &commands[worker]);
+}
 
-  if (simulation_mode == SINGLE_THREAD) {
-    DrawCircleV(v2d_to_v2(spawn), ANT_SPAWN_RADIUS, DARKBLUE);
+// Record the actions of the tick that just finished, the ants were scattered if it trained
+static void record_tick(void) {
+  if (recorder) {
+    replay_record_tick(recorder, world, tick_actions, g_settings.training);
+  }
+}
 
-    for (int i = 0; i < g_food_list.length; i++) {
-      food_t *food = dyn_arr_get(g_food_list, i);
-      food_draw(food);
-    }
-    for (int i = 0; i < g_ant_list.length; i++) {
-      ant_t *ant = dyn_arr_get(g_ant_list, i);
-      ant_draw(ant);
-    }
+// Train stage, grade the prediction of the network and learn from the teacher, touching only the network of the ant
+static void train_ant(int index, const ant_sample_t *sample, const double *pred, int worker) {
+  ant_t *ant = dyn_arr_get(world->ants, index);
+  tick_partial_t *partial = &tick_partials[worker];
+  const ant_logic_t logic = sample->logic;
+  const ant_logic_t predicted = decode_logic(pred);
+  convergence_t *ant_monitor = &trainers[ant->group].convergence;
+
+  const bool agree = predicted.turn_action == logic.turn_action && predicted.action == logic.action;
+  partial->agreed += agree;
+
+  double outputs[ANN_OUTPUTS] = {0};
+  outputs[0] = logic.turn_action == ANT_TURN_RIGHT ? 1.0 : 0.0;
+  outputs[1] = logic.turn_action == ANT_TURN_NONE ? 1.0 : 0.0;
+  outputs[2] = logic.turn_action == ANT_TURN_LEFT ? 1.0 : 0.0;
+
+  outputs[3] = logic.action == ANT_STEP_ACTION ? 1.0 : 0.0;
+  outputs[4] = logic.action == ANT_GATHER_ACTION ? 1.0 : 0.0;
+  outputs[5] = logic.action == ANT_DROP_ACTION ? 1.0 : 0.0;
+
+  store_eval_sample(index, sample->inputs, outputs);
+  if (dataset) {
+    dataset_write(dataset, worker, sample->inputs, outputs, train_iterations(sample));
+  }
+  if (convergence_update(ant_monitor, agree, sample_loss(pred, outputs))) {
+    partial->frozen_delta += ant_monitor->frozen ? 1 : -1;
+  }
+  if (sample->frozen) {
+    return;
+  }
 
-    EndMode2D();
-  } else {
-    EndMode2D();
+  // Active training, samples already decided right with a clear margin teach the network almost nothing
+  if (g_settings.active_training && agree && decision_margin(pred, logic) >= ACTIVE_TRAINING_MARGIN) {
+    partial->skipped++;
+    return;
+  }
+  partial->trained++;
 
-    gui_draw_label_centered((Vector2){SCREEN_W / 2, SCREEN_W / 2},
-                            "Running in multi-thread mode, rendering is disabled.");
+  // Train the neural network
+  const int iterations = train_iterations(sample);
+  for (int j = 0; j < iterations; j++) {
+    network_train_step(ant, sample->inputs, outputs);
   }
+}
 
-  DrawFPS(0, 0);
-  if (gui_draw_button(mouse_pos, (Rectangle){10, 20, 300, 20}, "Reset Speed")) {
-    warp = false;
+// Rare decisions are trained on several times, datasets store this as the weight of a sample
+static int train_iterations(const ant_sample_t *sample) {
+  if (sample->logic.action == ANT_DROP_ACTION) {
+    return 30;
+  } else if (sample->logic.action == ANT_GATHER_ACTION) {
+    return 10;
+  } else if (sample->inputs[5] >= 1.0) {
+    return 5;
   }
+  return 1;
+}
 
-  // Button to start runing the simulation from the network
-  if (gui_draw_button(mouse_pos, (Rectangle){SCREEN_W - 350, 10, 300, 20}, "Reset Simulation")) {
-    reset = true;
+void simulation_reset(void) {
+  // Played back sessions start when the recorded ones did
+  if (player) {
+    return;
+  }
+  world_reset(world);
+  if (recorder) {
+    replay_record_session(recorder, world);
   }
+}
 
-  // Checkbox to start runing the simulation from the network
-  // This checkbox is always on in multi-thread mode
-  const bool train_checkbox = gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 40}, "Train", training);
-  if (simulation_mode == SINGLE_THREAD) {
-    training = train_checkbox;
+static neural_network_t *create_ant_net() {
+  const int neuron_counts[] = ANN_NEURON_COUNTS;
+  const neural_activation_t activations[] = ANN_ACTIVATIONS;
+  _Static_assert(sizeof(activations) / sizeof(activations[0]) == sizeof(neuron_counts) / sizeof(int) - 1,
+                 "ANN_ACTIVATIONS needs one entry per layer after the input");
+  neural_network_t *network = neural_create((sizeof(neuron_counts) / sizeof(int)) - 2, neuron_counts, activations);
+  if (!network) {
+    fprintf(stderr, "Failed to create neural network\n");
+    exit(EXIT_FAILURE);
+  }
+  // Randomize weights and biases
+  const double std = sqrt(6) / sqrt(neuron_counts[0] + neuron_counts[network->num_hidden_layers + 1]);
+  neural_randomize_weights(network, &world->rng, -std, std);
+  neural_randomize_bias(network, &world->rng, -0.01, 0.01);
+
+  // A loaded network replaces the random parameters, the random numbers are drawn anyway to keep the world the same
+  if (initial_network) {
+    if (!neural_same_shape(network, initial_network)) {
+      fprintf(stderr, "The network %s does not have the shape of the ant networks\n", options.model_in);
+      exit(EXIT_FAILURE);
+    }
+    const vector_t from = neural_parameters(initial_network);
+    const vector_t to = neural_parameters(network);
+    memcpy(to.data, from.data, to.rows * sizeof(*to.data));
   }
 
-  // Checkbox to enable/disable auto reset
-  auto_reset = gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 65}, "Auto Reset", auto_reset);
+  return network;
+}
 
-  // Checkbox to enable/disable warp
-  warp = gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 90}, "Warp", warp);
+// Replace all networks with fresh ones shared as the topology says, training starts over
+void simulation_set_topology(network_topology_t new_topology) {
+  if (player) {
+    return;
+  }
+  free_trainers();
+
+  const int num_ants = world->ants.length;
+  topology = new_topology;
+  switch (topology) {
+  case TOPOLOGY_SHARED:
+    num_networks = 1;
+    break;
+  case TOPOLOGY_GROUPS:
+    num_networks = MAX(1, MIN(network_groups, num_ants));
+    break;
+  default:
+    num_networks = num_ants;
+    break;
+  }
 
-  Rectangle thread_button_bounds = {SCREEN_W - 350, 115, 300, 20};
-  // Checkbox to do multiple threads
-  if (simulation_mode == SINGLE_THREAD) {
-    if (gui_draw_button(mouse_pos, thread_button_bounds, "Switch to Multi-Thread")) {
-      simulation_mode = MULTI_THREAD;
-      atomic_store(&run_training_thread, true);
-      atomic_store(&training_thread_done, false);
-      training = true;
+  trainers = malloc(num_networks * sizeof(trainer_t));
+  pipeline_frozen = calloc(num_networks, sizeof(bool));
+  averaged_networks = malloc(num_networks * sizeof(neural_network_t *));
+  if (!trainers || !pipeline_frozen || !averaged_networks) {
+    fprintf(stderr, "Failed to allocate memory for trainers\n");
+    exit(EXIT_FAILURE);
+  }
 
-      const int error = pthread_create(&training_thread, NULL, training_thread_func, NULL);
-      if (error != 0) {
-        fprintf(stderr, "Failed to create training thread: %s\n", strerror(error));
-        exit(EXIT_FAILURE);
-      }
-    }
-  } else if (simulation_mode == MULTI_THREAD) {
-    if (gui_draw_button(mouse_pos, thread_button_bounds, "Switch to Single-Thread")) {
-      simulation_mode = ENDING_THREAD;
-      atomic_store(&run_training_thread, false);
+  // Contiguous ranges of ants share a network, ant i is in group i * num_networks / num_ants so group n starts at the
+  // first ant with i * num_networks >= n * num_ants
+  for (int n = 0; n < num_networks; n++) {
+    const int first_member = (int)(((long)n * num_ants + num_networks - 1) / num_networks);
+    const int end_member = (int)(((long)(n + 1) * num_ants + num_networks - 1) / num_networks);
+    const int members = end_member - first_member;
+    const long window = (long)CONVERGENCE_WINDOW_TICKS * members;
+    if (!trainer_init(&trainers[n], create_ant_net(), first_member, members, topology_batch_size(topology, members),
+                      LEARN_RATE, window)) {
+      fprintf(stderr, "Failed to create trainer\n");
+      exit(EXIT_FAILURE);
     }
   }
+  for (int i = 0; i < num_ants; i++) {
+    ant_t *ant = dyn_arr_get(world->ants, i);
+    ant->group = (int)((long)i * num_networks / num_ants);
+    ant->net = trainers[ant->group].net;
+  }
 
-  gui_draw_label((Vector2){10, 45}, TextFormat("Tick Speed: %.0f", tick_speed));
+  // Training statistics restart with the new networks
+  frozen_networks = 0;
+  training_ticks = 0;
+  teacher_agreement = 0.0;
+  agreement_ticks = -1;
+  skip_rate = 0.0;
+
+  printf("Network topology: %s, %d networks, batch size %d\n", simulation_topology_name(topology), num_networks,
+         trainers[0].batch_size);
+}
 
-  if (g_ant_list.length > 0) {
-    ant_t *ant = dyn_arr_get(g_ant_list, 0);
-    gui_draw_neural_network((Vector2){10, 70}, ant->net, !training);
+static void free_trainers() {
+  // Pending pipeline samples belong to the old networks
+  pipeline_pending = false;
+  free(pipeline_frozen);
+  pipeline_frozen = NULL;
+  free(averaged_networks);
+  averaged_networks = NULL;
+  for (int i = 0; i < num_networks; i++) {
+    trainer_free(&trainers[i]);
   }
+  free(trainers);
+  trainers = NULL;
+  num_networks = 0;
+}
 
-  if (training) {
-    const float progress_bar_location_x = SCREEN_W / 2.0f;
-    const float progress_bar_width = 300.0f;
-    const Rectangle progress_bar_bounds = {progress_bar_location_x - progress_bar_width / 2.0f, SCREEN_W / 2.0f + 40,
-                                           progress_bar_width, 20};
-    // Learning rate decays logarithmically, so we need to adjust the progress accordingly
-    float progress = 1.0f - log(learning_rate / LEARN_RATE_MIN) / log(LEARN_RATE / LEARN_RATE_MIN);
-    progress = fmaxf(0.0f, fminf(1.0f, progress));
-    gui_draw_progress_bar(progress_bar_bounds, progress, "Training Progress");
+// Every network trains on about the same number of ticks of samples per batch as the shared network, except per-ant
+// networks which train on every sample as it comes
+static int topology_batch_size(network_topology_t topology_type, int members) {
+  if (topology_type == TOPOLOGY_PER_ANT) {
+    return 1;
   }
+  return MAX(1, (int)((long)ANN_BATCH_SIZE * members / MAX(1, world->ants.length)));
+}
 
-  EndTextureMode();
+const char *simulation_topology_name(network_topology_t topology_type) {
+  switch (topology_type) {
+  case TOPOLOGY_SHARED:
+    return "Shared";
+  case TOPOLOGY_GROUPS:
+    return "Groups";
+  default:
+    return "Per-Ant";
+  }
+}
 
-  if (simulation_mode != SINGLE_THREAD) {
-    training = true;
-    reset = false;
+// Pick the fastest matrix kernels for the ant network shapes, reusing cached results from earlier runs
+static void tune_kernels(const neural_network_t *network) {
+  const bool cached = autotune_load(AUTOTUNE_CACHE_FILE);
+  const int num_ants = world->ants.length;
+  // Batch sizes of every topology, so switching at runtime needs no tuning
+  int tuned = autotune_network(network, topology_batch_size(TOPOLOGY_PER_ANT, 1));
+  tuned += autotune_network(network, topology_batch_size(TOPOLOGY_SHARED, num_ants));
+  tuned += autotune_network(network, topology_batch_size(TOPOLOGY_GROUPS, num_ants / MAX(1, network_groups)));
+
+  if (tuned > 0 || !cached) {
+    printf("Autotuned %d matrix kernel shapes\n", tuned);
+    autotune_save(AUTOTUNE_CACHE_FILE);
   }
 }
 
-static void initialize() {
-  srand(time(NULL));
-  if (!PER_ANT_NETWORK) {
-    ant_network = create_ant_net();
+static void network_train_step(ant_t *ant, const double *inputs, const double *outputs) {
+  trainer_t *trainer = &trainers[ant->group];
+
+  // Accumulate inputs and outputs until the batch of the network is full
+  if (trainer_add_sample(trainer, inputs, outputs)) {
+    const int m = trainer_pending(trainer);
+    const double lr = trainer->learning_rate;
+    const double error = trainer_step(trainer);
+    if (ant->group == 0 && (trainer->epoch - 1) % (MAX(1, ((int)2e6 / m))) == 0) {
+      printf("Epoch: %d, Error: % .6f, Learning Rate: % .6f\n", trainer->epoch - 1, error, lr);
+    }
+    trainer->learning_rate = fmax(lr * (pow(LEARN_RATE_DECAY, (double)m)), LEARN_RATE_MIN);
   }
-  dyn_arr_init(g_ant_list);
-  dyn_arr_init(g_food_list);
-  dyn_arr_init(input_list);
-  dyn_arr_init(output_list);
 
-  // Initialize raylib
-  SetConfigFlags(FLAG_VSYNC_HINT | FLAG_WINDOW_RESIZABLE | FLAG_WINDOW_ALWAYS_RUN | FLAG_WINDOW_HIGHDPI);
-  SetTraceLogLevel(LOG_DEBUG);
-  InitWindow(1280, 720, "Ant Matrix");
-  SetTargetFPS(TARGET_FPS);
+  // Only the thread of the first network prints, as often as all networks together would
+  if (g_settings.verbose && ant->group == 0 && rng_int(&sample_rng, 10000) < num_networks) {
+    const double *pred;
+    const vector_t inputs_vec = {(double *)inputs, ANN_INPUTS};
+    pred = neural_run(ant->net, &inputs_vec)->data;
+    printf("Inputs: ");
+    for (int j = 0; j < ANN_INPUTS; j++) {
+      printf("%.3f ", inputs[j]);
+    }
+    printf("\nOutputs: ");
+    for (int j = 0; j < ANN_OUTPUTS; j++) {
+      printf("%.3f ", outputs[j]);
+    }
+    printf("\nPred: ");
+    for (int j = 0; j < ANN_OUTPUTS; j++) {
+      printf("%.3f ", pred[j]);
+    }
+    printf("\n");
+  }
+}
 
-  ant_texture = LoadTexture("assets/ant.png");
+// Pick the strongest turn and the strongest action from the network outputs
+static ant_logic_t decode_logic(const double *pred) {
+  ant_logic_t logic = {0};
 
-  ant_data = malloc(starting_ants * sizeof(ant_t));
-  ant_t *ant_data_ptr = ant_data;
-  if (!ant_data) {
-    fprintf(stderr, "Failed to allocate memory for ants\n");
-    exit(EXIT_FAILURE);
+  int choice = 0;
+  logic.turn_action = ANT_TURN_RIGHT;
+  if (pred[1] > pred[choice]) {
+    logic.turn_action = ANT_TURN_NONE;
+    choice = 1;
   }
-  for (int i = 0; i < starting_ants; i++) {
-    ant_t *ant = ant_data_ptr++;
-    if (PER_ANT_NETWORK) {
-      ant->net = create_ant_net();
-    } else {
-      ant->net = ant_network;
-    }
-
-    ant->texture = &ant_texture;
-    ant->nearest_food = NULL;
-    ant->spawn = spawn;
-    ant->pos = spawn;
-    ant->rotation = (rand() % 360) * DEG2RAD_D;
-    ant->has_food = false;
-    ant->is_coliding = false;
-    dyn_arr_push(g_ant_list, ant);
+  if (pred[2] > pred[choice]) {
+    logic.turn_action = ANT_TURN_LEFT;
   }
 
-  reset_simulation();
+  choice = 3;
+  logic.action = ANT_STEP_ACTION;
+  if (pred[4] > pred[choice]) {
+    logic.action = ANT_GATHER_ACTION;
+    choice = 4;
+  }
+  if (pred[5] > pred[choice]) {
+    logic.action = ANT_DROP_ACTION;
+  }
 
-  offscreen = LoadRenderTexture(SCREEN_W, SCREEN_H);
-  SetTextureFilter(offscreen.texture, TEXTURE_FILTER_BILINEAR);
-#ifdef __EMSCRIPTEN__
-  resize_window(GetScreenWidth(), GetScreenHeight());
-#else
-  const int height = nearest_16_by_9_height(GetMonitorWidth(GetCurrentMonitor()));
-  resize_window(height * 16 / 9, height);
-  // Position the window in the center of the screen
-  SetWindowPosition((GetMonitorWidth(GetCurrentMonitor()) - window_w) / 2,
-                    (GetMonitorHeight(GetCurrentMonitor()) - window_h) / 2);
-#endif
+  return logic;
 }
 
-static void *training_thread_func(void *arg) {
-  (void)arg; // Unused parameter
-  double run_time = 0.0;
+static void update_agreement(int agreed, int total) {
+  teacher_agreement += AGREEMENT_SMOOTHING * ((double)agreed / total - teacher_agreement);
 
-  while (atomic_load(&run_training_thread)) {
-    for (int i = 0; i < THREAD_TICKS_PER_CHECK; i++) {
-      train_ants(FIXED_DELTA);
-      run_time += FIXED_DELTA;
+  if (agreement_ticks < 0 && teacher_agreement >= AGREEMENT_TARGET) {
+    agreement_ticks = training_ticks;
+    printf("Teacher agreement reached %.0f%% after %ld training ticks (%.1f s simulated, model averaging %s)\n",
+           AGREEMENT_TARGET * 100.0, agreement_ticks, agreement_ticks * FIXED_DELTA,
+           num_networks > 1 && g_settings.model_averaging ? "on" : "off");
+  }
+}
 
-      if (run_time >= RESET_TIME) {
-        run_time = 0.0;
-        reset_simulation();
-      }
+// Share what every group of ants learned by averaging their networks. Frozen networks converged and no longer train,
+// they neither contribute to the mean nor take it
+static void average_networks() {
+  int count = 0;
+  for (int i = 0; i < num_networks; i++) {
+    if (!(g_settings.auto_freeze && trainers[i].convergence.frozen)) {
+      averaged_networks[count++] = trainers[i].net;
     }
   }
+  if (count > 1) {
+    fedavg_mix(averaged_networks, count, FEDAVG_MIX);
+  }
+}
 
-  atomic_store(&training_thread_done, true);
-  return NULL;
+// Mean squared error of one prediction, the same scale for every output activation
+static double sample_loss(const double *pred, const double *outputs) {
+  double sum = 0.0;
+  for (int i = 0; i < ANN_OUTPUTS; i++) {
+    const double diff = pred[i] - outputs[i];
+    sum += diff * diff;
+  }
+  return sum / ANN_OUTPUTS;
 }
 
-static void resize_window(int w, int h) {
-  SetWindowSize(w, h);
-  window_w = w;
-  window_h = h;
+// Smallest lead of the chosen output over the other outputs of the same head (turn or action)
+static double decision_margin(const double *pred, ant_logic_t logic) {
+  const int chosen[2] = {(int)logic.turn_action, 3 + (int)logic.action};
+  double margin = INFINITY;
+  for (int head = 0; head < 2; head++) {
+    const int first = head * 3;
+    for (int i = first; i < first + 3; i++) {
+      if (i != chosen[head]) {
+        margin = fmin(margin, pred[chosen[head]] - pred[i]);
+      }
+    }
+  }
+  return margin;
+}
 
-  letterbox.width = SCREEN_W;
-  letterbox.height = SCREEN_H;
+// Keep every PRUNE_EVAL_STRIDE-th sample, the sample of each ant has its own slot so workers never write the same one
+static void store_eval_sample(int index, const double *inputs, const double *outputs) {
+  const long sample = eval_seen + index;
+  const long last_kept = (eval_seen + world->ants.length - 1) / PRUNE_EVAL_STRIDE;
+  if (sample % PRUNE_EVAL_STRIDE != 0 || last_kept - sample / PRUNE_EVAL_STRIDE >= PRUNE_EVAL_SAMPLES) {
+    return;
+  }
 
-  const float ratio_x = window_w / (float)SCREEN_W;
-  const float ratio_y = window_h / (float)SCREEN_H;
-  const float ratio = fminf(ratio_x, ratio_y);
-  const float offset_x = (window_w - ratio * SCREEN_W) * 0.5f;
-  const float offset_y = (window_h - ratio * SCREEN_H) * 0.5f;
-  letterbox = (Rectangle){offset_x, offset_y, ratio * SCREEN_W, ratio * SCREEN_H};
+  const int slot = (int)((sample / PRUNE_EVAL_STRIDE) % PRUNE_EVAL_SAMPLES);
+  memcpy(eval_inputs[slot], inputs, sizeof(eval_inputs[0]));
+  memcpy(eval_outputs[slot], outputs, sizeof(eval_outputs[0]));
 }
 
-static void render_present() {
-  /* render offscreen to display */
-
-  BeginDrawing();
-  ClearBackground(BROWN);
-  DrawRectangle(0, 0, letterbox.x, GetScreenHeight(), WHITE);
-  DrawRectangle(letterbox.x + letterbox.width, 0, GetScreenWidth() - (letterbox.x + letterbox.width), GetScreenHeight(),
-                WHITE);
+// Count the samples of a tick, once all of them are stored
+static void advance_eval_samples(int count) {
+  eval_seen += count;
+  const long kept = (eval_seen + PRUNE_EVAL_STRIDE - 1) / PRUNE_EVAL_STRIDE;
+  eval_next = (int)(kept % PRUNE_EVAL_SAMPLES);
+  eval_count = (int)MIN(kept, PRUNE_EVAL_SAMPLES);
+}
 
-  const Rectangle render_src = {0, 0, (float)SCREEN_W, -(float)SCREEN_H};
-  const Vector2 render_origin = {0, 0};
-  DrawTexturePro(offscreen.texture, render_src, letterbox, render_origin, 0.0f, WHITE);
-  EndDrawing();
+// Index of sample i of the evaluation buffer in age order
+static int eval_index(int i) { return (eval_count < PRUNE_EVAL_SAMPLES ? i : eval_next + i) % PRUNE_EVAL_SAMPLES; }
+
+// Share of samples in [begin, end) where the network decides like the teacher, sparse is used if not NULL
+static double evaluate_agreement(neural_network_t *network, sparse_network_t *sparse, int begin, int end) {
+  int agreed = 0;
+  for (int i = begin; i < end; i++) {
+    const vector_t inputs_vec = {eval_inputs[eval_index(i)], ANN_INPUTS};
+    const double *pred = sparse ? sparse_run(sparse, &inputs_vec)->data : neural_run(network, &inputs_vec)->data;
+    const ant_logic_t predicted = decode_logic(pred);
+    const ant_logic_t label = decode_logic(eval_outputs[eval_index(i)]);
+    agreed += predicted.turn_action == label.turn_action && predicted.action == label.action;
+  }
+  return (double)agreed / MAX(1, end - begin);
 }
 
-static void train_ants(double fixed_delta) {
-  if (training && random_session) {
-    for (int i = 0; i < g_ant_list.length; i++) {
-      ant_t *ant = dyn_arr_get(g_ant_list, i);
-      ant->rotation = (rand() % 360) * DEG2RAD_D;
-      ant->pos.x = rand() % WORLD_W;
-      ant->pos.y = rand() % WORLD_H;
-      ant->has_food = rand() % 4 == 0;
-      ant->is_coliding = false;
+// Seconds per sample of single-sample inference over [begin, end), sparse is used if not NULL
+static double time_inference(neural_network_t *network, sparse_network_t *sparse, int begin, int end) {
+  volatile double sink = 0.0;
+  long runs = 0;
+  const double start_time = monotonic_seconds();
+  double elapsed = 0.0;
+  do {
+    for (int i = begin; i < end; i++) {
+      const vector_t inputs_vec = {eval_inputs[eval_index(i)], ANN_INPUTS};
+      sink += sparse ? sparse_run(sparse, &inputs_vec)->data[0] : neural_run(network, &inputs_vec)->data[0];
     }
-  }
+    runs += end - begin;
+    elapsed = monotonic_seconds() - start_time;
+  } while (elapsed < 0.05);
+  (void)sink;
 
-  for (int i = 0; i < g_ant_list.length; i++) {
-    ant_t *ant = dyn_arr_get(g_ant_list, i);
-    ant_update_nearest_food(ant);
+  return elapsed / MAX(1, runs);
+}
 
-    // Update the neural network
-    double inputs[ANN_INPUTS] = {0};
+void simulation_publish_snapshot(void) {
+  world_snapshot_t *snapshot = &snapshots[triple_buffer_write_slot(&snapshot_buffer)];
 
-    const vector2d_t spawn_vector = v2d_subtract(ant->spawn, ant->pos);
-    const double spawn_vector_length = v2d_length(spawn_vector);
-    inputs[0] = cos(ant->rotation);
-    inputs[1] = sin(ant->rotation);
-    inputs[2] = circle_collide_point((circled_t){ant->spawn, ANT_SPAWN_RADIUS}, ant->pos) ? 1.0 : 0.0;
-    inputs[3] = spawn_vector_length > 1e-9 ? enc(spawn_vector.x / spawn_vector_length) : enc(-cos(ant->rotation));
-    inputs[4] = spawn_vector_length > 1e-9 ? enc(spawn_vector.y / spawn_vector_length) : enc(-sin(ant->rotation));
+  dyn_arr_clear(snapshot->ants);
+  for (int i = 0; i < world->ants.length; i++) {
+    ant_t *ant = dyn_arr_get(world->ants, i);
+    const ant_pose_t pose = {ant->pos, ant_get_rotation(ant), ant_get_detector_circle(ant), ant->has_food};
+    dyn_arr_push(snapshot->ants, pose);
+  }
+  dyn_arr_clear(snapshot->food);
+  for (int i = 0; i < world->food.length; i++) {
+    dyn_arr_push(snapshot->food, *dyn_arr_get(world->food, i));
+  }
 
-    if (ant->nearest_food) {
-      const vector2d_t food_vector = v2d_subtract(ant->nearest_food->pos, ant->pos);
-      const double food_vector_length = v2d_length(food_vector);
-      inputs[5] =
-          circle_collide_point((circled_t){ant->nearest_food->pos, ant->nearest_food->radius}, ant->pos) ? 1.0 : 0.0;
-      inputs[6] = food_vector_length > 1e-9 ? enc(food_vector.x / food_vector_length) : enc(-cos(ant->rotation));
-      inputs[7] = food_vector_length > 1e-9 ? enc(food_vector.y / food_vector_length) : enc(-sin(ant->rotation));
-    } else {
-      inputs[5] = 0.0;
-      inputs[6] = 0.0;
-      inputs[7] = 0.0;
+  // The copy keeps its buffers, only a network of another shape is cloned again
+  neural_network_t *net = world->ants.length > 0 ? dyn_arr_get(world->ants, 0)->net : NULL;
+  if (net && !neural_same_shape(snapshot->net, net)) {
+    neural_free(snapshot->net);
+    snapshot->net = neural_clone(net);
+  }
+  if (net && snapshot->net) {
+    const vector_t parameters = neural_parameters(net);
+    memcpy(neural_parameters(snapshot->net).data, parameters.data, parameters.rows * sizeof(double));
+    for (int l = 0; l < net->num_layers; l++) {
+      memcpy(snapshot->net->output[l].data, net->output[l].data, net->neuron_counts[l] * sizeof(double));
     }
+  }
 
-    inputs[8] = ant->nearest_food ? 1.0 : 0.0;
-    inputs[9] = ant->has_food ? 1.0 : 0.0;
+  snapshot->stats = simulation_get_stats();
+  snapshot->training = g_settings.training;
+  snapshot->tick = world->ticks;
+  triple_buffer_publish(&snapshot_buffer);
+}
 
-    if (training) {
-      ant_logic_t logic = ant_train_update(ant, fixed_delta);
+bool simulation_snapshot_pending(void) { return triple_buffer_pending(&snapshot_buffer); }
 
-      double outputs[ANN_OUTPUTS] = {0};
-      outputs[0] = logic.turn_action == ANT_TURN_RIGHT ? 1.0 : 0.0;
-      outputs[1] = logic.turn_action == ANT_TURN_NONE ? 1.0 : 0.0;
-      outputs[2] = logic.turn_action == ANT_TURN_LEFT ? 1.0 : 0.0;
+const world_snapshot_t *simulation_acquire_snapshot(void) {
+  return &snapshots[triple_buffer_acquire(&snapshot_buffer)];
+}
 
-      outputs[3] = logic.action == ANT_STEP_ACTION ? 1.0 : 0.0;
-      outputs[4] = logic.action == ANT_GATHER_ACTION ? 1.0 : 0.0;
-      outputs[5] = logic.action == ANT_DROP_ACTION ? 1.0 : 0.0;
+static void free_snapshots() {
+  for (int i = 0; i < TRIPLE_BUFFER_SLOTS; i++) {
+    dyn_arr_free(snapshots[i].ants);
+    dyn_arr_free(snapshots[i].food);
+    neural_free(snapshots[i].net);
+    snapshots[i].net = NULL;
+  }
+}
 
-      int iterations = 1;
+void simulation_report_pruning(void) {
+  if (num_networks == 0) {
+    return;
+  }
+  if (eval_count < 2 * PRUNE_FINE_TUNE_BATCH) {
+    printf("Pruning report needs at least %d training samples, %d collected\n", 2 * PRUNE_FINE_TUNE_BATCH,
+           eval_count);
+    return;
+  }
 
-      if (logic.action == ANT_DROP_ACTION) {
-        iterations = 30;
-      } else if (logic.action == ANT_GATHER_ACTION) {
-        iterations = 10;
-      } else if (inputs[5] >= 1.0) {
-        iterations = 5;
+  const neural_network_t *network = trainers[0].net;
+  const double sparsities[] = PRUNE_SPARSITIES;
+  const int tune_end = eval_count / 2;
+  double tune_inputs[PRUNE_FINE_TUNE_BATCH][ANN_INPUTS];
+  double tune_outputs[PRUNE_FINE_TUNE_BATCH][ANN_OUTPUTS];
+  bool mask[network->total_weights];
+
+  printf("Pruning report, %d fine-tuning and %d evaluation samples\n", tune_end, eval_count - tune_end);
+  printf("%8s %8s %8s %10s %10s %9s %9s\n", "sparsity", "weights", "bytes", "dense ns", "sparse ns", "pruned",
+         "tuned");
+  for (size_t s = 0; s < sizeof(sparsities) / sizeof(sparsities[0]); s++) {
+    neural_network_t *pruned = neural_clone(network);
+    if (!pruned || neural_prune(pruned, sparsities[s], mask) < 0) {
+      fprintf(stderr, "Failed to prune network\n");
+      neural_free(pruned);
+      return;
+    }
+    const double pruned_agreement = evaluate_agreement(pruned, NULL, tune_end, eval_count);
+
+    // Fine-tune the remaining weights, the mask keeps the pruned ones at zero
+    for (int pass = 0; pass < PRUNE_FINE_TUNE_EPOCHS && sparsities[s] > 0.0; pass++) {
+      for (int begin = 0; begin + PRUNE_FINE_TUNE_BATCH <= tune_end; begin += PRUNE_FINE_TUNE_BATCH) {
+        for (int i = 0; i < PRUNE_FINE_TUNE_BATCH; i++) {
+          memcpy(tune_inputs[i], eval_inputs[eval_index(begin + i)], sizeof(tune_inputs[0]));
+          memcpy(tune_outputs[i], eval_outputs[eval_index(begin + i)], sizeof(tune_outputs[0]));
+        }
+        const matrix_t input_matrix = {&tune_inputs[0][0], PRUNE_FINE_TUNE_BATCH, ANN_INPUTS};
+        const matrix_t output_matrix = {&tune_outputs[0][0], PRUNE_FINE_TUNE_BATCH, ANN_OUTPUTS};
+        neural_train(pruned, &input_matrix, &output_matrix, LEARN_RATE);
+        neural_apply_mask(pruned, mask);
       }
+    }
 
-      // Train the neural network
-      for (int j = 0; j < iterations; j++) {
-        network_train_step(ant, inputs, outputs);
-      }
-    } else {
-      vector_t inputs_vec = {inputs, ANN_INPUTS};
-      const double *pred = neural_run(ant->net, &inputs_vec)->data;
-      ant_logic_t logic = {0};
-
-      int choice = 0;
-      logic.turn_action = ANT_TURN_RIGHT;
-      if (pred[1] > pred[choice]) {
-        logic.turn_action = ANT_TURN_NONE;
-        choice = 1;
-      }
-      if (pred[2] > pred[choice]) {
-        logic.turn_action = ANT_TURN_LEFT;
-      }
+    sparse_network_t *sparse = sparse_create(pruned);
+    if (!sparse) {
+      fprintf(stderr, "Failed to create sparse network\n");
+      neural_free(pruned);
+      return;
+    }
+    const double tuned_agreement = evaluate_agreement(NULL, sparse, tune_end, eval_count);
+    const double dense_time = time_inference(pruned, NULL, tune_end, eval_count);
+    const double sparse_time = time_inference(NULL, sparse, tune_end, eval_count);
 
-      choice = 3;
-      logic.action = ANT_STEP_ACTION;
-      if (pred[4] > pred[choice]) {
-        logic.action = ANT_GATHER_ACTION;
-        choice = 4;
-      }
-      if (pred[5] > pred[choice]) {
-        logic.action = ANT_DROP_ACTION;
-      }
+    printf("%7.0f%% %8d %8zu %10.1f %10.1f %8.1f%% %8.1f%%\n", sparsities[s] * 100.0, sparse->total_nonzeros,
+           sparse->size, dense_time * 1e9, sparse_time * 1e9, pruned_agreement * 100.0, tuned_agreement * 100.0);
 
-      ant_run_update(ant, logic, fixed_delta);
-      if (rand() % 5000 == 0) {
-        printf("Inputs: ");
-        for (int j = 0; j < ANN_INPUTS; j++) {
-          printf("%.3f ", inputs[j]);
-        }
-        printf("\nPred: ");
-        for (int j = 0; j < ANN_OUTPUTS; j++) {
-          printf("%.3f ", pred[j]);
+    sparse_free(sparse);
+    neural_free(pruned);
+  }
+}
+
+bool simulation_parse_options(int argc, char **argv, simulation_options_t *parsed) {
+  static const char *value_options[] = {"--ants",    "--food",     "--ticks",     "--duration", "--seed", "--topology",
+                                        "--groups",  "--log",      "--model-out", "--threads",  "--record", "--replay",
+                                        "--dataset", "--model-in"};
+  *parsed = (simulation_options_t){
+      .seed = (unsigned int)time(NULL),
+      .ants = DEFAULT_ANTS,
+      .food = DEFAULT_FOOD,
+      .topology = ANN_TOPOLOGY,
+      .groups = ANN_GROUPS,
+  };
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool valid = false;
+
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      print_usage(argv[0]);
+      exit(EXIT_SUCCESS);
+    } else if (strcmp(arg, "--headless") == 0) {
+      parsed->headless = true;
+      continue;
+    } else if (strcmp(arg, "--pipeline") == 0) {
+      parsed->pipeline = true;
+      continue;
+    } else if (strcmp(arg, "--model-averaging") == 0) {
+      parsed->model_averaging = true;
+      continue;
+    }
+
+    for (size_t j = 0; j < sizeof(value_options) / sizeof(value_options[0]); j++) {
+      valid |= strcmp(arg, value_options[j]) == 0;
+    }
+    if (!valid) {
+      fprintf(stderr, "Unknown option %s\n", arg);
+      print_usage(argv[0]);
+      return false;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "Missing value for %s\n", arg);
+      print_usage(argv[0]);
+      return false;
+    }
+
+    const char *value = argv[++i];
+    if (strcmp(arg, "--ants") == 0) {
+      parsed->ants = atoi(value);
+      valid = parsed->ants > 0;
+    } else if (strcmp(arg, "--food") == 0) {
+      parsed->food = atoi(value);
+      valid = parsed->food >= 0;
+    } else if (strcmp(arg, "--ticks") == 0) {
+      parsed->ticks = atol(value);
+      valid = parsed->ticks > 0;
+    } else if (strcmp(arg, "--duration") == 0) {
+      parsed->duration = atof(value);
+      valid = parsed->duration > 0.0;
+    } else if (strcmp(arg, "--seed") == 0) {
+      parsed->seed = (unsigned int)strtoul(value, NULL, 10);
+    } else if (strcmp(arg, "--topology") == 0) {
+      valid = false;
+      for (int t = 0; t < TOPOLOGY_COUNT; t++) {
+        if (strcasecmp(value, simulation_topology_name(t)) == 0) {
+          parsed->topology = t;
+          valid = true;
         }
-        printf("\n");
       }
+    } else if (strcmp(arg, "--groups") == 0) {
+      parsed->groups = atoi(value);
+      valid = parsed->groups > 0;
+    } else if (strcmp(arg, "--log") == 0) {
+      parsed->log_path = value;
+    } else if (strcmp(arg, "--model-out") == 0) {
+      parsed->model_out = value;
+    } else if (strcmp(arg, "--model-in") == 0) {
+      parsed->model_in = value;
+    } else if (strcmp(arg, "--threads") == 0) {
+      parsed->threads = atoi(value);
+      valid = parsed->threads >= 0;
+    } else if (strcmp(arg, "--record") == 0) {
+      parsed->record_path = value;
+    } else if (strcmp(arg, "--replay") == 0) {
+      parsed->replay_path = value;
+    } else if (strcmp(arg, "--dataset") == 0) {
+      parsed->dataset_path = value;
+    }
+
+    if (!valid) {
+      fprintf(stderr, "Invalid value %s for %s\n", value, arg);
+      print_usage(argv[0]);
+      return false;
     }
   }
-}
 
-static void reset_simulation() {
-  for (int i = 0; i < g_food_list.length; i++) {
-    food_t *food = dyn_arr_get(g_food_list, i);
-    food_free(food);
+  if (parsed->record_path && parsed->replay_path) {
+    fprintf(stderr, "--record and --replay cannot be combined\n");
+    print_usage(argv[0]);
+    return false;
   }
-  dyn_arr_clear(g_food_list);
+  return true;
+}
 
-  random_session = rand() % 3 != 0;
+static void print_usage(const char *program) {
+  printf("Usage: %s [options]\n"
+         "  --headless            Train without a window as fast as possible\n"
+         "  --ants N              Number of ants (default %d)\n"
+         "  --food N              Number of food sources per session (default %d)\n"
+         "  --ticks N             Headless ticks to run (default %d without --duration)\n"
+         "  --duration SECONDS    Headless wall-clock time to run\n"
+         "  --seed N              Random seed (default: current time)\n"
+         "  --topology NAME       Network sharing: per-ant, shared or groups (default %s)\n"
+         "  --groups N            Number of ant groups for the groups topology (default %d)\n"
+         "  --log PATH            Write training statistics as CSV every %d training ticks\n"
+         "  --model-in PATH       Start every network from a saved one (--model-out, AntMatrix_train)\n"
+         "  --model-out PATH      Write the network of the first ant on exit\n"
+         "  --threads N           Worker threads for the ant updates, 0 for one per core (default 0)\n"
+         "  --pipeline            Train on each tick while the ants move on, training lags one tick\n"
+         "  --model-averaging     Replace the networks by their mean every %d training ticks (per-ant and groups)\n"
+         "  --record PATH         Record a replay of the run\n"
+         "  --replay PATH         Play back a recorded replay instead of simulating, headless to its end\n"
+         "  --dataset PATH        Stream the teacher samples of training to a columnar file\n"
+         "  --help                Show this help\n",
+         program, DEFAULT_ANTS, DEFAULT_FOOD, HEADLESS_DEFAULT_TICKS, simulation_topology_name(ANN_TOPOLOGY),
+         ANN_GROUPS, LOG_INTERVAL_TICKS, FEDAVG_INTERVAL);
+}
 
-  // Position ants at spawn
-  for (int i = 0; i < g_ant_list.length; i++) {
-    ant_t *ant = dyn_arr_get(g_ant_list, i);
-    ant->pos = spawn;
-    ant->rotation = (rand() % 360) * DEG2RAD_D;
-    ant->has_food = false;
-    ant->is_coliding = false;
-  }
+void simulation_run_headless(void) {
+  const double start_time = monotonic_seconds();
+  double run_time = 0.0;
+  double elapsed = 0.0;
+  long ticks = 0;
+  const bool default_limit = options.ticks == 0 && options.duration == 0.0 && !player;
+  const long max_ticks = default_limit ? HEADLESS_DEFAULT_TICKS : options.ticks;
+
+  printf("Headless run with %d ants, seed %u, %d threads\n", world->ants.length, options.seed, threadpool_size(pool));
+  while ((max_ticks <= 0 || ticks < max_ticks) && (options.duration <= 0.0 || elapsed < options.duration)) {
+    simulation_tick(FIXED_DELTA);
+    if (player && player->done) {
+      break;
+    }
+    ticks++;
+    run_time += FIXED_DELTA;
 
-  // Create food away from ants
-  if (!random_session || rand() % 2 == 0) {
-    for (int i = 0; i < starting_food; i++) {
-      vector2d_t food_pos = spawn;
-      while (v2d_distance(spawn, food_pos) < min_food_distance) {
-        food_pos.x = (rand() % WORLD_W);
-        food_pos.y = rand() % WORLD_H;
-      }
-      food_t *food =
-          food_create(food_pos, food_radius, food_detection_radius,
-                      rand() % (max_starting_food_amount - min_starting_food_amount) + min_starting_food_amount);
-      dyn_arr_push(g_food_list, food);
+    if (run_time >= RESET_TIME) {
+      run_time = 0.0;
+      simulation_reset();
+    }
+    // Reading the clock every tick would cost more than a small tick
+    if ((ticks & 63) == 0) {
+      elapsed = monotonic_seconds() - start_time;
     }
   }
+  elapsed = monotonic_seconds() - start_time;
+
+  printf("Ran %ld ticks in %.2f s: %.0f ticks/s, %.0f ant steps/s, %.1f simulated seconds per second\n", ticks,
+         elapsed, ticks / elapsed, ticks * (double)world->ants.length / elapsed, ticks * FIXED_DELTA / elapsed);
 }
 
-static neural_network_t *create_ant_net() {
-  const int neuron_counts[] = ANN_NEURON_COUNTS;
-  neural_network_t *network = neural_create((sizeof(neuron_counts) / sizeof(int)) - 2, neuron_counts);
-  if (!network) {
-    fprintf(stderr, "Failed to create neural network\n");
-    exit(EXIT_FAILURE);
-  }
-  // Randomize weights and biases
-  const double std = sqrt(6) / sqrt(neuron_counts[0] + neuron_counts[network->num_hidden_layers + 1]);
-  neural_randomize_weights(network, -std, std);
-  neural_randomize_bias(network, -0.01, 0.01);
+static void log_stats(void) {
+  const double elapsed = monotonic_seconds() - log_start_time;
+  fprintf(log_file, "%ld,%.3f,%.1f,%.4f,%d,%.4f,%.6f\n", training_ticks, elapsed, training_ticks / fmax(elapsed, 1e-9),
+          teacher_agreement, g_settings.auto_freeze ? frozen_networks : 0, g_settings.active_training ? skip_rate : 0.0,
+          mean_learning_rate());
+  fflush(log_file);
+}
 
-  return network;
+// Every network decays its own learning rate
+static double mean_learning_rate() {
+  double sum = 0.0;
+  for (int i = 0; i < num_networks; i++) {
+    sum += trainers[i].learning_rate;
+  }
+  return num_networks > 0 ? sum / num_networks : LEARN_RATE;
 }
 
-static void network_train_step(ant_t *ant, const double *inputs, const double *outputs) {
-  bool run = true;
-  const double *input_ptr = inputs;
-  const double *output_ptr = outputs;
-  int m = 1;
-
-  // Accumulate inputs and outputs for batch training with single network
-  if (!PER_ANT_NETWORK) {
-    dyn_arr_pusharr(input_list, inputs, ANN_INPUTS);
-    dyn_arr_pusharr(output_list, outputs, ANN_OUTPUTS);
-    run = input_list.length >= ANN_BATCH_SIZE * ANN_INPUTS;
-    input_ptr = input_list.data;
-    output_ptr = output_list.data;
-    m = input_list.length / ANN_INPUTS;
-  }
-
-  if (run) {
-    const matrix_t input_matrix = {(double *)input_ptr, m, ANN_INPUTS};
-    const matrix_t output_matrix = {(double *)output_ptr, m, ANN_OUTPUTS};
-    const double error = neural_train(ant->net, &input_matrix, &output_matrix, learning_rate);
-    if (epoch % (MAX(1, ((int)2e6 / m))) == 0) {
-      printf("Epoch: %d, Error: % .6f, Learning Rate: % .6f\n", epoch, error, learning_rate);
-    }
-    dyn_arr_clear(input_list);
-    dyn_arr_clear(output_list);
-    learning_rate = fmax(learning_rate * (pow(LEARN_RATE_DECAY, (double)m)), LEARN_RATE_MIN);
-    epoch++;
-  }
-
-  if (simulation_mode == SINGLE_THREAD && !warp && rand() % 10000 == 0) {
-    const double *pred;
-    const vector_t inputs_vec = {(double *)inputs, ANN_INPUTS};
-    pred = neural_run(ant->net, &inputs_vec)->data;
-    printf("Inputs: ");
-    for (int j = 0; j < ANN_INPUTS; j++) {
-      printf("%.3f ", inputs[j]);
-    }
-    printf("\nOutputs: ");
-    for (int j = 0; j < ANN_OUTPUTS; j++) {
-      printf("%.3f ", outputs[j]);
+// Networks that have not trained yet do not count
+static double mean_loss() {
+  double sum = 0.0;
+  int trained = 0;
+  for (int i = 0; i < num_networks; i++) {
+    if (!isnan(trainers[i].loss)) {
+      sum += trainers[i].loss;
+      trained++;
     }
-    printf("\nPred: ");
-    for (int j = 0; j < ANN_OUTPUTS; j++) {
-      printf("%.3f ", pred[j]);
-    }
-    printf("\n");
   }
-}
\ No newline at end of file
+  return trained > 0 ? sum / trained : NAN;
+}
+
+simulation_stats_t simulation_get_stats(void) {
+  int epoch = 0;
+  for (int i = 0; i < num_networks; i++) {
+    epoch += trainers[i].epoch;
+  }
+
+  return (simulation_stats_t){
+      .learning_rate = mean_learning_rate(),
+      .loss = mean_loss(),
+      .teacher_agreement = teacher_agreement,
+      .skip_rate = skip_rate,
+      .training_ticks = training_ticks,
+      .epoch = epoch,
+      .num_networks = num_networks,
+      .frozen_networks = frozen_networks,
+      .topology = topology,
+  };
+}
@@ -3,6 +3,9 @@
  * @author Zachary Heskett (zheskett@gmail.com)
  * @brief Header file for the ant simulation program.
  *
+ * The simulation core: the world, the ants and the training of their networks. It does not depend on raylib, the
+ * window and the GUI on top of it live in render/app.h.
+ *
  * @copyright Copyright (c) 2025
  *
  */
@@ -10,53 +13,287 @@
 #ifndef SIMULATION_H
 #define SIMULATION_H
 
-#include "entities/ant.h"
+#include "main/world.h"
+
+/**
+ * @brief How the ants share neural networks.
+ */
+typedef enum {
+  TOPOLOGY_PER_ANT, /**< Every ant trains its own network on single samples */
+  TOPOLOGY_SHARED,  /**< All ants train one network on batches of ANN_BATCH_SIZE */
+  TOPOLOGY_GROUPS,  /**< Each of ANN_GROUPS groups of ants trains one network on batches sized to the group */
+  TOPOLOGY_COUNT,
+} network_topology_t;
+
+#define DEFAULT_ANTS 100
+#define DEFAULT_FOOD 10
 
-// Multiple networks per ant?
-#define PER_ANT_NETWORK 1
+// Topology at startup, it can be switched at runtime
+#define ANN_TOPOLOGY TOPOLOGY_PER_ANT
+#define ANN_GROUPS 10
 
 #define LEARN_RATE 0.11
 #define LEARN_RATE_DECAY 0.99999999
 #define LEARN_RATE_MIN 0.0001
 
-// 1 angle, 2 positions (spawn/food), 1 has_food, 1 near food, 1 is_coliding
-#define ANN_INPUTS 10
+// The observation of world_observe: 1 angle, 2 positions (spawn/food), 1 has_food, 1 near food, 1 is_coliding
+#define ANN_INPUTS WORLD_OBSERVATION_SIZE
 // 3 turn actions, 3 actions
 #define ANN_OUTPUTS 6
 #define ANN_NEURON_COUNTS {ANN_INPUTS, 16, ANN_OUTPUTS}
+// Activation of every layer after the input, the sigmoid output head matches the one-hot teacher labels
+#define ANN_ACTIVATIONS {NEURAL_LEAKY_RELU, NEURAL_SIGMOID}
+
+// Ants of a network sensed together, networks that do not train during a tick also run them as one batch
+#define SENSE_BATCH 256
 
+// Batch size of the shared network, groups use the same number of ticks of samples per batch
 #define ANN_BATCH_SIZE 1000
 
+// Federated averaging of the networks (per-ant or groups) every FEDAVG_INTERVAL training ticks, see neural/fedavg.h.
+// Off unless asked for (--model-averaging or the GUI), a full mix makes every network the mean of the colony
+#define FEDAVG_ENABLED false
+#define FEDAVG_INTERVAL 30
+#define FEDAVG_MIX 1.0
+
+// Share of ant decisions matching the teacher, smoothed over roughly 1 / AGREEMENT_SMOOTHING ticks
+#define AGREEMENT_SMOOTHING 0.01
+#define AGREEMENT_TARGET 0.95
+
+// Stop training networks that agree with the teacher, see neural/convergence.h
+#define AUTO_FREEZE_ENABLED true
+// Training ticks the convergence monitors average over
+#define CONVERGENCE_WINDOW_TICKS 200
+
+// Only backpropagate samples the network gets wrong or decides with less than ACTIVE_TRAINING_MARGIN confidence
+#define ACTIVE_TRAINING_ENABLED true
+#define ACTIVE_TRAINING_MARGIN 0.3
+
+// Pruning report, see neural/sparse.h. Keeps every PRUNE_EVAL_STRIDE-th teacher sample, up to PRUNE_EVAL_SAMPLES,
+// fine-tunes the pruned networks on the older half and evaluates them on the newer half
+#define PRUNE_EVAL_SAMPLES 4000
+#define PRUNE_EVAL_STRIDE 25
+#define PRUNE_FINE_TUNE_EPOCHS 20
+#define PRUNE_FINE_TUNE_BATCH 100
+#define PRUNE_SPARSITIES {0.0, 0.5, 0.75, 0.9, 0.95}
+
+// Kernel tuning results, see neural/autotune.h
+#define AUTOTUNE_CACHE_FILE "autotune.cache"
+
 #define TARGET_FPS 0
 #define TICK_RATE 30
-#define FIXED_DELTA 1.0 / (double)TICK_RATE
+#define FIXED_DELTA (1.0 / (double)TICK_RATE)
 #define MAX_DELTA 0.125
 
-#define WARP_SPEED 10.0
+// Seconds per frame the scheduler fills with ticks and rendering, warp runs as many ticks as fit
+#define FRAME_BUDGET (1.0 / 30.0)
+// Seconds between rendered frames while the window is minimized or unfocused
+#define BACKGROUND_RENDER_INTERVAL 0.25
 #define RESET_TIME 60.0
 
-#define THREAD_TICKS_PER_CHECK 10000
+// Fewest ants a worker thread updates per tick, smaller populations use fewer threads
+#define ANTS_PER_THREAD_MIN 64
+// Weight of the newest tick in the measured stage work that splits the worker threads of pipelined ticks
+#define PIPELINE_SMOOTHING 0.1
 
-#define SCREEN_W 1920
-#define SCREEN_H 1080
-#define WORLD_SCALE 2.0
-#define WORLD_W ((int)(SCREEN_W * WORLD_SCALE))
-#define WORLD_H ((int)(SCREEN_H * WORLD_SCALE))
+// Headless runs without --ticks or --duration stop after this many ticks
+#define HEADLESS_DEFAULT_TICKS 100000
+// Training ticks between two lines of the --log file
+#define LOG_INTERVAL_TICKS 1000
 
 #define CAM_SPEED 1000
 
-extern dyn_arr_ant_t g_ant_list;
-extern dyn_arr_food_t g_food_list;
+/**
+ * @brief Command line options.
+ */
+typedef struct {
+  bool headless;               /**< Run without a window, as fast as possible */
+  long ticks;                  /**< Headless ticks to run, 0 for no limit */
+  double duration;             /**< Headless wall-clock seconds to run, 0 for no limit */
+  unsigned int seed;           /**< Random seed */
+  int ants;                    /**< Number of ants */
+  int food;                    /**< Number of food sources per session */
+  network_topology_t topology; /**< How the ants share networks at startup */
+  int groups;                  /**< Number of ant groups for TOPOLOGY_GROUPS */
+  const char *log_path;        /**< CSV file for training statistics, or NULL */
+  const char *model_in;        /**< File to load the starting parameters of every network from, or NULL */
+  const char *model_out;       /**< File to write the network of the first ant to on exit, or NULL */
+  int threads;                 /**< Worker threads for the ant updates, 0 for one per core */
+  bool pipeline;               /**< Train on the samples of a tick during the next one, see simulation_tick */
+  bool model_averaging;        /**< Average the networks from the start, see FEDAVG_ENABLED */
+  const char *record_path;     /**< File to record a replay of the run to, or NULL */
+  const char *replay_path;     /**< Replay to play back instead of simulating, or NULL */
+  const char *dataset_path;    /**< File to stream the teacher samples of training to, or NULL */
+} simulation_options_t;
+
+/**
+ * @brief Training switches, the front end can change them between ticks.
+ */
+typedef struct {
+  bool training;        /**< Train the networks on the teacher, otherwise the networks drive the ants */
+  bool model_averaging; /**< Average the networks every FEDAVG_INTERVAL training ticks */
+  bool auto_freeze;     /**< Stop training networks that agree with the teacher */
+  bool active_training; /**< Skip samples the network already decides right */
+  bool verbose;         /**< Print a sample prediction now and then */
+} simulation_settings_t;
+
+/**
+ * @brief Training statistics of the simulation.
+ */
+typedef struct {
+  double learning_rate;        /**< Current learning rate */
+  double loss;                 /**< Mean cost of the last training step of every network, NAN before the first */
+  double teacher_agreement;    /**< Smoothed share of ant decisions matching the teacher */
+  double skip_rate;            /**< Smoothed share of samples active training skipped */
+  long training_ticks;         /**< Training ticks since the networks were created */
+  int epoch;                   /**< Training steps since the networks were created */
+  int num_networks;            /**< Number of networks */
+  int frozen_networks;         /**< Number of networks frozen by their convergence monitor */
+  network_topology_t topology; /**< How the ants share networks */
+} simulation_stats_t;
 
 /**
- * @brief Start the simulation.
+ * @brief What is drawn of an ant.
+ */
+typedef struct {
+  vector2d_t pos;     /**< Position of the ant */
+  double rotation;    /**< Rotation of the ant in radians */
+  circled_t detector; /**< Food detector circle of the ant */
+  bool has_food;      /**< Whether the ant carries food */
+} ant_pose_t;
+
+/**
+ * @brief A copy of the world for drawing on another thread than the one running the simulation.
+ */
+typedef struct {
+  dyn_arr_def(ant_pose_t) ants; /**< Poses of all ants */
+  dyn_arr_def(food_t) food;     /**< Copies of all food */
+  neural_network_t *net;        /**< Copy of the network of the first ant, NULL before the first snapshot */
+  simulation_stats_t stats;     /**< Training statistics */
+  bool training;                /**< Whether the networks were training, else net->output predicts for the first ant */
+  long tick;                    /**< Ticks simulated before the snapshot */
+} world_snapshot_t;
+
+/**
+ * @brief Seconds spent in the parts of simulation_tick since simulation_init.
+ */
+typedef struct {
+  long ticks;        /**< Ticks run */
+  double ants;       /**< Sense, label, act and train stages of all ants, run in parallel */
+  double move;       /**< Pipelined ticks only, the slowest worker of the sense, label and act stages */
+  double train;      /**< Pipelined ticks only, the slowest worker of the train stage */
+  double world;      /**< Applying the food commands and finishing the tick of the world */
+  double statistics; /**< Training statistics, logging and model averaging */
+} simulation_timings_t;
+
+extern simulation_settings_t g_settings;
+
+/**
+ * @brief Parse the command line options, see --help.
  *
- * Initializes the simulation, sets up the window, and runs the main loop.
+ * Exits after printing the usage for --help.
  *
  * @param argc Argument count.
  * @param argv Argument vector.
- * @return Exit code of the simulation.
+ * @param parsed Output of the options, defaults for the ones not given.
+ * @return true on success, false after printing the usage for invalid options.
+ */
+bool simulation_parse_options(int argc, char **argv, simulation_options_t *parsed);
+
+/**
+ * @brief Create the world, the ants and their networks.
+ *
+ * @param simulation_options The options to run with, copied.
+ */
+void simulation_init(const simulation_options_t *simulation_options);
+
+/**
+ * @brief Advance the simulation by one tick, training the networks if enabled.
+ *
+ * A tick runs four stages for every ant: sense (observe the world), label (ask the teacher), act (move and record
+ * food changes) and train (grade the network and learn from the teacher). By default every ant runs all four before
+ * the next ant of its network. With the pipeline option the train stage of a tick runs during the next tick on
+ * other threads than the first three stages, so training lags movement by one tick. The networks do not drive the
+ * ants while training, so the movement is the same, but a network that freezes takes over its ants one tick later and
+ * the samples it had not trained on yet are dropped. Nothing runs between ticks, training the last samples is left for
+ * the next tick or simulation_cleanup.
+ *
+ * @param fixed_delta The simulated seconds of a tick.
+ */
+void simulation_tick(double fixed_delta);
+
+/**
+ * @brief Start a new session, moving the ants back to the spawn and placing new food.
+ */
+void simulation_reset(void);
+
+/**
+ * @brief Replace all networks with fresh ones shared as the topology says, training starts over.
+ *
+ * @param new_topology The topology to switch to.
+ */
+void simulation_set_topology(network_topology_t new_topology);
+
+/**
+ * @brief Get the name of a network topology, as accepted by --topology.
+ *
+ * @param topology_type The topology.
+ * @return The name of the topology.
+ */
+const char *simulation_topology_name(network_topology_t topology_type);
+
+/**
+ * @brief Get the training statistics.
+ *
+ * @return A copy of the current statistics.
+ */
+simulation_stats_t simulation_get_stats(void);
+
+/**
+ * @brief Get the time spent in the parts of the ticks.
+ *
+ * @return A copy of the timings since simulation_init.
+ */
+simulation_timings_t simulation_get_timings(void);
+
+/**
+ * @brief Copy the world into a snapshot and publish it to the reader, never blocks.
+ *
+ * Call between ticks from the thread running the simulation.
+ */
+void simulation_publish_snapshot(void);
+
+/**
+ * @brief Check whether the last published snapshot has not been acquired yet.
+ *
+ * A simulation running faster than the reader can skip publishing while this is true.
+ *
+ * @return true if the reader has not taken the last snapshot.
+ */
+bool simulation_snapshot_pending(void);
+
+/**
+ * @brief Get the newest published snapshot, never blocks.
+ *
+ * Call from one reader thread only.
+ *
+ * @return The snapshot, valid until the next call. It is empty before the first snapshot is published.
+ */
+const world_snapshot_t *simulation_acquire_snapshot(void);
+
+/**
+ * @brief Print the speed and accuracy of the first network at several sparsity levels.
+ */
+void simulation_report_pruning(void);
+
+/**
+ * @brief Run ticks as fast as possible until the --ticks or --duration limit and print the throughput.
+ */
+void simulation_run_headless(void);
+
+/**
+ * @brief Write the requested outputs and free everything the simulation owns.
  */
-int start(int argc, char **argv);
+void simulation_cleanup(void);
 
-#endif /* SIMULATION_H */
\ No newline at end of file
+#endif /* SIMULATION_H */
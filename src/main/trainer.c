@@ -0,0 +1,67 @@
+#include "main/trainer.h"
+
+#include <math.h>
+
+bool trainer_init(trainer_t *trainer, neural_network_t *net, int first_member, int members, int batch_size,
+                  double learning_rate, long convergence_window) {
+  if (!trainer || !net || first_member < 0 || members <= 0 || batch_size <= 0) {
+    return false;
+  }
+
+  trainer->net = net;
+  trainer->learning_rate = learning_rate;
+  trainer->epoch = 0;
+  trainer->loss = NAN;
+  trainer->first_member = first_member;
+  trainer->members = members;
+  trainer->batch_size = batch_size;
+  convergence_init(&trainer->convergence, convergence_window);
+  dyn_arr_init(trainer->inputs);
+  dyn_arr_init(trainer->outputs);
+  if (!trainer->inputs.data || !trainer->outputs.data) {
+    dyn_arr_free(trainer->inputs);
+    dyn_arr_free(trainer->outputs);
+    return false;
+  }
+
+  return true;
+}
+
+bool trainer_add_sample(trainer_t *trainer, const double *inputs, const double *outputs) {
+  const int input_size = trainer->net->neuron_counts[0];
+  const int output_size = trainer->net->neuron_counts[trainer->net->num_layers - 1];
+  dyn_arr_pusharr(trainer->inputs, inputs, input_size);
+  dyn_arr_pusharr(trainer->outputs, outputs, output_size);
+
+  return trainer_pending(trainer) >= trainer->batch_size;
+}
+
+int trainer_pending(const trainer_t *trainer) { return trainer->inputs.length / trainer->net->neuron_counts[0]; }
+
+double trainer_step(trainer_t *trainer) {
+  const int m = trainer_pending(trainer);
+  if (m == 0) {
+    return NAN;
+  }
+
+  const matrix_t input_matrix = {trainer->inputs.data, m, trainer->net->neuron_counts[0]};
+  const matrix_t output_matrix = {trainer->outputs.data, m, trainer->net->neuron_counts[trainer->net->num_layers - 1]};
+  const double cost = neural_train(trainer->net, &input_matrix, &output_matrix, trainer->learning_rate);
+  trainer->epoch++;
+  trainer->loss = cost;
+  dyn_arr_clear(trainer->inputs);
+  dyn_arr_clear(trainer->outputs);
+
+  return cost;
+}
+
+void trainer_free(trainer_t *trainer) {
+  if (!trainer) {
+    return;
+  }
+
+  neural_free(trainer->net);
+  trainer->net = NULL;
+  dyn_arr_free(trainer->inputs);
+  dyn_arr_free(trainer->outputs);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file trainer.h
+ * @brief Training state of one network shared by a group of ants.
+ *
+ * Every network in the simulation has a trainer that owns it, batches the samples of the ants sharing it and
+ * monitors its convergence.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef TRAINER_H
+#define TRAINER_H
+
+#include "neural/convergence.h"
+#include "neural/nn.h"
+#include "util/dynarr.h"
+
+/**
+ * @brief A network and the training state of the ants sharing it.
+ */
+typedef struct {
+  neural_network_t *net;     /**< The network, owned by the trainer */
+  dyn_arr_dbl_t inputs;      /**< Inputs of the pending samples, one row per sample */
+  dyn_arr_dbl_t outputs;     /**< Desired outputs of the pending samples, one row per sample */
+  convergence_t convergence; /**< Convergence monitor of the network */
+  double learning_rate;      /**< Learning rate of the next training step */
+  int epoch;                 /**< Number of training steps so far */
+  double loss;               /**< Cost of the last training step, NAN before the first */
+  int first_member;          /**< Index of the first ant sharing the network, the members are contiguous */
+  int members;               /**< Number of ants sharing the network */
+  int batch_size;            /**< Number of samples per training step */
+} trainer_t;
+
+/**
+ * @brief Initialize a trainer.
+ *
+ * @param trainer The trainer to initialize.
+ * @param net The network to train, freed with the trainer.
+ * @param first_member The index of the first ant sharing the network.
+ * @param members The number of ants sharing the network.
+ * @param batch_size The number of samples per training step (at least 1).
+ * @param learning_rate The initial learning rate.
+ * @param convergence_window The number of samples the convergence monitor averages over.
+ * @return true on success, false on invalid arguments or allocation failure.
+ */
+bool trainer_init(trainer_t *trainer, neural_network_t *net, int first_member, int members, int batch_size,
+                  double learning_rate, long convergence_window);
+
+/**
+ * @brief Add a sample to the pending batch of a trainer.
+ *
+ * @param trainer The trainer.
+ * @param inputs The network inputs of the sample.
+ * @param outputs The desired network outputs of the sample.
+ * @return true if the pending batch is full and ready for trainer_step.
+ */
+bool trainer_add_sample(trainer_t *trainer, const double *inputs, const double *outputs);
+
+/**
+ * @brief Get the number of pending samples of a trainer.
+ *
+ * @param trainer The trainer.
+ * @return The number of samples that the next training step uses.
+ */
+int trainer_pending(const trainer_t *trainer);
+
+/**
+ * @brief Train the network on the pending samples with the learning rate of the trainer and clear them.
+ *
+ * Counts the epoch, decaying the learning rate is up to the caller.
+ *
+ * @param trainer The trainer.
+ * @return The cost of the batch, NAN if there were no pending samples.
+ */
+double trainer_step(trainer_t *trainer);
+
+/**
+ * @brief Free the network and the buffers of a trainer.
+ *
+ * @param trainer The trainer to free.
+ */
+void trainer_free(trainer_t *trainer);
+
+#endif /* TRAINER_H */
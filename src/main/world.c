@@ -0,0 +1,213 @@
+#include "main/world.h"
+
+#include <math.h>
+
+static const int max_starting_food_amount = 200;
+static const int min_starting_food_amount = 50;
+static const double food_radius = 40;
+static const double food_detection_radius = 300;
+static const double min_food_distance = 400;
+const vector2d_t g_spawn = {WORLD_W / 2, WORLD_H / 2};
+
+static void free_food(world_t *world);
+static void reset_ants(world_t *world);
+
+world_t *world_create(int num_ants, int food_per_session, uint64_t seed) {
+  if (num_ants <= 0 || food_per_session < 0) {
+    return NULL;
+  }
+
+  world_t *world = calloc(1, sizeof(world_t));
+  if (!world) {
+    return NULL;
+  }
+  world->food_per_session = food_per_session;
+  for (int i = 0; i < WORLD_HEADINGS; i++) {
+    world->headings[i] = v2d_from_angle(i * DEG2RAD_D);
+  }
+  rng_seed(&world->rng, seed);
+  dyn_arr_init(world->ants);
+  dyn_arr_init(world->food);
+  dyn_arr_init(world->commands);
+  world->ant_data = malloc(num_ants * sizeof(ant_t));
+  if (!world->ants.data || !world->food.data || !world->commands.data || !world->ant_data) {
+    world_free(world);
+    return NULL;
+  }
+
+  for (int i = 0; i < num_ants; i++) {
+    ant_t *ant = &world->ant_data[i];
+    ant->net = NULL;
+    ant->group = 0;
+    ant->nearest_food = NULL;
+    ant->spawn = g_spawn;
+    ant->pos = g_spawn;
+    ant->has_food = false;
+    ant->is_coliding = false;
+    rng_seed_stream(&ant->rng, seed, i);
+    ant->heading = world->headings[rng_int(&ant->rng, WORLD_HEADINGS)];
+    dyn_arr_push(world->ants, ant);
+  }
+
+  return world;
+}
+
+void world_reset(world_t *world) {
+  free_food(world);
+  world->random_session = rng_int(&world->rng, 3) != 0;
+  reset_ants(world);
+
+  // Create food away from ants
+  if (!world->random_session || rng_int(&world->rng, 2) == 0) {
+    for (int i = 0; i < world->food_per_session; i++) {
+      vector2d_t food_pos = g_spawn;
+      while (v2d_distance(g_spawn, food_pos) < min_food_distance) {
+        food_pos.x = rng_int(&world->rng, WORLD_W);
+        food_pos.y = rng_int(&world->rng, WORLD_H);
+      }
+      food_t *food =
+          food_create(food_pos, food_radius, food_detection_radius,
+                      rng_int(&world->rng, max_starting_food_amount - min_starting_food_amount) +
+                          min_starting_food_amount);
+      dyn_arr_push(world->food, food);
+    }
+  }
+}
+
+void world_restore_session(world_t *world, bool random_session, const food_t *food, int count) {
+  free_food(world);
+  world->random_session = random_session;
+  reset_ants(world);
+
+  for (int i = 0; i < count; i++) {
+    food_t *copy = food_create(food[i].pos, food[i].radius, food[i].detection_radius, food[i].amount);
+    if (!copy) {
+      fprintf(stderr, "Failed to allocate memory for food\n");
+      exit(EXIT_FAILURE);
+    }
+    dyn_arr_push(world->food, copy);
+  }
+}
+
+void world_scatter(const world_t *world, ant_t *ant) {
+  if (!world->random_session) {
+    return;
+  }
+
+  ant->heading = world->headings[rng_int(&ant->rng, WORLD_HEADINGS)];
+  ant->pos.x = rng_int(&ant->rng, WORLD_W);
+  ant->pos.y = rng_int(&ant->rng, WORLD_H);
+  ant->has_food = rng_int(&ant->rng, 4) == 0;
+  ant->is_coliding = false;
+}
+
+/**
+ * 0: angle cos
+ * 1: angle sin
+ * 2: on spawn
+ * 3: spawn delta cos
+ * 4: spawn delta sin
+ * 5: on food
+ * 6: food delta cos
+ * 7: food delta sin
+ * 8: near food
+ * 9: has food
+ */
+void world_observe(const world_t *world, ant_t *ant, double *observation) {
+  ant_update_nearest_food(ant, &world->food);
+
+  const vector2d_t spawn_vector = v2d_subtract(ant->spawn, ant->pos);
+  const double spawn_vector_length = v2d_length(spawn_vector);
+  observation[0] = ant->heading.x;
+  observation[1] = ant->heading.y;
+  observation[2] = circle_collide_point((circled_t){ant->spawn, ANT_SPAWN_RADIUS}, ant->pos) ? 1.0 : 0.0;
+  observation[3] = spawn_vector_length > 1e-9 ? enc(spawn_vector.x / spawn_vector_length) : enc(-ant->heading.x);
+  observation[4] = spawn_vector_length > 1e-9 ? enc(spawn_vector.y / spawn_vector_length) : enc(-ant->heading.y);
+
+  if (ant->nearest_food) {
+    const food_t *food = ant->nearest_food;
+    const vector2d_t food_vector = v2d_subtract(food->pos, ant->pos);
+    const double food_vector_length = v2d_length(food_vector);
+    observation[5] = circle_collide_point((circled_t){food->pos, food->radius}, ant->pos) ? 1.0 : 0.0;
+    observation[6] = food_vector_length > 1e-9 ? enc(food_vector.x / food_vector_length) : enc(-ant->heading.x);
+    observation[7] = food_vector_length > 1e-9 ? enc(food_vector.y / food_vector_length) : enc(-ant->heading.y);
+  } else {
+    observation[5] = 0.0;
+    observation[6] = 0.0;
+    observation[7] = 0.0;
+  }
+
+  observation[8] = ant->nearest_food ? 1.0 : 0.0;
+  observation[9] = ant->has_food ? 1.0 : 0.0;
+}
+
+// Gathering changes food other ants may be looking at, it is recorded and applied at the end of the tick
+void world_act(ant_t *ant, ant_logic_t logic, double delta_time, command_buffer_t *commands) {
+  if (logic.action == ANT_GATHER_ACTION) {
+    ant_turn(ant, logic.turn_action, delta_time);
+    command_gather(commands, ant);
+  } else {
+    ant_run_update(ant, logic, delta_time);
+  }
+}
+
+void world_finish_tick(world_t *world, command_buffer_t *buffers, int count) {
+  if (command_apply(buffers, count, &world->food) > 0) {
+    // Nearest food is found again next tick, drop the pointers that may dangle now
+    for (int i = 0; i < world->ants.length; i++) {
+      dyn_arr_get(world->ants, i)->nearest_food = NULL;
+    }
+  }
+  world->ticks++;
+  world->session_ticks++;
+}
+
+// FNV-1a over the state the ants and food can change
+uint64_t world_checksum(const world_t *world) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (int i = 0; i < world->ants.length; i++) {
+    const ant_t *ant = dyn_arr_get(world->ants, i);
+    const double values[5] = {ant->pos.x, ant->pos.y, ant->heading.x, ant->heading.y, ant->has_food};
+    const unsigned char *bytes = (const unsigned char *)values;
+    for (size_t b = 0; b < sizeof(values); b++) {
+      hash = (hash ^ bytes[b]) * 0x100000001b3ull;
+    }
+  }
+  for (int i = 0; i < world->food.length; i++) {
+    hash = (hash ^ (uint64_t)dyn_arr_get(world->food, i)->amount) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+void world_free(world_t *world) {
+  if (!world) {
+    return;
+  }
+
+  free_food(world);
+  dyn_arr_free(world->food);
+  dyn_arr_free(world->ants);
+  dyn_arr_free(world->commands);
+  free(world->ant_data);
+  free(world);
+}
+
+// Start a session: ants back at the spawn facing a random direction
+static void reset_ants(world_t *world) {
+  world->session_ticks = 0;
+  for (int i = 0; i < world->ants.length; i++) {
+    ant_t *ant = dyn_arr_get(world->ants, i);
+    ant->pos = g_spawn;
+    ant->nearest_food = NULL;
+    ant->heading = world->headings[rng_int(&ant->rng, WORLD_HEADINGS)];
+    ant->has_food = false;
+    ant->is_coliding = false;
+  }
+}
+
+static void free_food(world_t *world) {
+  for (int i = 0; i < world->food.length; i++) {
+    food_free(dyn_arr_get(world->food, i));
+  }
+  dyn_arr_clear(world->food);
+}
@@ -0,0 +1,138 @@
+/**
+ * @file world.h
+ * @brief One ant world: the ants, the food and the sessions they play.
+ *
+ * A world holds no training state and no globals, any number of worlds can run side by side. The simulation drives
+ * one world and trains networks on it, the batched environment in env.h steps many of them in lockstep.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef ANT_WORLD_H
+#define ANT_WORLD_H
+
+#include "entities/command.h"
+
+// The world is WORLD_SCALE screens wide and high
+#define SCREEN_W 1920
+#define SCREEN_H 1080
+#define WORLD_SCALE 2.0
+#define WORLD_W ((int)(SCREEN_W * WORLD_SCALE))
+#define WORLD_H ((int)(SCREEN_H * WORLD_SCALE))
+
+// Number of values world_observe writes per ant
+#define WORLD_OBSERVATION_SIZE 10
+// Directions ants draw when a session scatters or resets them, one per degree
+#define WORLD_HEADINGS 360
+
+/**
+ * @brief The ants and food of one world.
+ */
+typedef struct {
+  dyn_arr_ant_t ants;                  /**< All ants, they live in one allocation and never change during a run */
+  dyn_arr_food_t food;                 /**< The food of the current session */
+  command_buffer_t commands;           /**< Command buffer for callers updating the ants on one thread */
+  ant_t *ant_data;                     /**< The memory of the ants */
+  rng_t rng;                           /**< Generator for sessions and food placement */
+  int food_per_session;                /**< Number of food sources placed per session */
+  bool random_session;                 /**< Training session that scatters the ants over the world every tick */
+  long ticks;                          /**< Ticks since the world was created */
+  long session_ticks;                  /**< Ticks since the current session started */
+  vector2d_t headings[WORLD_HEADINGS]; /**< Directions ants draw, as unit vectors */
+} world_t;
+
+extern const vector2d_t g_spawn;
+
+/**
+ * @brief Create a world with its ants at the spawn, call world_reset to start the first session.
+ *
+ * Ant i draws from stream i of the seed, so the same seed always gives the same world.
+ *
+ * @param num_ants The number of ants.
+ * @param food_per_session The number of food sources per session.
+ * @param seed The seed of the world and its ants.
+ * @return The world, or NULL on invalid arguments or allocation failure.
+ */
+world_t *world_create(int num_ants, int food_per_session, uint64_t seed);
+
+/**
+ * @brief Start a new session, moving the ants back to the spawn and placing new food.
+ *
+ * @param world The world.
+ */
+void world_reset(world_t *world);
+
+/**
+ * @brief Start a session with given food instead of drawing it, moving the ants back to the spawn.
+ *
+ * Replays use this to start the recorded sessions, the ants draw their directions as in world_reset.
+ *
+ * @param world The world.
+ * @param random_session Whether the ants are scattered over the world every training tick.
+ * @param food The food of the session, copied.
+ * @param count The number of food sources.
+ */
+void world_restore_session(world_t *world, bool random_session, const food_t *food, int count);
+
+/**
+ * @brief Move an ant to a random place, only in random sessions.
+ *
+ * Training calls this before every observation, so the networks see the whole world instead of the paths of the
+ * teacher. Only touches the ant, safe to call for different ants in parallel.
+ *
+ * @param world The world.
+ * @param ant The ant to move.
+ */
+void world_scatter(const world_t *world, ant_t *ant);
+
+/**
+ * @brief Find the nearest food of an ant and encode what it senses.
+ *
+ * Only touches the ant, safe to call for different ants in parallel.
+ *
+ * @param world The world.
+ * @param ant The sensing ant.
+ * @param observation Output of WORLD_OBSERVATION_SIZE values, the network inputs of the ant.
+ */
+void world_observe(const world_t *world, ant_t *ant, double *observation);
+
+/**
+ * @brief Turn and move an ant, taking food is recorded and applied by world_finish_tick.
+ *
+ * Only touches the ant and the command buffer, safe to call for different ants and buffers in parallel.
+ *
+ * @param ant The acting ant.
+ * @param logic What the ant does.
+ * @param delta_time The simulated seconds of the tick.
+ * @param commands The command buffer of the calling thread.
+ */
+void world_act(ant_t *ant, ant_logic_t logic, double delta_time, command_buffer_t *commands);
+
+/**
+ * @brief Apply the commands of a tick in order and count the tick.
+ *
+ * Clears the nearest food of every ant if food was removed, the next world_observe finds it again.
+ *
+ * @param world The world.
+ * @param buffers The command buffers of the tick, in ant order.
+ * @param count The number of command buffers.
+ */
+void world_finish_tick(world_t *world, command_buffer_t *buffers, int count);
+
+/**
+ * @brief Hash the positions, directions and loads of the ants and the amounts of food.
+ *
+ * @param world The world.
+ * @return The hash, equal for worlds in the same state.
+ */
+uint64_t world_checksum(const world_t *world);
+
+/**
+ * @brief Free a world, its ants and its food, the networks of the ants are not freed.
+ *
+ * @param world The world to free.
+ */
+void world_free(world_t *world);
+
+#endif /* ANT_WORLD_H */
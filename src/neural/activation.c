@@ -0,0 +1,67 @@
+#include "neural/activation.h"
+
+#include <math.h>
+
+static const char *activation_names[NEURAL_ACTIVATION_COUNT] = {"sigmoid", "relu", "leaky_relu", "tanh"};
+
+// The loops below are kept branch-free so the compiler can vectorize them (exp/tanh excepted).
+
+void activation_forward(neural_activation_t activation, double *restrict values, int count) {
+  switch (activation) {
+  case NEURAL_RELU:
+    for (int i = 0; i < count; i++) {
+      values[i] = values[i] > 0.0 ? values[i] : 0.0;
+    }
+    break;
+  case NEURAL_LEAKY_RELU:
+    for (int i = 0; i < count; i++) {
+      values[i] = values[i] > 0.0 ? values[i] : NEURAL_LEAKY_RELU_SLOPE * values[i];
+    }
+    break;
+  case NEURAL_TANH:
+    for (int i = 0; i < count; i++) {
+      values[i] = tanh(values[i]);
+    }
+    break;
+  default:
+    for (int i = 0; i < count; i++) {
+      // Clamp so exp() cannot overflow, sigmoid is already saturated there
+      const double x = fmax(-45.0, fmin(45.0, values[i]));
+      values[i] = 1.0 / (1.0 + exp(-x));
+    }
+    break;
+  }
+}
+
+void activation_backward(neural_activation_t activation, const double *restrict outputs, double *restrict delta,
+                         int count) {
+  switch (activation) {
+  case NEURAL_RELU:
+    for (int i = 0; i < count; i++) {
+      delta[i] = outputs[i] > 0.0 ? delta[i] : 0.0;
+    }
+    break;
+  case NEURAL_LEAKY_RELU:
+    for (int i = 0; i < count; i++) {
+      delta[i] *= outputs[i] > 0.0 ? 1.0 : NEURAL_LEAKY_RELU_SLOPE;
+    }
+    break;
+  case NEURAL_TANH:
+    for (int i = 0; i < count; i++) {
+      delta[i] *= 1.0 - outputs[i] * outputs[i];
+    }
+    break;
+  default:
+    for (int i = 0; i < count; i++) {
+      delta[i] *= outputs[i] * (1.0 - outputs[i]);
+    }
+    break;
+  }
+}
+
+const char *activation_name(neural_activation_t activation) {
+  if (activation < 0 || activation >= NEURAL_ACTIVATION_COUNT) {
+    return "unknown";
+  }
+  return activation_names[activation];
+}
@@ -0,0 +1,52 @@
+/**
+ * @file activation.h
+ * @brief Activation functions for the neural network layers.
+ *
+ * Every activation has a forward kernel applied to a whole layer output and a derivative kernel expressed in terms
+ * of that output, so backpropagation never needs the pre-activation values.
+ */
+#pragma once
+#ifndef ACTIVATION_H
+#define ACTIVATION_H
+
+#define NEURAL_LEAKY_RELU_SLOPE 0.01
+
+/**
+ * @brief Activation function of a layer.
+ */
+typedef enum {
+  NEURAL_SIGMOID,    /**< 1 / (1 + e^-x), output in (0, 1) */
+  NEURAL_RELU,       /**< max(0, x) */
+  NEURAL_LEAKY_RELU, /**< x for x > 0, NEURAL_LEAKY_RELU_SLOPE * x otherwise */
+  NEURAL_TANH,       /**< tanh(x), output in (-1, 1) */
+  NEURAL_ACTIVATION_COUNT,
+} neural_activation_t;
+
+/**
+ * @brief Apply an activation function in place.
+ *
+ * @param activation The activation function.
+ * @param values The pre-activation values, replaced by the activated values.
+ * @param count The number of values.
+ */
+void activation_forward(neural_activation_t activation, double *values, int count);
+
+/**
+ * @brief Multiply a gradient by the derivative of an activation function in place.
+ *
+ * @param activation The activation function.
+ * @param outputs The activated values the derivative is taken at.
+ * @param delta The gradient with respect to the outputs, replaced by the gradient with respect to the inputs.
+ * @param count The number of values.
+ */
+void activation_backward(neural_activation_t activation, const double *outputs, double *delta, int count);
+
+/**
+ * @brief Get the name of an activation function.
+ *
+ * @param activation The activation function.
+ * @return The name of the activation function, or "unknown".
+ */
+const char *activation_name(neural_activation_t activation);
+
+#endif /* ACTIVATION_H */
@@ -0,0 +1,266 @@
+#include "neural/autotune.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/util.h"
+
+typedef struct {
+  matrix_op_t op;
+  int rows;
+  int inner;
+  int cols;
+  matrix_kernel_t kernel;
+} autotune_entry_t;
+
+static const char *op_names[MATRIX_OP_COUNT] = {"multiply", "transformA", "transformB"};
+
+static autotune_entry_t entries[AUTOTUNE_MAX_ENTRIES];
+static int entry_count = 0;
+static int generation = 0;
+
+static autotune_entry_t *find_entry(matrix_op_t op, int rows, int inner, int cols);
+static void record_entry(matrix_op_t op, int rows, int inner, int cols, matrix_kernel_t kernel);
+static bool tune_if_missing(matrix_op_t op, int rows, int inner, int cols);
+static void run_kernel(matrix_op_t op, const matrix_t *A, const matrix_t *B, matrix_t *result, matrix_kernel_t kernel);
+static double time_kernel(matrix_op_t op, const matrix_t *A, const matrix_t *B, matrix_t *result,
+                          matrix_kernel_t kernel);
+
+matrix_kernel_t autotune_lookup(matrix_op_t op, int rows, int inner, int cols) {
+  const autotune_entry_t *entry = find_entry(op, rows, inner, cols);
+  if (entry) {
+    return entry->kernel;
+  }
+
+  // Fall back to the closest tuned shape, batch sizes vary slightly between calls (e.g. 1000 vs 1012 samples)
+  double best_distance = AUTOTUNE_MAX_SHAPE_DISTANCE;
+  matrix_kernel_t kernel = MATRIX_KERNEL_NAIVE;
+  for (int i = 0; i < entry_count; i++) {
+    const autotune_entry_t *candidate = &entries[i];
+    if (candidate->op != op) {
+      continue;
+    }
+
+    const double distance = fabs(log((double)candidate->rows / rows)) + fabs(log((double)candidate->inner / inner)) +
+                            fabs(log((double)candidate->cols / cols));
+    if (distance < best_distance) {
+      best_distance = distance;
+      kernel = candidate->kernel;
+    }
+  }
+  return kernel;
+}
+
+matrix_kernel_t autotune_benchmark(matrix_op_t op, int rows, int inner, int cols) {
+  if (op < 0 || op >= MATRIX_OP_COUNT || rows <= 0 || inner <= 0 || cols <= 0) {
+    return MATRIX_KERNEL_NAIVE;
+  }
+
+  // Operand shapes for result (rows x cols) with the shared dimension inner
+  matrix_t A = {NULL, rows, inner};
+  matrix_t B = {NULL, inner, cols};
+  if (op == MATRIX_OP_TRANSFORM_A) {
+    A = (matrix_t){NULL, inner, rows};
+  } else if (op == MATRIX_OP_TRANSFORM_B) {
+    B = (matrix_t){NULL, cols, inner};
+  }
+  matrix_t result = {NULL, rows, cols};
+
+  const size_t A_items = (size_t)A.rows * A.cols;
+  const size_t B_items = (size_t)B.rows * B.cols;
+  const size_t result_items = (size_t)result.rows * result.cols;
+  double *data = malloc((A_items + B_items + result_items) * sizeof(double));
+  if (!data) {
+    return MATRIX_KERNEL_NAIVE;
+  }
+  A.data = data;
+  B.data = A.data + A_items;
+  result.data = B.data + B_items;
+
+  // Deterministic values in [-1, 1), independent of the run seed
+  unsigned int state = 12345u;
+  for (size_t i = 0; i < A_items + B_items; i++) {
+    state = state * 1103515245u + 12345u;
+    data[i] = (double)(state >> 8) / (double)(1u << 23) - 1.0;
+  }
+  memset(result.data, 0, result_items * sizeof(double));
+
+  matrix_kernel_t best_kernel = MATRIX_KERNEL_NAIVE;
+  double best_time = time_kernel(op, &A, &B, &result, MATRIX_KERNEL_NAIVE);
+  for (int kernel = MATRIX_KERNEL_NAIVE + 1; kernel < MATRIX_KERNEL_COUNT; kernel++) {
+    const double kernel_time = time_kernel(op, &A, &B, &result, (matrix_kernel_t)kernel);
+    if (kernel_time < best_time) {
+      best_time = kernel_time;
+      best_kernel = (matrix_kernel_t)kernel;
+    }
+  }
+
+  free(data);
+  record_entry(op, rows, inner, cols, best_kernel);
+  return best_kernel;
+}
+
+int autotune_network(const neural_network_t *network, int m) {
+  if (!network || m <= 0) {
+    return 0;
+  }
+
+  int tuned = 0;
+  for (int l = 1; l < network->num_layers; l++) {
+    const int out_size = network->neuron_counts[l];
+    const int in_size = network->neuron_counts[l - 1];
+
+    // Forward: Z[l] = W[l] * A[l-1]
+    tuned += tune_if_missing(MATRIX_OP_MULTIPLY, out_size, in_size, m);
+    // Weight gradient: dC/dW[l] = delta[l] * A[l-1]^T
+    tuned += tune_if_missing(MATRIX_OP_TRANSFORM_B, out_size, m, in_size);
+    // Hidden delta: dC/dA[l-1] = W[l]^T * delta[l] (not needed for the input layer)
+    if (l > 1) {
+      tuned += tune_if_missing(MATRIX_OP_TRANSFORM_A, in_size, out_size, m);
+    }
+  }
+
+  return tuned;
+}
+
+int autotune_generation(void) { return generation; }
+
+bool autotune_load(const char *path) {
+  if (!path) {
+    return false;
+  }
+
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    return false;
+  }
+
+  char line[128];
+  if (!fgets(line, sizeof(line), fp) || strncmp(line, AUTOTUNE_CACHE_HEADER, strlen(AUTOTUNE_CACHE_HEADER)) != 0) {
+    fclose(fp);
+    return false;
+  }
+
+  while (fgets(line, sizeof(line), fp)) {
+    char op_name[32];
+    char kernel_name[32];
+    int rows, inner, cols;
+    if (sscanf(line, "%31s %d %d %d %31s", op_name, &rows, &inner, &cols, kernel_name) != 5) {
+      continue;
+    }
+
+    const matrix_kernel_t kernel = matrix_kernel_from_name(kernel_name);
+    for (int op = 0; op < MATRIX_OP_COUNT; op++) {
+      if (strcmp(op_name, op_names[op]) == 0 && kernel != MATRIX_KERNEL_COUNT) {
+        record_entry((matrix_op_t)op, rows, inner, cols, kernel);
+        break;
+      }
+    }
+  }
+
+  fclose(fp);
+  return true;
+}
+
+bool autotune_save(const char *path) {
+  if (!path) {
+    return false;
+  }
+
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    fprintf(stderr, "Could not open file %s\n", path);
+    return false;
+  }
+
+  fprintf(fp, "%s\n", AUTOTUNE_CACHE_HEADER);
+  for (int i = 0; i < entry_count; i++) {
+    const autotune_entry_t *entry = &entries[i];
+    fprintf(fp, "%s %d %d %d %s\n", op_names[entry->op], entry->rows, entry->inner, entry->cols,
+            matrix_kernel_name(entry->kernel));
+  }
+
+  const bool ok = !ferror(fp);
+  fclose(fp);
+  if (!ok) {
+    fprintf(stderr, "Could not write to file %s\n", path);
+  }
+  return ok;
+}
+
+void autotune_clear(void) {
+  entry_count = 0;
+  generation++;
+}
+
+static autotune_entry_t *find_entry(matrix_op_t op, int rows, int inner, int cols) {
+  for (int i = 0; i < entry_count; i++) {
+    autotune_entry_t *entry = &entries[i];
+    if (entry->op == op && entry->rows == rows && entry->inner == inner && entry->cols == cols) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void record_entry(matrix_op_t op, int rows, int inner, int cols, matrix_kernel_t kernel) {
+  autotune_entry_t *entry = find_entry(op, rows, inner, cols);
+  if (!entry) {
+    if (entry_count >= AUTOTUNE_MAX_ENTRIES) {
+      return;
+    }
+    entry = &entries[entry_count++];
+  }
+
+  *entry = (autotune_entry_t){op, rows, inner, cols, kernel};
+  generation++;
+}
+
+static bool tune_if_missing(matrix_op_t op, int rows, int inner, int cols) {
+  if (find_entry(op, rows, inner, cols)) {
+    return false;
+  }
+
+  autotune_benchmark(op, rows, inner, cols);
+  return true;
+}
+
+static void run_kernel(matrix_op_t op, const matrix_t *A, const matrix_t *B, matrix_t *result, matrix_kernel_t kernel) {
+  switch (op) {
+  case MATRIX_OP_TRANSFORM_A:
+    matrix_multiply_transformA_kernel(A, B, result, true, kernel);
+    break;
+  case MATRIX_OP_TRANSFORM_B:
+    matrix_multiply_transformB_kernel(A, B, result, true, kernel);
+    break;
+  default:
+    matrix_multiply_append_kernel(A, B, result, kernel);
+    break;
+  }
+}
+
+// Best average time per call over several rounds
+static double time_kernel(matrix_op_t op, const matrix_t *A, const matrix_t *B, matrix_t *result,
+                          matrix_kernel_t kernel) {
+  double best = INFINITY;
+  run_kernel(op, A, B, result, kernel);
+
+  for (int round = 0; round < AUTOTUNE_REPEATS; round++) {
+    long calls = 0;
+    const double start = monotonic_seconds();
+    double elapsed = 0.0;
+    do {
+      // Several calls per clock read so the clock overhead does not dominate tiny shapes
+      for (int i = 0; i < 16; i++) {
+        run_kernel(op, A, B, result, kernel);
+      }
+      calls += 16;
+      elapsed = monotonic_seconds() - start;
+    } while (elapsed < AUTOTUNE_MIN_SECONDS);
+
+    best = fmin(best, elapsed / (double)calls);
+  }
+
+  return best;
+}
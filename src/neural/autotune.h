@@ -0,0 +1,87 @@
+/**
+ * @file autotune.h
+ * @brief Kernel autotuner for the matrix routines used by the neural network.
+ *
+ * The fastest matrix kernel depends on the layer shapes, the batch size and the CPU. The autotuner times every
+ * candidate kernel for the shapes a network actually uses and keeps the winners in a table, which the neural network
+ * dispatches through. The table can be saved to and loaded from a small cache file so tuning only happens once per
+ * machine.
+ */
+#pragma once
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "neural/nn.h"
+
+#define AUTOTUNE_CACHE_HEADER "antmatrix-autotune 1"
+#define AUTOTUNE_MAX_ENTRIES 256
+// Minimum time spent timing each candidate kernel for a shape
+#define AUTOTUNE_MIN_SECONDS 0.002
+#define AUTOTUNE_REPEATS 3
+// Maximum summed log-ratio of the dimensions for a tuned shape to stand in for an untuned one
+#define AUTOTUNE_MAX_SHAPE_DISTANCE 0.7
+
+/**
+ * @brief Look up the tuned kernel for a matrix operation.
+ *
+ * @param op The matrix operation.
+ * @param rows Number of rows of the result.
+ * @param inner Length of the shared (summed over) dimension.
+ * @param cols Number of columns of the result.
+ * @return The tuned kernel for this shape or the closest tuned shape, or MATRIX_KERNEL_NAIVE if none is close.
+ */
+matrix_kernel_t autotune_lookup(matrix_op_t op, int rows, int inner, int cols);
+
+/**
+ * @brief Time every kernel for a matrix operation and record the fastest one.
+ *
+ * @param op The matrix operation.
+ * @param rows Number of rows of the result.
+ * @param inner Length of the shared (summed over) dimension.
+ * @param cols Number of columns of the result.
+ * @return The fastest kernel.
+ */
+matrix_kernel_t autotune_benchmark(matrix_op_t op, int rows, int inner, int cols);
+
+/**
+ * @brief Tune every matrix operation used by neural_run and neural_train for a network at a given batch size.
+ *
+ * Shapes that are already in the table are skipped.
+ *
+ * @param network The network to tune for.
+ * @param m The batch size (number of samples per call).
+ * @return The number of shapes that were newly tuned.
+ */
+int autotune_network(const neural_network_t *network, int m);
+
+/**
+ * @brief Get the generation of the tuning table.
+ *
+ * The generation changes every time the table is modified, so cached kernel choices can be invalidated.
+ *
+ * @return The current generation.
+ */
+int autotune_generation(void);
+
+/**
+ * @brief Load tuning results from a cache file, adding them to the table.
+ *
+ * @param path The path of the cache file.
+ * @return true if the file exists and was written for this version of the tuner, false otherwise.
+ */
+bool autotune_load(const char *path);
+
+/**
+ * @brief Save the tuning table to a cache file.
+ *
+ * @param path The path of the cache file.
+ * @return true if the file was written, false otherwise.
+ */
+bool autotune_save(const char *path);
+
+/**
+ * @brief Remove every entry from the tuning table.
+ */
+void autotune_clear(void);
+
+#endif /* AUTOTUNE_H */
@@ -0,0 +1,125 @@
+#include "neural/blas.h"
+
+#include "util/parallel.h"
+
+// Every loop works on restrict pointers with a unit stride so the compiler can vectorize it. Reductions keep four
+// independent accumulators, which vectorizes without reassociating floating point math.
+
+void blas_axpy(double alpha, const vector_t *x, vector_t *y) {
+  if (!x || !y || x->rows != y->rows) {
+    return;
+  }
+
+  const double *restrict x_data = x->data;
+  double *restrict y_data = y->data;
+  const int n = x->rows;
+  PARALLEL_FOR_IF(n >= PARALLEL_MIN_WORK)
+  for (int i = 0; i < n; i++) {
+    y_data[i] += alpha * x_data[i];
+  }
+}
+
+void blas_scale(double alpha, vector_t *x) {
+  if (!x) {
+    return;
+  }
+
+  double *restrict x_data = x->data;
+  const int n = x->rows;
+  PARALLEL_FOR_IF(n >= PARALLEL_MIN_WORK)
+  for (int i = 0; i < n; i++) {
+    x_data[i] *= alpha;
+  }
+}
+
+void blas_scaled_difference(double alpha, const vector_t *a, const vector_t *b, vector_t *result) {
+  if (!a || !b || !result || a->rows != b->rows || a->rows != result->rows) {
+    return;
+  }
+
+  // No restrict here, result may alias a or b (each element is only read before it is written)
+  const double *a_data = a->data;
+  const double *b_data = b->data;
+  double *result_data = result->data;
+  const int n = a->rows;
+  PARALLEL_FOR_IF(n >= PARALLEL_MIN_WORK)
+  for (int i = 0; i < n; i++) {
+    result_data[i] = alpha * (a_data[i] - b_data[i]);
+  }
+}
+
+void blas_hadamard(const vector_t *x, vector_t *y) {
+  if (!x || !y || x->rows != y->rows) {
+    return;
+  }
+
+  const double *restrict x_data = x->data;
+  double *restrict y_data = y->data;
+  const int n = x->rows;
+  PARALLEL_FOR_IF(n >= PARALLEL_MIN_WORK)
+  for (int i = 0; i < n; i++) {
+    y_data[i] *= x_data[i];
+  }
+}
+
+double blas_dot(const vector_t *x, const vector_t *y) {
+  if (!x || !y || x->rows != y->rows) {
+    return 0.0;
+  }
+
+  const double *restrict x_data = x->data;
+  const double *restrict y_data = y->data;
+  const int n = x->rows;
+  double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+  int i = 0;
+  for (; i + 3 < n; i += 4) {
+    s0 += x_data[i] * y_data[i];
+    s1 += x_data[i + 1] * y_data[i + 1];
+    s2 += x_data[i + 2] * y_data[i + 2];
+    s3 += x_data[i + 3] * y_data[i + 3];
+  }
+  for (; i < n; i++) {
+    s0 += x_data[i] * y_data[i];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+void blas_row_sum_axpy(double alpha, const matrix_t *A, vector_t *y) {
+  if (!A || !y || A->rows != y->rows) {
+    return;
+  }
+
+  const int m = A->cols;
+  PARALLEL_FOR_IF(A->rows * m >= PARALLEL_MIN_WORK)
+  for (int i = 0; i < A->rows; i++) {
+    const double *restrict A_i = A->data + i * m;
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    int j = 0;
+    for (; j + 3 < m; j += 4) {
+      s0 += A_i[j];
+      s1 += A_i[j + 1];
+      s2 += A_i[j + 2];
+      s3 += A_i[j + 3];
+    }
+    for (; j < m; j++) {
+      s0 += A_i[j];
+    }
+    y->data[i] += alpha * ((s0 + s1) + (s2 + s3));
+  }
+}
+
+void blas_broadcast_columns(const vector_t *x, matrix_t *A) {
+  if (!x || !A || x->rows != A->rows) {
+    return;
+  }
+
+  const int m = A->cols;
+  PARALLEL_FOR_IF(A->rows * m >= PARALLEL_MIN_WORK)
+  for (int i = 0; i < A->rows; i++) {
+    double *restrict A_i = A->data + i * m;
+    const double value = x->data[i];
+    for (int j = 0; j < m; j++) {
+      A_i[j] = value;
+    }
+  }
+}
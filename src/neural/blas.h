@@ -0,0 +1,85 @@
+/**
+ * @file blas.h
+ * @brief Vectorized BLAS-1 style primitives for the neural network.
+ *
+ * Elementwise and reduction kernels over vector_t and matrix_t used by training and inference. A matrix can be used
+ * wherever a vector is expected through matrix_flatten. Outputs may alias inputs only where noted.
+ */
+#pragma once
+#ifndef BLAS_H
+#define BLAS_H
+
+#include "neural/matrix.h"
+
+/**
+ * @brief View all elements of a matrix as one vector.
+ *
+ * @param matrix The matrix.
+ * @return A vector sharing the data of the matrix.
+ */
+static inline vector_t matrix_flatten(const matrix_t *matrix) {
+  return (vector_t){matrix->data, matrix->rows * matrix->cols};
+}
+
+/**
+ * @brief y = alpha * x + y
+ *
+ * @param alpha The scale of x.
+ * @param x The vector to add.
+ * @param y The vector to add to, same size as x.
+ */
+void blas_axpy(double alpha, const vector_t *x, vector_t *y);
+
+/**
+ * @brief x = alpha * x
+ *
+ * @param alpha The scale.
+ * @param x The vector to scale.
+ */
+void blas_scale(double alpha, vector_t *x);
+
+/**
+ * @brief result = alpha * (a - b)
+ *
+ * @param alpha The scale of the difference.
+ * @param a The vector to subtract from.
+ * @param b The vector to subtract, same size as a.
+ * @param result The result, same size as a, may alias a or b.
+ */
+void blas_scaled_difference(double alpha, const vector_t *a, const vector_t *b, vector_t *result);
+
+/**
+ * @brief y = x ∘ y (elementwise product)
+ *
+ * @param x The vector to multiply by.
+ * @param y The vector to multiply, same size as x.
+ */
+void blas_hadamard(const vector_t *x, vector_t *y);
+
+/**
+ * @brief Fused multiply-reduce, the dot product x · y.
+ *
+ * @param x The first vector.
+ * @param y The second vector, same size as x.
+ * @return The sum of the elementwise products.
+ */
+double blas_dot(const vector_t *x, const vector_t *y);
+
+/**
+ * @brief y = alpha * A 1 + y, add the scaled sum of each row of A.
+ *
+ * @param alpha The scale of the row sums.
+ * @param A The matrix (n x m).
+ * @param y The vector to add to (n).
+ */
+void blas_row_sum_axpy(double alpha, const matrix_t *A, vector_t *y);
+
+/**
+ * @brief Set every column of A to x.
+ *
+ * @param x The column vector (n).
+ * @param A The matrix to fill (n x m).
+ */
+void blas_broadcast_columns(const vector_t *x, matrix_t *A);
+
+#endif /* BLAS_H */
@@ -0,0 +1,40 @@
+#include "neural/convergence.h"
+
+#include <stddef.h>
+
+void convergence_init(convergence_t *convergence, long window) {
+  if (!convergence) {
+    return;
+  }
+
+  window = window < 1 ? 1 : window;
+  convergence->agreement = 0.0;
+  convergence->loss = 1.0;
+  convergence->smoothing = 1.0 / (double)window;
+  convergence->samples = 0;
+  convergence->window = window;
+  convergence->frozen = false;
+}
+
+bool convergence_update(convergence_t *convergence, bool agreed, double loss) {
+  if (!convergence) {
+    return false;
+  }
+
+  convergence->agreement += convergence->smoothing * ((agreed ? 1.0 : 0.0) - convergence->agreement);
+  convergence->loss += convergence->smoothing * (loss - convergence->loss);
+  convergence->samples++;
+
+  if (!convergence->frozen) {
+    if (convergence->samples >= convergence->window && convergence->agreement >= CONVERGENCE_FREEZE_AGREEMENT &&
+        convergence->loss <= CONVERGENCE_FREEZE_LOSS) {
+      convergence->frozen = true;
+      return true;
+    }
+  } else if (convergence->agreement < CONVERGENCE_UNFREEZE_AGREEMENT) {
+    convergence->frozen = false;
+    return true;
+  }
+
+  return false;
+}
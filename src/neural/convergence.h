@@ -0,0 +1,49 @@
+/**
+ * @file convergence.h
+ * @brief Convergence monitor deciding when a network can stop training.
+ *
+ * Tracks how often the network agrees with its teacher and a smoothed loss, both as exponential moving averages.
+ * The network is frozen once both are good enough and unfrozen when agreement drops again. The gap between the
+ * freeze and unfreeze thresholds keeps it from flipping back and forth on noise.
+ */
+#pragma once
+#ifndef CONVERGENCE_H
+#define CONVERGENCE_H
+
+#include <stdbool.h>
+
+#define CONVERGENCE_FREEZE_AGREEMENT 0.97
+#define CONVERGENCE_UNFREEZE_AGREEMENT 0.90
+#define CONVERGENCE_FREEZE_LOSS 0.02
+
+/**
+ * @brief Convergence state of one network.
+ */
+typedef struct {
+  double agreement; /**< Smoothed share of samples where the network agreed with the teacher */
+  double loss;      /**< Smoothed loss of the network on the teacher labels */
+  double smoothing; /**< Weight of a new sample in the moving averages */
+  long samples;     /**< Number of samples seen since the last reset */
+  long window;      /**< Number of samples the averages cover, also the minimum before freezing */
+  bool frozen;      /**< Whether the network is considered converged */
+} convergence_t;
+
+/**
+ * @brief Reset a convergence monitor.
+ *
+ * @param convergence The monitor to reset.
+ * @param window The number of samples the moving averages cover (at least 1).
+ */
+void convergence_init(convergence_t *convergence, long window);
+
+/**
+ * @brief Add a sample to a convergence monitor and update its frozen state.
+ *
+ * @param convergence The monitor to update.
+ * @param agreed Whether the network made the same decision as the teacher.
+ * @param loss The loss of the network output on the teacher label.
+ * @return true if the frozen state changed, false otherwise.
+ */
+bool convergence_update(convergence_t *convergence, bool agreed, double loss);
+
+#endif /* CONVERGENCE_H */
@@ -0,0 +1,385 @@
+#include "neural/dataset.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct dataset_buffer {
+  struct dataset_buffer *next;
+  int count;
+  double *inputs;
+  double *outputs;
+  double *weights;
+} dataset_buffer_t;
+
+// The chunk a producer fills, on its own cache line
+typedef struct {
+  _Alignas(64) dataset_buffer_t *buffer;
+  long dropped;
+} dataset_producer_t;
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint32_t inputs;
+  uint32_t outputs;
+  uint32_t chunk_samples;
+} dataset_header_t;
+
+typedef struct {
+  uint64_t count;
+} dataset_chunk_header_t;
+
+struct dataset_writer {
+  FILE *file;
+  int inputs;
+  int outputs;
+  int num_producers;
+  dataset_producer_t *producers;
+
+  // Full chunks in the order they were handed over and buffers ready for reuse, guarded by the mutex
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t queued;
+  dataset_buffer_t *full_head;
+  dataset_buffer_t *full_tail;
+  dataset_buffer_t *free_list;
+  int buffers;
+  bool closing;
+
+  // Only the writer thread touches these until it is joined
+  long samples;
+  bool failed;
+};
+
+// Largest input and output count and chunk size a file may declare, keeps the chunk sizes far from overflowing
+#define DATASET_MAX_WIDTH (1 << 20)
+
+static const unsigned char zeros[DATASET_PAGE_SIZE];
+
+static void *write_chunks(void *arg);
+static void write_chunk(dataset_writer_t *writer, const dataset_buffer_t *buffer);
+static size_t write_padded(dataset_writer_t *writer, const void *data, size_t bytes, size_t alignment);
+static void write_zeros(dataset_writer_t *writer, size_t bytes);
+static void queue_buffer(dataset_writer_t *writer, dataset_buffer_t *buffer);
+static dataset_buffer_t *take_buffer(dataset_writer_t *writer);
+static dataset_buffer_t *create_buffer(int inputs, int outputs);
+static void free_buffers(dataset_buffer_t *buffer);
+static size_t align_up(size_t bytes, size_t alignment);
+static size_t chunk_bytes(long count, int inputs, int outputs);
+
+#pragma region writer
+
+dataset_writer_t *dataset_writer_open(const char *path, int inputs, int outputs, int producers) {
+  if (!path || inputs <= 0 || outputs <= 0 || producers <= 0) {
+    return NULL;
+  }
+
+  dataset_writer_t *writer = calloc(1, sizeof(dataset_writer_t));
+  if (!writer) {
+    return NULL;
+  }
+  writer->inputs = inputs;
+  writer->outputs = outputs;
+  writer->num_producers = producers;
+  writer->producers = aligned_alloc(_Alignof(dataset_producer_t), producers * sizeof(dataset_producer_t));
+  writer->file = fopen(path, "wb");
+  if (!writer->producers || !writer->file) {
+    if (writer->file) {
+      fclose(writer->file);
+    }
+    free(writer->producers);
+    free(writer);
+    return NULL;
+  }
+  for (int i = 0; i < producers; i++) {
+    writer->producers[i] = (dataset_producer_t){.buffer = create_buffer(inputs, outputs)};
+    writer->buffers += writer->producers[i].buffer != NULL;
+  }
+
+  dataset_header_t header = {
+      .version = DATASET_VERSION, .inputs = inputs, .outputs = outputs, .chunk_samples = DATASET_CHUNK_SAMPLES};
+  memcpy(header.magic, DATASET_MAGIC, sizeof(header.magic));
+  write_padded(writer, &header, sizeof(header), DATASET_PAGE_SIZE);
+
+  pthread_mutex_init(&writer->mutex, NULL);
+  pthread_cond_init(&writer->queued, NULL);
+  if (pthread_create(&writer->thread, NULL, write_chunks, writer) != 0) {
+    fprintf(stderr, "Failed to create the dataset writer thread\n");
+    exit(EXIT_FAILURE);
+  }
+  return writer;
+}
+
+void dataset_write(dataset_writer_t *writer, int producer, const double *inputs, const double *outputs,
+                   double weight) {
+  dataset_producer_t *state = &writer->producers[producer];
+  if (!state->buffer) {
+    // The writer thread fell behind, try to get a buffer back
+    state->buffer = take_buffer(writer);
+    if (!state->buffer) {
+      state->dropped++;
+      return;
+    }
+  }
+
+  dataset_buffer_t *buffer = state->buffer;
+  memcpy(buffer->inputs + (size_t)buffer->count * writer->inputs, inputs, writer->inputs * sizeof(double));
+  memcpy(buffer->outputs + (size_t)buffer->count * writer->outputs, outputs, writer->outputs * sizeof(double));
+  buffer->weights[buffer->count++] = weight;
+
+  if (buffer->count == DATASET_CHUNK_SAMPLES) {
+    queue_buffer(writer, buffer);
+    state->buffer = take_buffer(writer);
+  }
+}
+
+long dataset_writer_close(dataset_writer_t *writer, long *dropped) {
+  if (!writer) {
+    return 0;
+  }
+
+  long dropped_samples = 0;
+  for (int i = 0; i < writer->num_producers; i++) {
+    dataset_buffer_t *buffer = writer->producers[i].buffer;
+    if (buffer && buffer->count > 0) {
+      queue_buffer(writer, buffer);
+    } else {
+      free_buffers(buffer);
+    }
+    dropped_samples += writer->producers[i].dropped;
+  }
+
+  pthread_mutex_lock(&writer->mutex);
+  writer->closing = true;
+  pthread_cond_signal(&writer->queued);
+  pthread_mutex_unlock(&writer->mutex);
+  pthread_join(writer->thread, NULL);
+
+  const bool failed = writer->failed | (fclose(writer->file) != 0);
+  const long samples = failed ? -1 : writer->samples;
+  if (dropped) {
+    *dropped = dropped_samples;
+  }
+
+  pthread_mutex_destroy(&writer->mutex);
+  pthread_cond_destroy(&writer->queued);
+  free_buffers(writer->free_list);
+  free(writer->producers);
+  free(writer);
+  return samples;
+}
+
+static void queue_buffer(dataset_writer_t *writer, dataset_buffer_t *buffer) {
+  buffer->next = NULL;
+  pthread_mutex_lock(&writer->mutex);
+  if (writer->full_tail) {
+    writer->full_tail->next = buffer;
+  } else {
+    writer->full_head = buffer;
+  }
+  writer->full_tail = buffer;
+  pthread_cond_signal(&writer->queued);
+  pthread_mutex_unlock(&writer->mutex);
+}
+
+// Reuse a written buffer, or create one while fewer than DATASET_MAX_CHUNKS are queued. NULL if the disk is behind
+static dataset_buffer_t *take_buffer(dataset_writer_t *writer) {
+  pthread_mutex_lock(&writer->mutex);
+  dataset_buffer_t *buffer = writer->free_list;
+  if (buffer) {
+    writer->free_list = buffer->next;
+  }
+  const bool create = !buffer && writer->buffers < writer->num_producers + DATASET_MAX_CHUNKS;
+  writer->buffers += create;
+  pthread_mutex_unlock(&writer->mutex);
+
+  if (create) {
+    buffer = create_buffer(writer->inputs, writer->outputs);
+    if (!buffer) {
+      pthread_mutex_lock(&writer->mutex);
+      writer->buffers--;
+      pthread_mutex_unlock(&writer->mutex);
+    }
+  }
+  if (buffer) {
+    buffer->next = NULL;
+    buffer->count = 0;
+  }
+  return buffer;
+}
+
+static void *write_chunks(void *arg) {
+  dataset_writer_t *writer = arg;
+
+  pthread_mutex_lock(&writer->mutex);
+  while (true) {
+    while (!writer->full_head && !writer->closing) {
+      pthread_cond_wait(&writer->queued, &writer->mutex);
+    }
+    dataset_buffer_t *buffer = writer->full_head;
+    if (!buffer) {
+      break;
+    }
+    writer->full_head = buffer->next;
+    if (!writer->full_head) {
+      writer->full_tail = NULL;
+    }
+    pthread_mutex_unlock(&writer->mutex);
+
+    write_chunk(writer, buffer);
+
+    pthread_mutex_lock(&writer->mutex);
+    buffer->next = writer->free_list;
+    writer->free_list = buffer;
+  }
+  pthread_mutex_unlock(&writer->mutex);
+  return NULL;
+}
+
+static void write_chunk(dataset_writer_t *writer, const dataset_buffer_t *buffer) {
+  const dataset_chunk_header_t header = {.count = (uint64_t)buffer->count};
+  const size_t count = buffer->count;
+  size_t written = write_padded(writer, &header, sizeof(header), DATASET_ALIGNMENT);
+  written += write_padded(writer, buffer->inputs, count * writer->inputs * sizeof(double), DATASET_ALIGNMENT);
+  written += write_padded(writer, buffer->outputs, count * writer->outputs * sizeof(double), DATASET_ALIGNMENT);
+  written += write_padded(writer, buffer->weights, count * sizeof(double), DATASET_ALIGNMENT);
+  // The next chunk starts on a page
+  write_zeros(writer, chunk_bytes(buffer->count, writer->inputs, writer->outputs) - written);
+  fflush(writer->file);
+  writer->samples += buffer->count;
+}
+
+// Write the data followed by zeros up to a multiple of the alignment, returns the bytes written
+static size_t write_padded(dataset_writer_t *writer, const void *data, size_t bytes, size_t alignment) {
+  writer->failed |= bytes > 0 && fwrite(data, 1, bytes, writer->file) != bytes;
+  write_zeros(writer, align_up(bytes, alignment) - bytes);
+  return align_up(bytes, alignment);
+}
+
+static void write_zeros(dataset_writer_t *writer, size_t bytes) {
+  for (size_t written = 0; written < bytes; written += sizeof(zeros)) {
+    const size_t length = bytes - written < sizeof(zeros) ? bytes - written : sizeof(zeros);
+    writer->failed |= fwrite(zeros, 1, length, writer->file) != length;
+  }
+}
+
+static dataset_buffer_t *create_buffer(int inputs, int outputs) {
+  dataset_buffer_t *buffer = calloc(1, sizeof(dataset_buffer_t));
+  if (!buffer) {
+    return NULL;
+  }
+  buffer->inputs = aligned_alloc(DATASET_ALIGNMENT, align_up(DATASET_CHUNK_SAMPLES * inputs * sizeof(double),
+                                                             DATASET_ALIGNMENT));
+  buffer->outputs = aligned_alloc(DATASET_ALIGNMENT, align_up(DATASET_CHUNK_SAMPLES * outputs * sizeof(double),
+                                                              DATASET_ALIGNMENT));
+  buffer->weights = aligned_alloc(DATASET_ALIGNMENT, DATASET_CHUNK_SAMPLES * sizeof(double));
+  if (!buffer->inputs || !buffer->outputs || !buffer->weights) {
+    free_buffers(buffer);
+    return NULL;
+  }
+  return buffer;
+}
+
+static void free_buffers(dataset_buffer_t *buffer) {
+  while (buffer) {
+    dataset_buffer_t *next = buffer->next;
+    free(buffer->inputs);
+    free(buffer->outputs);
+    free(buffer->weights);
+    free(buffer);
+    buffer = next;
+  }
+}
+
+#pragma endregion
+
+#pragma region reader
+
+dataset_t *dataset_open(const char *path) {
+  const int fd = path ? open(path, O_RDONLY) : -1;
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat file_stat;
+  const bool has_header = fstat(fd, &file_stat) == 0 && file_stat.st_size >= DATASET_PAGE_SIZE;
+  void *map = has_header ? mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  dataset_t *dataset = calloc(1, sizeof(dataset_t));
+  dataset_header_t header;
+  memcpy(&header, map, sizeof(header));
+  if (!dataset || memcmp(header.magic, DATASET_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != DATASET_VERSION || header.inputs == 0 || header.inputs > DATASET_MAX_WIDTH ||
+      header.outputs == 0 || header.outputs > DATASET_MAX_WIDTH || header.chunk_samples == 0 ||
+      header.chunk_samples > DATASET_MAX_WIDTH) {
+    munmap(map, file_stat.st_size);
+    free(dataset);
+    return NULL;
+  }
+  dataset->inputs = (int)header.inputs;
+  dataset->outputs = (int)header.outputs;
+  dataset->map = map;
+  dataset->map_size = file_stat.st_size;
+
+  // Walk the chunks, all but the last few are full
+  const size_t size = dataset->map_size;
+  const size_t max_chunks = size / DATASET_PAGE_SIZE;
+  dataset->chunks = malloc(max_chunks * sizeof(dataset_chunk_t));
+  if (!dataset->chunks) {
+    dataset_close(dataset);
+    return NULL;
+  }
+  for (size_t offset = DATASET_PAGE_SIZE; offset + DATASET_ALIGNMENT <= size;) {
+    const unsigned char *chunk = (const unsigned char *)map + offset;
+    dataset_chunk_header_t chunk_header;
+    memcpy(&chunk_header, chunk, sizeof(chunk_header));
+    if (chunk_header.count == 0 || chunk_header.count > header.chunk_samples ||
+        offset + chunk_bytes((long)chunk_header.count, dataset->inputs, dataset->outputs) > size) {
+      break;
+    }
+
+    const int count = (int)chunk_header.count;
+    const size_t input_bytes = align_up((size_t)count * dataset->inputs * sizeof(double), DATASET_ALIGNMENT);
+    const size_t output_bytes = align_up((size_t)count * dataset->outputs * sizeof(double), DATASET_ALIGNMENT);
+    dataset->chunks[dataset->num_chunks++] = (dataset_chunk_t){
+        .count = count,
+        .inputs = (const double *)(chunk + DATASET_ALIGNMENT),
+        .outputs = (const double *)(chunk + DATASET_ALIGNMENT + input_bytes),
+        .weights = (const double *)(chunk + DATASET_ALIGNMENT + input_bytes + output_bytes),
+    };
+    dataset->samples += count;
+    offset += chunk_bytes(count, dataset->inputs, dataset->outputs);
+  }
+  return dataset;
+}
+
+void dataset_close(dataset_t *dataset) {
+  if (!dataset) {
+    return;
+  }
+  munmap(dataset->map, dataset->map_size);
+  free(dataset->chunks);
+  free(dataset);
+}
+
+#pragma endregion
+
+static size_t align_up(size_t bytes, size_t alignment) { return (bytes + alignment - 1) / alignment * alignment; }
+
+// Bytes of a chunk of count samples, its header and columns padded to a page
+static size_t chunk_bytes(long count, int inputs, int outputs) {
+  const size_t columns = align_up(count * inputs * sizeof(double), DATASET_ALIGNMENT) +
+                         align_up(count * outputs * sizeof(double), DATASET_ALIGNMENT) +
+                         align_up(count * sizeof(double), DATASET_ALIGNMENT);
+  return align_up(DATASET_ALIGNMENT + columns, DATASET_PAGE_SIZE);
+}
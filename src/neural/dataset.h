@@ -0,0 +1,116 @@
+/**
+ * @file dataset.h
+ * @brief Append-only columnar files of training samples, written in chunks on a background thread and read with mmap.
+ *
+ * A sample is an input vector, the target outputs and a weight. Every producer thread fills its own chunk of
+ * DATASET_CHUNK_SAMPLES samples without locking and hands full chunks to a writer thread, so adding a sample never
+ * waits for the disk. If the disk falls DATASET_MAX_CHUNKS chunks behind, samples are dropped and counted rather than
+ * stalling the producers.
+ *
+ * Layout: a header page (DATASET_MAGIC, version, input and output counts, samples per chunk) followed by chunks. A
+ * chunk starts on a page boundary with a DATASET_ALIGNMENT byte header holding its sample count, then the inputs,
+ * outputs and weights of its samples as three row-major columns, each starting on a DATASET_ALIGNMENT boundary. All
+ * values are doubles in host byte order. Chunks are appended whole, so a file being written is always readable up to
+ * its last complete chunk.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DATASET_MAGIC "AMDS"
+#define DATASET_VERSION 1
+// Samples per chunk, a chunk of 10 inputs and 6 outputs is about 544 KiB
+#define DATASET_CHUNK_SAMPLES 4096
+// Full chunks waiting for the writer thread before samples are dropped
+#define DATASET_MAX_CHUNKS 64
+// Alignment of the columns, a cache line
+#define DATASET_ALIGNMENT 64
+// Alignment of the header and the chunks, a page
+#define DATASET_PAGE_SIZE 4096
+
+/**
+ * @brief Writer of a dataset file, opaque.
+ */
+typedef struct dataset_writer dataset_writer_t;
+
+/**
+ * @brief One chunk of a mapped dataset.
+ */
+typedef struct {
+  int count;             /**< Number of samples */
+  const double *inputs;  /**< count rows of dataset_t.inputs values */
+  const double *outputs; /**< count rows of dataset_t.outputs values */
+  const double *weights; /**< count weights */
+} dataset_chunk_t;
+
+/**
+ * @brief A dataset file mapped into memory.
+ */
+typedef struct {
+  int inputs;              /**< Values per input vector */
+  int outputs;             /**< Values per output vector */
+  long samples;            /**< Samples in all complete chunks */
+  int num_chunks;          /**< Number of complete chunks */
+  dataset_chunk_t *chunks; /**< The complete chunks, pointing into the mapping */
+  void *map;               /**< The mapping of the file */
+  size_t map_size;         /**< Bytes mapped */
+} dataset_t;
+
+/**
+ * @brief Create a dataset file and start its writer thread.
+ *
+ * @param path The file to write.
+ * @param inputs Values per input vector.
+ * @param outputs Values per output vector.
+ * @param producers Number of threads adding samples, each passes its own index to dataset_write.
+ * @return The writer, or NULL on invalid arguments or if the file could not be created.
+ */
+dataset_writer_t *dataset_writer_open(const char *path, int inputs, int outputs, int producers);
+
+/**
+ * @brief Add a sample, never waits for the disk.
+ *
+ * Each producer index must only be used by one thread at a time.
+ *
+ * @param writer The writer.
+ * @param producer Index of the calling producer, below the producers given to dataset_writer_open.
+ * @param inputs The input vector.
+ * @param outputs The target outputs.
+ * @param weight The weight of the sample.
+ */
+void dataset_write(dataset_writer_t *writer, int producer, const double *inputs, const double *outputs,
+                   double weight);
+
+/**
+ * @brief Write the partial chunks of all producers, wait for the writer thread and free the writer.
+ *
+ * Call when no producer is adding samples.
+ *
+ * @param writer The writer, may be NULL.
+ * @param dropped Output of the number of samples dropped because the disk fell behind, may be NULL.
+ * @return The number of samples written, or -1 if writing failed.
+ */
+long dataset_writer_close(dataset_writer_t *writer, long *dropped);
+
+/**
+ * @brief Map a dataset file, a file still being written is read up to its last complete chunk.
+ *
+ * @param path The file to read.
+ * @return The dataset, or NULL if the file could not be mapped or is no dataset.
+ */
+dataset_t *dataset_open(const char *path);
+
+/**
+ * @brief Unmap a dataset file and free the dataset.
+ *
+ * @param dataset The dataset, may be NULL.
+ */
+void dataset_close(dataset_t *dataset);
+
+#endif /* DATASET_H */
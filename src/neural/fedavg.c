@@ -0,0 +1,50 @@
+#include "neural/fedavg.h"
+
+#include <math.h>
+
+#include "util/parallel.h"
+
+bool fedavg_mix(neural_network_t *const networks[], int count, double mix) {
+  if (!networks || count <= 0 || !networks[0]) {
+    return false;
+  }
+  for (int k = 1; k < count; k++) {
+    if (!neural_same_shape(networks[0], networks[k])) {
+      fprintf(stderr, "fedavg_mix: network %d does not match the shape of network 0\n", k);
+      return false;
+    }
+  }
+
+  mix = fmax(0.0, fmin(1.0, mix));
+  const int size = neural_parameters(networks[0]).rows;
+  const int num_blocks = (size + FEDAVG_BLOCK_SIZE - 1) / FEDAVG_BLOCK_SIZE;
+  const double count_inv = 1.0 / (double)count;
+
+  // Every block is reduced and written back independently, so blocks can run on different threads without sharing
+  // any output, and the block of every network stays in cache between the two passes.
+  PARALLEL_FOR_IF((long)size * count >= PARALLEL_MIN_WORK)
+  for (int block = 0; block < num_blocks; block++) {
+    const int begin = block * FEDAVG_BLOCK_SIZE;
+    const int length = (begin + FEDAVG_BLOCK_SIZE <= size ? FEDAVG_BLOCK_SIZE : size - begin);
+    double mean[FEDAVG_BLOCK_SIZE] = {0};
+
+    for (int k = 0; k < count; k++) {
+      const double *restrict params = neural_parameters(networks[k]).data + begin;
+      for (int i = 0; i < length; i++) {
+        mean[i] += params[i];
+      }
+    }
+    for (int i = 0; i < length; i++) {
+      mean[i] *= count_inv;
+    }
+
+    for (int k = 0; k < count; k++) {
+      double *restrict params = neural_parameters(networks[k]).data + begin;
+      for (int i = 0; i < length; i++) {
+        params[i] += mix * (mean[i] - params[i]);
+      }
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file fedavg.h
+ * @brief Federated averaging of neural networks that learn the same task.
+ *
+ * Networks trained in isolation on small batches each see only part of the data. Periodically pulling them towards
+ * their mean shares what every network learned with the others.
+ */
+#pragma once
+#ifndef FEDAVG_H
+#define FEDAVG_H
+
+#include "neural/nn.h"
+
+// Number of parameters reduced per parallel work item
+#define FEDAVG_BLOCK_SIZE 256
+
+/**
+ * @brief Move the parameters of every network towards the mean parameters of all networks.
+ *
+ * Every parameter p of every network becomes p + mix * (mean - p), so a mix of 1 replaces all networks by their
+ * average and a mix of 0 leaves them unchanged.
+ *
+ * @param networks The networks to average, all with the same shape (see neural_same_shape).
+ * @param count The number of networks.
+ * @param mix How far to move towards the mean, clamped to [0, 1].
+ * @return true if the networks were averaged, false on invalid arguments or mismatched shapes.
+ */
+bool fedavg_mix(neural_network_t *const networks[], int count, double mix);
+
+#endif /* FEDAVG_H */
@@ -3,6 +3,60 @@
 #include <math.h>
 #include <string.h>
 
+#include "util/parallel.h"
+
+// Tile size (in doubles) for the blocked kernels
+#define MATRIX_BLOCK_SIZE 64
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MATRIX_HAS_VECTOR_EXT 1
+#define MATRIX_VEC_WIDTH 4
+typedef double matrix_vec_t __attribute__((vector_size(MATRIX_VEC_WIDTH * sizeof(double))));
+#else
+#define MATRIX_HAS_VECTOR_EXT 0
+#endif
+
+static const char *kernel_names[MATRIX_KERNEL_COUNT] = {"naive", "blocked", "simd", "dot"};
+
+// Kernels compute the part of the product in [begin, end) of the split dimension: result columns for multiply and
+// transformA, result rows for transformB. zero_init is only used by transformB.
+typedef void (*range_kernel_fn)(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                                int end);
+
+static void multiply_naive(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                           int end);
+static void multiply_blocked(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                             int end);
+static void multiply_simd(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin, int end);
+static void multiply_dot(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin, int end);
+static void transformA_naive(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                             int end);
+static void transformA_blocked(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                               int end);
+static void transformA_simd(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                            int end);
+static void transformA_dot(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                           int end);
+static void transformB_naive(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                             int end);
+static void transformB_blocked(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                               int end);
+static void transformB_simd(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                            int end);
+static void transformB_dot(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                           int end);
+static void run_kernel(range_kernel_fn kernel, const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init,
+                       int count, long work);
+static inline double dot_strided(const double *a, int a_stride, const double *b, int b_stride, int n);
+static inline int min_int(int a, int b) { return a < b ? a : b; }
+
+static const range_kernel_fn multiply_kernels[MATRIX_KERNEL_COUNT] = {multiply_naive, multiply_blocked, multiply_simd,
+                                                                      multiply_dot};
+static const range_kernel_fn transformA_kernels[MATRIX_KERNEL_COUNT] = {transformA_naive, transformA_blocked,
+                                                                        transformA_simd, transformA_dot};
+static const range_kernel_fn transformB_kernels[MATRIX_KERNEL_COUNT] = {transformB_naive, transformB_blocked,
+                                                                        transformB_simd, transformB_dot};
+
 double matrix_get(const matrix_t *matrix, int row, int col) {
   if (!matrix || row < 0 || row >= matrix->rows || col < 0 || col >= matrix->cols) {
     return NAN;
@@ -21,50 +75,244 @@ void matrix_multiply(const matrix_t *A, const matrix_t *B, matrix_t *result) {
 }
 
 void matrix_multiply_append(const matrix_t *A, const matrix_t *B, matrix_t *result) {
+  matrix_multiply_append_kernel(A, B, result, MATRIX_KERNEL_NAIVE);
+}
+
+void matrix_multiply_transformA(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init) {
+  matrix_multiply_transformA_kernel(A, B, result, zero_init, MATRIX_KERNEL_NAIVE);
+}
+
+void matrix_multiply_transformB(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init) {
+  matrix_multiply_transformB_kernel(A, B, result, zero_init, MATRIX_KERNEL_NAIVE);
+}
+
+void matrix_multiply_append_kernel(const matrix_t *A, const matrix_t *B, matrix_t *result, matrix_kernel_t kernel) {
   if (!A || !B || !result || A->cols != B->rows || result->rows != A->rows || result->cols != B->cols) {
     return;
   }
 
+  if (kernel < 0 || kernel >= MATRIX_KERNEL_COUNT) {
+    kernel = MATRIX_KERNEL_NAIVE;
+  }
+  run_kernel(multiply_kernels[kernel], A, B, result, false, result->cols, (long)A->rows * A->cols * B->cols);
+}
+
+void matrix_multiply_transformA_kernel(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init,
+                                       matrix_kernel_t kernel) {
+  if (!A || !B || !result || A->rows != B->rows || result->rows != A->cols || result->cols != B->cols) {
+    return;
+  }
+  if (zero_init) {
+    // Initialize result matrix to zero
+    memset(result->data, 0, result->rows * result->cols * sizeof(double));
+  }
+
+  if (kernel < 0 || kernel >= MATRIX_KERNEL_COUNT) {
+    kernel = MATRIX_KERNEL_NAIVE;
+  }
+  run_kernel(transformA_kernels[kernel], A, B, result, zero_init, result->cols, (long)A->rows * A->cols * B->cols);
+}
+
+void matrix_multiply_transformB_kernel(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init,
+                                       matrix_kernel_t kernel) {
+  if (!A || !B || !result || A->cols != B->cols || result->rows != A->rows || result->cols != B->rows) {
+    return;
+  }
+
+  if (kernel < 0 || kernel >= MATRIX_KERNEL_COUNT) {
+    kernel = MATRIX_KERNEL_NAIVE;
+  }
+  run_kernel(transformB_kernels[kernel], A, B, result, zero_init, result->rows, (long)A->rows * A->cols * B->rows);
+}
+
+const char *matrix_kernel_name(matrix_kernel_t kernel) {
+  if (kernel < 0 || kernel >= MATRIX_KERNEL_COUNT) {
+    return "unknown";
+  }
+  return kernel_names[kernel];
+}
+
+matrix_kernel_t matrix_kernel_from_name(const char *name) {
+  if (!name) {
+    return MATRIX_KERNEL_COUNT;
+  }
+  for (int i = 0; i < MATRIX_KERNEL_COUNT; i++) {
+    if (strcmp(name, kernel_names[i]) == 0) {
+      return (matrix_kernel_t)i;
+    }
+  }
+  return MATRIX_KERNEL_COUNT;
+}
+
+double vector_get(const vector_t *vector, int row) {
+  if (!vector || row < 0 || row >= vector->rows) {
+    return NAN;
+  }
+  return vector->data[row];
+}
+
+// result[:, begin:end] += A * B[:, begin:end]
+static void multiply_naive(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                           int end) {
+  (void)zero_init;
   for (int i = 0; i < A->rows; i++) {
     const double *A_i = A->data + (i * A->cols);
     double *result_i = result->data + (i * result->cols);
     for (int j = 0; j < B->rows; j++) {
       const double *B_j = B->data + (j * B->cols);
       const double A_ij = A_i[j];
-      for (int k = 0; k < B->cols; k++) {
+      for (int k = begin; k < end; k++) {
         result_i[k] += A_ij * B_j[k];
       }
     }
   }
 }
 
-void matrix_multiply_transformA(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init) {
-  if (!A || !B || !result || A->rows != B->rows || result->rows != A->cols || result->cols != B->cols) {
-    return;
+static void multiply_blocked(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                             int end) {
+  (void)zero_init;
+  // Tile the shared dimension and the result columns so a block of B stays in cache for every row of A
+  for (int kk = begin; kk < end; kk += MATRIX_BLOCK_SIZE) {
+    const int k_end = min_int(kk + MATRIX_BLOCK_SIZE, end);
+    for (int jj = 0; jj < B->rows; jj += MATRIX_BLOCK_SIZE) {
+      const int j_end = min_int(jj + MATRIX_BLOCK_SIZE, B->rows);
+      for (int i = 0; i < A->rows; i++) {
+        const double *A_i = A->data + (i * A->cols);
+        double *result_i = result->data + (i * result->cols);
+        for (int j = jj; j < j_end; j++) {
+          const double *B_j = B->data + (j * B->cols);
+          const double A_ij = A_i[j];
+          for (int k = kk; k < k_end; k++) {
+            result_i[k] += A_ij * B_j[k];
+          }
+        }
+      }
+    }
   }
-  if (zero_init) {
-    // Initialize result matrix to zero
-    memset(result->data, 0, result->rows * result->cols * sizeof(double));
+}
+
+static void multiply_simd(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin, int end) {
+#if MATRIX_HAS_VECTOR_EXT
+  (void)zero_init;
+  const int end_vec = end - ((end - begin) % MATRIX_VEC_WIDTH);
+  for (int i = 0; i < A->rows; i++) {
+    const double *A_i = A->data + (i * A->cols);
+    double *result_i = result->data + (i * result->cols);
+    for (int j = 0; j < B->rows; j++) {
+      const double *B_j = B->data + (j * B->cols);
+      const double A_ij = A_i[j];
+      const matrix_vec_t A_ij_vec = {A_ij, A_ij, A_ij, A_ij};
+      for (int k = begin; k < end_vec; k += MATRIX_VEC_WIDTH) {
+        matrix_vec_t r, b;
+        memcpy(&r, result_i + k, sizeof(r));
+        memcpy(&b, B_j + k, sizeof(b));
+        r += A_ij_vec * b;
+        memcpy(result_i + k, &r, sizeof(r));
+      }
+      for (int k = end_vec; k < end; k++) {
+        result_i[k] += A_ij * B_j[k];
+      }
+    }
   }
+#else
+  multiply_naive(A, B, result, zero_init, begin, end);
+#endif
+}
 
+static void multiply_dot(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin, int end) {
+  (void)zero_init;
+  for (int i = 0; i < A->rows; i++) {
+    const double *A_i = A->data + (i * A->cols);
+    double *result_i = result->data + (i * result->cols);
+    for (int k = begin; k < end; k++) {
+      result_i[k] += dot_strided(A_i, 1, B->data + k, B->cols, A->cols);
+    }
+  }
+}
+
+// result[:, begin:end] += A^T * B[:, begin:end]
+static void transformA_naive(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                             int end) {
+  (void)zero_init;
   for (int j = 0; j < B->rows; j++) {
     const double *A_j = A->data + (j * A->cols);
     const double *B_j = B->data + (j * B->cols);
     for (int i = 0; i < A->cols; i++) {
       const double A_ij = A_j[i];
       double *result_i = result->data + (i * result->cols);
-      for (int k = 0; k < B->cols; k++) {
+      for (int k = begin; k < end; k++) {
         result_i[k] += A_ij * B_j[k];
       }
     }
   }
 }
 
-void matrix_multiply_transformB(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init) {
-  if (!A || !B || !result || A->cols != B->cols || result->rows != A->rows || result->cols != B->rows) {
-    return;
+static void transformA_blocked(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                               int end) {
+  (void)zero_init;
+  for (int ii = 0; ii < A->cols; ii += MATRIX_BLOCK_SIZE) {
+    const int i_end = min_int(ii + MATRIX_BLOCK_SIZE, A->cols);
+    for (int kk = begin; kk < end; kk += MATRIX_BLOCK_SIZE) {
+      const int k_end = min_int(kk + MATRIX_BLOCK_SIZE, end);
+      for (int j = 0; j < B->rows; j++) {
+        const double *A_j = A->data + (j * A->cols);
+        const double *B_j = B->data + (j * B->cols);
+        for (int i = ii; i < i_end; i++) {
+          const double A_ij = A_j[i];
+          double *result_i = result->data + (i * result->cols);
+          for (int k = kk; k < k_end; k++) {
+            result_i[k] += A_ij * B_j[k];
+          }
+        }
+      }
+    }
   }
-  for (int i = 0; i < A->rows; i++) {
+}
+
+static void transformA_simd(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                            int end) {
+#if MATRIX_HAS_VECTOR_EXT
+  (void)zero_init;
+  const int end_vec = end - ((end - begin) % MATRIX_VEC_WIDTH);
+  for (int j = 0; j < B->rows; j++) {
+    const double *A_j = A->data + (j * A->cols);
+    const double *B_j = B->data + (j * B->cols);
+    for (int i = 0; i < A->cols; i++) {
+      const double A_ij = A_j[i];
+      const matrix_vec_t A_ij_vec = {A_ij, A_ij, A_ij, A_ij};
+      double *result_i = result->data + (i * result->cols);
+      for (int k = begin; k < end_vec; k += MATRIX_VEC_WIDTH) {
+        matrix_vec_t r, b;
+        memcpy(&r, result_i + k, sizeof(r));
+        memcpy(&b, B_j + k, sizeof(b));
+        r += A_ij_vec * b;
+        memcpy(result_i + k, &r, sizeof(r));
+      }
+      for (int k = end_vec; k < end; k++) {
+        result_i[k] += A_ij * B_j[k];
+      }
+    }
+  }
+#else
+  transformA_naive(A, B, result, zero_init, begin, end);
+#endif
+}
+
+static void transformA_dot(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                           int end) {
+  (void)zero_init;
+  for (int i = 0; i < A->cols; i++) {
+    double *result_i = result->data + (i * result->cols);
+    for (int k = begin; k < end; k++) {
+      result_i[k] += dot_strided(A->data + i, A->cols, B->data + k, B->cols, A->rows);
+    }
+  }
+}
+
+// result[begin:end, :] (+)= A[begin:end, :] * B^T
+static void transformB_naive(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                             int end) {
+  for (int i = begin; i < end; i++) {
     const double *A_i = A->data + (i * A->cols);
     double *result_i = result->data + (i * result->cols);
     for (int j = 0; j < B->rows; j++) {
@@ -78,9 +326,107 @@ void matrix_multiply_transformB(const matrix_t *A, const matrix_t *B, matrix_t *
   }
 }
 
-double vector_get(const vector_t *vector, int row) {
-  if (!vector || row < 0 || row >= vector->rows) {
-    return NAN;
+static void transformB_blocked(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                               int end) {
+  // Tile the rows of A and B so both blocks stay in cache while their dot products are computed
+  for (int ii = begin; ii < end; ii += MATRIX_BLOCK_SIZE) {
+    const int i_end = min_int(ii + MATRIX_BLOCK_SIZE, end);
+    for (int jj = 0; jj < B->rows; jj += MATRIX_BLOCK_SIZE) {
+      const int j_end = min_int(jj + MATRIX_BLOCK_SIZE, B->rows);
+      for (int i = ii; i < i_end; i++) {
+        const double *A_i = A->data + (i * A->cols);
+        double *result_i = result->data + (i * result->cols);
+        for (int j = jj; j < j_end; j++) {
+          const double *B_j = B->data + (j * B->cols);
+          double sum = 0.0;
+          for (int k = 0; k < A->cols; k++) {
+            sum += A_i[k] * B_j[k];
+          }
+          result_i[j] = zero_init ? sum : result_i[j] + sum;
+        }
+      }
+    }
   }
-  return vector->data[row];
-}
\ No newline at end of file
+}
+
+static void transformB_simd(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                            int end) {
+#if MATRIX_HAS_VECTOR_EXT
+  const int n = A->cols;
+  const int n_vec = n - (n % MATRIX_VEC_WIDTH);
+  for (int i = begin; i < end; i++) {
+    const double *A_i = A->data + (i * A->cols);
+    double *result_i = result->data + (i * result->cols);
+    for (int j = 0; j < B->rows; j++) {
+      const double *B_j = B->data + (j * B->cols);
+      matrix_vec_t acc = {0.0, 0.0, 0.0, 0.0};
+      for (int k = 0; k < n_vec; k += MATRIX_VEC_WIDTH) {
+        matrix_vec_t a, b;
+        memcpy(&a, A_i + k, sizeof(a));
+        memcpy(&b, B_j + k, sizeof(b));
+        acc += a * b;
+      }
+      double sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+      for (int k = n_vec; k < n; k++) {
+        sum += A_i[k] * B_j[k];
+      }
+      result_i[j] = zero_init ? sum : result_i[j] + sum;
+    }
+  }
+#else
+  transformB_naive(A, B, result, zero_init, begin, end);
+#endif
+}
+
+static void transformB_dot(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init, int begin,
+                           int end) {
+  for (int i = begin; i < end; i++) {
+    const double *A_i = A->data + (i * A->cols);
+    double *result_i = result->data + (i * result->cols);
+    for (int j = 0; j < B->rows; j++) {
+      const double sum = dot_strided(A_i, 1, B->data + (j * B->cols), 1, A->cols);
+      result_i[j] = zero_init ? sum : result_i[j] + sum;
+    }
+  }
+}
+
+// Run a kernel over [0, count) of its split dimension, across the OpenMP team when there is enough work
+static void run_kernel(range_kernel_fn kernel, const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init,
+                       int count, long work) {
+#ifdef _OPENMP
+  if (work >= PARALLEL_MIN_WORK && count > 1) {
+#pragma omp parallel
+    {
+      // Contiguous chunks so every thread writes a disjoint part of the result
+      const int threads = omp_get_num_threads();
+      const int chunk = (count + threads - 1) / threads;
+      const int begin = min_int(count, omp_get_thread_num() * chunk);
+      const int end = min_int(count, begin + chunk);
+      if (begin < end) {
+        kernel(A, B, result, zero_init, begin, end);
+      }
+    }
+    return;
+  }
+#else
+  (void)work;
+#endif
+
+  kernel(A, B, result, zero_init, 0, count);
+}
+
+// Dot product of two strided vectors using independent accumulators to hide FMA latency
+static inline double dot_strided(const double *a, int a_stride, const double *b, int b_stride, int n) {
+  double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+  int k = 0;
+  for (; k + 3 < n; k += 4) {
+    s0 += a[k * a_stride] * b[k * b_stride];
+    s1 += a[(k + 1) * a_stride] * b[(k + 1) * b_stride];
+    s2 += a[(k + 2) * a_stride] * b[(k + 2) * b_stride];
+    s3 += a[(k + 3) * a_stride] * b[(k + 3) * b_stride];
+  }
+  for (; k < n; k++) {
+    s0 += a[k * a_stride] * b[k * b_stride];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
@@ -27,6 +27,30 @@ typedef struct {
   int rows;     /**< Number of rows in the vector (n) */
 } vector_t;
 
+/**
+ * @brief Kernel implementations available for the matrix multiplication routines.
+ *
+ * All kernels compute the same product, they only differ in loop order and vectorization. Which one is fastest
+ * depends on the operand shapes and the CPU, see neural/autotune.h.
+ */
+typedef enum {
+  MATRIX_KERNEL_NAIVE,   /**< Straightforward row-major loop order */
+  MATRIX_KERNEL_BLOCKED, /**< Cache-blocked loop order for large operands */
+  MATRIX_KERNEL_SIMD,    /**< Explicitly vectorized inner loop over the result columns */
+  MATRIX_KERNEL_DOT,     /**< Dot-product loop order with multiple accumulators, suited to m = 1 operands */
+  MATRIX_KERNEL_COUNT,   /**< Number of available kernels */
+} matrix_kernel_t;
+
+/**
+ * @brief Matrix multiplication routines that can be dispatched to a kernel.
+ */
+typedef enum {
+  MATRIX_OP_MULTIPLY,    /**< matrix_multiply_append */
+  MATRIX_OP_TRANSFORM_A, /**< matrix_multiply_transformA */
+  MATRIX_OP_TRANSFORM_B, /**< matrix_multiply_transformB */
+  MATRIX_OP_COUNT,       /**< Number of dispatchable routines */
+} matrix_op_t;
+
 /**
  * @brief Get the value at a specific row and column in a matrix.
  *
@@ -77,6 +101,56 @@ void matrix_multiply_transformA(const matrix_t *A, const matrix_t *B, matrix_t *
  */
 void matrix_multiply_transformB(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init);
 
+/**
+ * @brief matrix_multiply_append using a specific kernel.
+ *
+ * @param A Pointer to the first matrix (n x m).
+ * @param B Pointer to the second matrix (m x p).
+ * @param result Pointer to the result matrix (n x p), must be preallocated and initialized.
+ * @param kernel The kernel to use.
+ */
+void matrix_multiply_append_kernel(const matrix_t *A, const matrix_t *B, matrix_t *result, matrix_kernel_t kernel);
+
+/**
+ * @brief matrix_multiply_transformA using a specific kernel.
+ *
+ * @param A Pointer to the first matrix (m x n).
+ * @param B Pointer to the second matrix (m x p).
+ * @param result Pointer to the result matrix (n x p), must be preallocated.
+ * @param zero_init If true, initialize the result matrix to zero before multiplication.
+ * @param kernel The kernel to use.
+ */
+void matrix_multiply_transformA_kernel(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init,
+                                       matrix_kernel_t kernel);
+
+/**
+ * @brief matrix_multiply_transformB using a specific kernel.
+ *
+ * @param A Pointer to the first matrix (n x m).
+ * @param B Pointer to the second matrix (p x m).
+ * @param result Pointer to the result matrix (n x p), must be preallocated.
+ * @param zero_init If true, initialize the result matrix to zero before multiplication.
+ * @param kernel The kernel to use.
+ */
+void matrix_multiply_transformB_kernel(const matrix_t *A, const matrix_t *B, matrix_t *result, bool zero_init,
+                                       matrix_kernel_t kernel);
+
+/**
+ * @brief Get the name of a kernel.
+ *
+ * @param kernel The kernel.
+ * @return The name of the kernel, or "unknown".
+ */
+const char *matrix_kernel_name(matrix_kernel_t kernel);
+
+/**
+ * @brief Get a kernel from its name.
+ *
+ * @param name The name of the kernel as returned by matrix_kernel_name.
+ * @return The kernel, or MATRIX_KERNEL_COUNT if the name is unknown.
+ */
+matrix_kernel_t matrix_kernel_from_name(const char *name);
+
 /**
  * @brief Get the value at a specific row in a vector.
  *
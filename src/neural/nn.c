@@ -4,19 +4,23 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "neural/autotune.h"
+#include "neural/blas.h"
+#include "util/parallel.h"
 #include "util/util.h"
 
 static double calculate_cost(neural_network_t *network, matrix_t y, matrix_t y_hat);
 static void forward_propagate_layer(neural_network_t *network, int layer, const matrix_t A_in, matrix_t A_out);
-static void calculate_output_layer(neural_network_t *network, int output_layer);
+static void select_kernels(neural_network_t *network, int m);
+static inline matrix_kernel_t layer_kernel(const neural_network_t *network, int out_layer, matrix_op_t op);
 static void *allocate_data(neural_network_t *network, int m);
 // static void *allocate_data_Q(neural_network_t *network, int m);
 
-static inline double neural_sigmoid(double x) { return (x > 45 ? 1.0 : (x < -45 ? -1.0 : 1.0 / (1.0 + exp(-x)))); }
 double enc(double x) { return 0.5 * (x + 1.0); }
 double dec(double x) { return 2.0 * x - 1.0; }
 
-neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_array[]) {
+neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_array[],
+                                const neural_activation_t activations_array[]) {
   num_hidden_layers = MAX(0, num_hidden_layers);
   neural_network_t *network = malloc(sizeof(neural_network_t));
   if (!network || !neuron_counts_array || num_hidden_layers < 0 || num_hidden_layers > 100) {
@@ -33,6 +37,10 @@ neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_a
   network->output = NULL;
   network->bias = NULL;
   network->weightsT = NULL;
+  network->activations = NULL;
+  network->kernels = NULL;
+  network->kernels_m = 0;
+  network->kernels_generation = -1;
 
   int weights_size = 0;
   int total_neurons = neuron_counts_array[0];
@@ -61,6 +69,8 @@ neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_a
   size_t required_matrices_data_size = (network->total_weights + network->total_neurons * 2) * sizeof(double);
   required_matrices_data_size +=
       (network->num_layers - 1) * sizeof(matrix_t) + network->num_layers * sizeof(vector_t) * 2;
+  required_matrices_data_size += (network->num_layers - 1) * MATRIX_OP_COUNT * sizeof(matrix_kernel_t);
+  required_matrices_data_size += (network->num_layers - 1) * sizeof(neural_activation_t);
 
   char *data_ptr = (char *)malloc(required_matrices_data_size);
   if (!data_ptr) {
@@ -92,6 +102,19 @@ neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_a
     network->output[i].rows = network->neuron_counts[i];
     data_ptr += network->neuron_counts[i] * sizeof(double);
   }
+  network->kernels = (matrix_kernel_t *)data_ptr;
+  data_ptr += (network->num_layers - 1) * MATRIX_OP_COUNT * sizeof(matrix_kernel_t);
+  select_kernels(network, 1);
+
+  network->activations = (neural_activation_t *)data_ptr;
+  for (int i = 0; i < network->num_layers - 1; i++) {
+    const neural_activation_t activation = activations_array ? activations_array[i] : NEURAL_SIGMOID;
+    if (activation < 0 || activation >= NEURAL_ACTIVATION_COUNT) {
+      neural_free(network);
+      return NULL;
+    }
+    network->activations[i] = activation;
+  }
 
   // Calculate the size of the data used for training and inference (8 is arbitrary)
   allocate_data(network, INITIAL_DATA_SIZE);
@@ -103,15 +126,57 @@ neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_a
   return network;
 }
 
+neural_network_t *neural_clone(const neural_network_t *network) {
+  if (!network) {
+    return NULL;
+  }
+
+  neural_network_t *clone = neural_create(network->num_hidden_layers, network->neuron_counts, network->activations);
+  if (!clone) {
+    return NULL;
+  }
+  memcpy(clone->weightsT[0].data, network->weightsT[0].data,
+         (network->total_weights + network->total_neurons) * sizeof(double));
+
+  return clone;
+}
+
 const vector_t *neural_run(neural_network_t *network, const vector_t *input) {
   memcpy(network->output[0].data, input->data, network->neuron_counts[0] * sizeof(double));
+  select_kernels(network, 1);
   for (int i = 1; i < network->num_layers; i++) {
-    calculate_output_layer(network, i);
+    const matrix_t A_in = {network->output[i - 1].data, network->neuron_counts[i - 1], 1};
+    const matrix_t A_out = {network->output[i].data, network->neuron_counts[i], 1};
+    forward_propagate_layer(network, i - 1, A_in, A_out);
   }
 
   return &network->output[network->num_layers - 1];
 }
 
+matrix_t neural_run_batch(neural_network_t *network, const matrix_t *inputs) {
+  if (!network || !inputs || inputs->rows != network->neuron_counts[0] || inputs->cols <= 0) {
+    return (matrix_t){NULL, 0, 0};
+  }
+
+  // The activations of the layers after the input, laid out as in neural_train
+  const int m = inputs->cols;
+  double *data_ptr = (double *)allocate_data(network, m);
+  if (!data_ptr) {
+    return (matrix_t){NULL, 0, 0};
+  }
+  select_kernels(network, m);
+
+  matrix_t A_in = *inputs;
+  for (int i = 1; i < network->num_layers; i++) {
+    const matrix_t A_out = {data_ptr, network->neuron_counts[i], m};
+    forward_propagate_layer(network, i - 1, A_in, A_out);
+    data_ptr += network->neuron_counts[i] * m;
+    A_in = A_out;
+  }
+
+  return A_in;
+}
+
 double neural_train(neural_network_t *network, const matrix_t *inputs, const matrix_t *desired_outputs, double lr) {
   if (!network || !inputs || !desired_outputs || inputs->cols != network->neuron_counts[0] ||
       desired_outputs->cols != network->neuron_counts[network->num_layers - 1] ||
@@ -136,6 +201,7 @@ double neural_train(neural_network_t *network, const matrix_t *inputs, const mat
   if (!data_ptr) {
     return NAN;
   }
+  select_kernels(network, m);
 
   // Allocate memory for A, delta, dC_db, and dC_dW
   data_ptr += Y_items;
@@ -159,7 +225,7 @@ double neural_train(neural_network_t *network, const matrix_t *inputs, const mat
   }
 
   // Transpose inputs, desired_outputs for Y and A[0]
-  // #pragma omp parallel for
+  PARALLEL_FOR_IF(m * (network->neuron_counts[0] + network->neuron_counts[L]) >= PARALLEL_MIN_WORK)
   for (int j = 0; j < m; j++) {
     const double *do_j = desired_outputs->data + j * network->neuron_counts[L];
     const double *in_j = inputs->data + j * network->neuron_counts[0];
@@ -172,9 +238,6 @@ double neural_train(neural_network_t *network, const matrix_t *inputs, const mat
     }
   }
 
-  // Initialize all of delta to zero
-  memset(delta[0].data, 0, network->total_neurons * m * sizeof(double));
-
   // Feed forward through the network
   for (int i = 0; i < L; i++) {
     forward_propagate_layer(network, i, A[i], A[i + 1]);
@@ -200,23 +263,21 @@ double neural_train(neural_network_t *network, const matrix_t *inputs, const mat
   dC/dW^[l] = (delta^[l])(A^[l-1]^T)
   */
   // Output layer
-  double *bias_L = network->bias[L].data;
-  for (int i = 0; i < network->neuron_counts[L]; i++) {
-    double sum = 0.0;
-    double *delta_Li = delta[L].data + i * m;
-    const double *A_Li = A[L].data + i * m;
-    const double *Y_i = Y.data + i * m;
-    for (int k = 0; k < m; k++) {
-      const double value = m_inv * (A_Li[k] - Y_i[k]);
-      delta_Li[k] = value;
-      sum += value;
-    }
-    // Gradient descent bias
-    bias_L[i] -= lr * sum;
-  }
+  const neural_activation_t output_activation = network->activations[L - 1];
+  const vector_t A_L = matrix_flatten(&A[L]);
+  const vector_t Y_flat = matrix_flatten(&Y);
+  vector_t delta_L = matrix_flatten(&delta[L]);
+  blas_scaled_difference(m_inv, &A_L, &Y_flat, &delta_L);
+  // Sigmoid and cross-entropy cancel out, other activations use squared error and need their derivative
+  if (output_activation != NEURAL_SIGMOID) {
+    activation_backward(output_activation, A_L.data, delta_L.data, delta_L.rows);
+  }
+  // Gradient descent bias
+  blas_row_sum_axpy(-lr, &delta[L], &network->bias[L]);
 
   // dC/dW^L = (delta^L)((A^{L-1})^T)
-  matrix_multiply_transformB(&delta[L], &A[L - 1], &dC_dW[L - 1], true);
+  matrix_multiply_transformB_kernel(&delta[L], &A[L - 1], &dC_dW[L - 1], true,
+                                    layer_kernel(network, L, MATRIX_OP_TRANSFORM_B));
 
   // Hidden layers (1 - L-1)
   for (int l = num_layers - 2; l >= 1; l--) {
@@ -224,63 +285,62 @@ double neural_train(neural_network_t *network, const matrix_t *inputs, const mat
     const matrix_t W_l1_mtr = neural_layer_weightsT(network, l + 1);
     const matrix_t delta_l1 = delta[l + 1];
     matrix_t delta_l = delta[l];
-    const vector_t bias_l = network->bias[l];
-    const matrix_t A_l = A[l];
-
-    matrix_multiply_transformA(&W_l1_mtr, &delta_l1, &delta_l, false);
-
-    // Cache optimized order
-    // #pragma omp parallel for
-    for (int i = 0; i < A_l.rows; i++) {
-      double *delta_li = delta_l.data + i * m;
-      const double *A_li = A_l.data + i * m;
-      double sum = 0.0;
-
-      // delta^l = dC/dA^[l] * dA^[l]/dZ^[l]
-      for (int j = 0; j < m; j++) {
-        delta_li[j] *= (A_li[j] * (1 - A_li[j]));
-        sum += delta_li[j];
-      }
 
-      // Gradient descent bias
-      bias_l.data[i] -= lr * sum;
-    }
+    matrix_multiply_transformA_kernel(&W_l1_mtr, &delta_l1, &delta_l, true,
+                                      layer_kernel(network, l + 1, MATRIX_OP_TRANSFORM_A));
+
+    // delta^l = dC/dA^[l] * dA^[l]/dZ^[l]
+    activation_backward(network->activations[l - 1], A[l].data, delta_l.data, delta_l.rows * m);
+    // Gradient descent bias
+    blas_row_sum_axpy(-lr, &delta_l, &network->bias[l]);
 
     // dC/dW^l = (delta^l)((A^{l-1})^T)
-    matrix_multiply_transformB(&delta_l, &A[l - 1], &dC_dW[l - 1], true);
+    matrix_multiply_transformB_kernel(&delta_l, &A[l - 1], &dC_dW[l - 1], true,
+                                      layer_kernel(network, l, MATRIX_OP_TRANSFORM_B));
   }
 
   // Apply gradient descent on weights
-  // #pragma omp parallel for
-  for (int i = 0; i < network->total_weights; i++) {
-    network->weightsT[0].data[i] -= lr * dC_dW[0].data[i];
-  }
+  // The weights of all layers and their gradients are contiguous, so a single axpy updates them all
+  const vector_t dC_dW_flat = {dC_dW[0].data, network->total_weights};
+  vector_t weights_flat = {network->weightsT[0].data, network->total_weights};
+  blas_axpy(-lr, &dC_dW_flat, &weights_flat);
 
   return cost;
 }
 
-void neural_randomize_weights(neural_network_t *network, double min_weight, double max_weight) {
-  if (!network || !network->weightsT) {
+void neural_randomize_weights(neural_network_t *network, rng_t *rng, double min_weight, double max_weight) {
+  if (!network || !network->weightsT || !rng) {
     return;
   }
 
-  for (int i = 0; i < network->total_weights; i++) {
-    network->weightsT[0].data[i] = min_weight + (max_weight - min_weight) * ((double)rand() / RAND_MAX);
-  }
+  rng_fill_uniform(rng, network->weightsT[0].data, network->total_weights, min_weight, max_weight);
 }
 
-void neural_randomize_bias(neural_network_t *network, double min_bias, double max_bias) {
-  if (!network || !network->bias) {
+void neural_randomize_bias(neural_network_t *network, rng_t *rng, double min_bias, double max_bias) {
+  if (!network || !network->bias || !rng) {
     return;
   }
 
-  for (int i = 0; i < network->total_neurons; i++) {
-    network->bias[0].data[i] = min_bias + (max_bias - min_bias) * ((double)rand() / RAND_MAX);
-  }
+  rng_fill_uniform(rng, network->bias[0].data, network->total_neurons, min_bias, max_bias);
 }
 
 matrix_t neural_layer_weightsT(neural_network_t *network, int out_layer) { return network->weightsT[out_layer - 1]; }
 
+vector_t neural_parameters(neural_network_t *network) {
+  if (!network || !network->weightsT) {
+    return (vector_t){NULL, 0};
+  }
+  return (vector_t){network->weightsT[0].data, network->total_weights + network->total_neurons};
+}
+
+bool neural_same_shape(const neural_network_t *a, const neural_network_t *b) {
+  if (!a || !b || a->num_layers != b->num_layers) {
+    return false;
+  }
+  return memcmp(a->neuron_counts, b->neuron_counts, a->num_layers * sizeof(*a->neuron_counts)) == 0 &&
+         memcmp(a->activations, b->activations, (a->num_layers - 1) * sizeof(*a->activations)) == 0;
+}
+
 void neural_print(neural_network_t *network, FILE *fp) {
   if (!network || !fp) {
     return;
@@ -293,6 +353,11 @@ void neural_print(neural_network_t *network, FILE *fp) {
     fprintf(fp, "Hidden Layer %d: %d neurons\n", i + 1, network->neuron_counts[i + 1]);
   }
   fprintf(fp, "Outputs: %d\n", network->neuron_counts[network->num_hidden_layers + 1]);
+  fprintf(fp, "Activations:");
+  for (int i = 0; i < network->num_layers - 1; i++) {
+    fprintf(fp, " %s", activation_name(network->activations[i]));
+  }
+  fprintf(fp, "\n");
 
   fprintf(fp, "\nWeights:");
   for (int i = 0; i < network->num_hidden_layers + 1; i++) {
@@ -342,28 +407,32 @@ void neural_print(neural_network_t *network, FILE *fp) {
   }
 }
 
-/* bool neural_write(neural_network_t *network, const char *filename) {
+bool neural_write(const neural_network_t *network, const char *filename) {
   if (!network || !filename) {
     return false;
   }
 
   FILE *fp = fopen(filename, "wb");
   if (!fp) {
-    fprintf(stderr, "Could not open file %s", filename);
+    fprintf(stderr, "Could not open file %s\n", filename);
     return false;
   }
 
   int neural_structure[3] = {network->num_hidden_layers, network->total_neurons, network->total_weights};
   fwrite(neural_structure, sizeof(int), sizeof(neural_structure) / sizeof(int), fp);
 
-  // Write neuron counts, weightsT, bias. Ignore output/data
-  fwrite(network->neuron_counts, sizeof(int), network->num_hidden_layers + 2, fp);
-  fwrite(network->weightsT, sizeof(double), network->total_weights, fp);
-  fwrite(network->bias, sizeof(double), network->total_neurons, fp);
+  // Write neuron counts, activations, weightsT, bias. Ignore output/data
+  fwrite(network->neuron_counts, sizeof(int), network->num_layers, fp);
+  for (int i = 0; i < network->num_layers - 1; i++) {
+    const int activation = network->activations[i];
+    fwrite(&activation, sizeof(int), 1, fp);
+  }
+  fwrite(network->weightsT[0].data, sizeof(double), network->total_weights, fp);
+  fwrite(network->bias[0].data, sizeof(double), network->total_neurons, fp);
 
   if (ferror(fp)) {
     fclose(fp);
-    fprintf(stderr, "Could not write to file %s", filename);
+    fprintf(stderr, "Could not write to file %s\n", filename);
     return false;
   }
 
@@ -378,95 +447,53 @@ neural_network_t *neural_read(const char *filename) {
 
   FILE *fp = fopen(filename, "rb");
   if (!fp) {
-    fprintf(stderr, "Could not open file %s", filename);
+    fprintf(stderr, "Could not open file %s\n", filename);
     return NULL;
   }
 
   int neural_structure[3];
-  fread(neural_structure, sizeof(int), sizeof(neural_structure) / sizeof(int), fp);
-  if (ferror(fp) || feof(fp)) {
+  if (fread(neural_structure, sizeof(int), 3, fp) != 3 || neural_structure[0] < 0 || neural_structure[0] > 100) {
     fclose(fp);
-    fprintf(stderr, "Could not read file %s", filename);
+    fprintf(stderr, "Could not read file %s\n", filename);
     return NULL;
   }
 
-  int num_hidden_layers = neural_structure[0];
-  int total_neurons = neural_structure[1];
-  int total_weights = neural_structure[2];
-
-  int *neuron_counts = malloc((num_hidden_layers + 2) * sizeof(int));
-  if (!neuron_counts) {
+  const int num_hidden_layers = neural_structure[0];
+  const int num_layers = num_hidden_layers + 2;
+  int neuron_counts[num_layers];
+  int activation_values[num_layers - 1];
+  neural_activation_t activations[num_layers - 1];
+  if (fread(neuron_counts, sizeof(int), num_layers, fp) != (size_t)num_layers ||
+      fread(activation_values, sizeof(int), num_layers - 1, fp) != (size_t)(num_layers - 1)) {
     fclose(fp);
+    fprintf(stderr, "Could not read file %s\n", filename);
     return NULL;
   }
-  fread(neuron_counts, sizeof(int), num_hidden_layers + 2, fp);
-  if (ferror(fp) || feof(fp)) {
-    free(neuron_counts);
-    fclose(fp);
-    fprintf(stderr, "Could not read file %s", filename);
-    return NULL;
+  for (int i = 0; i < num_layers - 1; i++) {
+    activations[i] = (neural_activation_t)activation_values[i];
   }
 
-  double *weightsT = malloc(total_weights * sizeof(double));
-  if (!weightsT) {
-    free(neuron_counts);
-    fclose(fp);
-    return NULL;
-  }
-  fread(weightsT, sizeof(double), total_weights, fp);
-  if (ferror(fp) || feof(fp)) {
-    free(neuron_counts);
-    free(weightsT);
+  // neural_create validates the sizes and activations, the totals must then match the file
+  neural_network_t *network = neural_create(num_hidden_layers, neuron_counts, activations);
+  if (!network || network->total_neurons != neural_structure[1] || network->total_weights != neural_structure[2]) {
+    neural_free(network);
     fclose(fp);
-    fprintf(stderr, "Could not read file %s", filename);
+    fprintf(stderr, "Invalid neural network in file %s\n", filename);
     return NULL;
   }
 
-  double *bias = malloc(total_neurons * sizeof(double));
-  if (!bias) {
-    free(neuron_counts);
-    free(weightsT);
-    fclose(fp);
-    return NULL;
-  }
-  fread(bias, sizeof(double), total_neurons, fp);
-  if (ferror(fp)) {
-    free(neuron_counts);
-    free(weightsT);
-    free(bias);
+  if (fread(network->weightsT[0].data, sizeof(double), network->total_weights, fp) !=
+          (size_t)network->total_weights ||
+      fread(network->bias[0].data, sizeof(double), network->total_neurons, fp) != (size_t)network->total_neurons) {
+    neural_free(network);
     fclose(fp);
-    fprintf(stderr, "Could not read file %s", filename);
+    fprintf(stderr, "Could not read file %s\n", filename);
     return NULL;
   }
 
   fclose(fp);
-
-  neural_network_t *network = malloc(sizeof(neural_network_t));
-  if (!network) {
-    free(neuron_counts);
-    free(weightsT);
-    free(bias);
-    return NULL;
-  }
-
-  network->num_hidden_layers = num_hidden_layers;
-  network->total_neurons = total_neurons;
-  network->total_weights = total_weights;
-  network->neuron_counts = neuron_counts;
-  network->output = calloc(total_neurons, sizeof(double));
-  network->weightsT = weightsT;
-  network->bias = bias;
-
-  network->data = NULL;
-  network->data_size = 0;
-  allocate_data(network, INITIAL_DATA_SIZE);
-  if (!network->data) {
-    neural_free(network);
-    return NULL;
-  }
-
   return network;
-} */
+}
 
 void neural_free(neural_network_t *network) {
   if (!network) {
@@ -487,6 +514,8 @@ void neural_free(neural_network_t *network) {
   }
   network->weightsT = NULL;
   network->bias = NULL;
+  network->activations = NULL;
+  network->kernels = NULL;
   network->num_hidden_layers = 0;
   network->total_neurons = 0;
   network->total_weights = 0;
@@ -506,12 +535,14 @@ static double calculate_cost(neural_network_t *network, const matrix_t y, const
   const int total = y.rows * m;
 
   // Mean Squared Error (MSE) cost function
-  // const double mx2_inv = 0.5 * m_inv;
-  // for (int i = 0; i < total; ++i) {
-  //   const double diff = y[i] - y_hat[i];
-  //   sum += diff * diff;
-  // }
-  // return mx2_inv * sum;
+  if (network->activations[network->num_layers - 2] != NEURAL_SIGMOID) {
+    const double mx2_inv = 0.5 * m_inv;
+    for (int i = 0; i < total; ++i) {
+      const double diff = y.data[i] - y_hat.data[i];
+      sum += diff * diff;
+    }
+    return mx2_inv * sum;
+  }
 
   // Binary Cross-Entropy (BCE) cost function
   for (int i = 0; i < total; ++i) {
@@ -528,39 +559,35 @@ static void forward_propagate_layer(neural_network_t *network, int in_layer, con
   const matrix_t W = neural_layer_weightsT(network, in_layer + 1);
   const vector_t b = network->bias[in_layer + 1];
 
-  // A[L+1] = sigmoid(Z[L+1]) = W[L+1] * A[L] + b[L+1])
-  for (int i = 0; i < A_out.rows; i++) {
-    double *A_out_i = A_out.data + i * m;
-    for (int j = 0; j < m; ++j) {
-      A_out_i[j] = b.data[i];
-    }
-  }
+  // A[L+1] = f(Z[L+1]) = f(W[L+1] * A[L] + b[L+1])
+  blas_broadcast_columns(&b, &A_out);
 
-  matrix_multiply_append(&W, &A_in, &A_out);
-  for (int i = 0; i < A_out.rows; i++) {
-    double *A_out_i = A_out.data + i * m;
-    for (int j = 0; j < m; ++j) {
-      A_out_i[j] = neural_sigmoid(A_out_i[j]);
-    }
-  }
+  matrix_multiply_append_kernel(&W, &A_in, &A_out, layer_kernel(network, in_layer + 1, MATRIX_OP_MULTIPLY));
+  activation_forward(network->activations[in_layer], A_out.data, A_out.rows * m);
 }
 
-static void calculate_output_layer(neural_network_t *network, int output_layer) {
-  int in_size = network->neuron_counts[output_layer - 1];
-  int out_size = network->neuron_counts[output_layer];
-
-  const double *input = network->output[output_layer - 1].data;
-  double *output = network->output[output_layer].data;
-  const matrix_t weightsT = neural_layer_weightsT(network, output_layer);
-  const double *bias = network->bias[output_layer].data;
+// Pick the tuned kernel of every layer for batch size m, only redone when m or the tuning table changes.
+static void select_kernels(neural_network_t *network, int m) {
+  const int generation = autotune_generation();
+  if (network->kernels_m == m && network->kernels_generation == generation) {
+    return;
+  }
 
-  for (int i = 0; i < out_size; i++) {
-    double sum = bias[i];
-    for (int j = 0; j < in_size; j++) {
-      sum += weightsT.data[i * weightsT.cols + j] * input[j];
-    }
-    output[i] = neural_sigmoid(sum);
+  for (int l = 1; l < network->num_layers; l++) {
+    const int out_size = network->neuron_counts[l];
+    const int in_size = network->neuron_counts[l - 1];
+    matrix_kernel_t *kernels = network->kernels + (l - 1) * MATRIX_OP_COUNT;
+    kernels[MATRIX_OP_MULTIPLY] = autotune_lookup(MATRIX_OP_MULTIPLY, out_size, in_size, m);
+    kernels[MATRIX_OP_TRANSFORM_A] = autotune_lookup(MATRIX_OP_TRANSFORM_A, in_size, out_size, m);
+    kernels[MATRIX_OP_TRANSFORM_B] = autotune_lookup(MATRIX_OP_TRANSFORM_B, out_size, m, in_size);
   }
+
+  network->kernels_m = m;
+  network->kernels_generation = generation;
+}
+
+static inline matrix_kernel_t layer_kernel(const neural_network_t *network, int out_layer, matrix_op_t op) {
+  return network->kernels[(out_layer - 1) * MATRIX_OP_COUNT + op];
 }
 
 // Allocate memory for the data used in training and inference.
@@ -10,7 +10,9 @@
 #ifndef NEURAL_NETWORK_H
 #define NEURAL_NETWORK_H
 
+#include "neural/activation.h"
 #include "neural/matrix.h"
+#include "util/rng.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -25,6 +27,7 @@ typedef struct {
   vector_t *output;   /**< Output of each neuron in the network, array indexed by layer */
   matrix_t *weightsT; /**< Weights for the connections between neurons, stored as transposed, array indexed by layer */
   vector_t *bias;     /**< Biases for each neuron in the network, array indexed by layer */
+  neural_activation_t *activations; /**< Activation function of each layer after the input, indexed by layer - 1 */
   void *data;         /**< Pointer to the data used for training and inference */
   matrix_t Q_data;    /**< Q matrix for storing data used in training and inference */
   size_t data_size;   /**< Size of the data used for training and inference */
@@ -32,6 +35,9 @@ typedef struct {
   int num_layers;        /**< Total number of layers in the network (input + hidden + output) */
   int total_neurons;     /**< Total number of neurons in the network */
   int total_weights;     /**< Total number of weights in the network */
+  matrix_kernel_t *kernels; /**< Matrix kernel for each weight layer and matrix operation, see neural/autotune.h */
+  int kernels_m;            /**< Batch size the kernels were selected for */
+  int kernels_generation;   /**< Autotune table generation the kernels were selected from */
 } neural_network_t;
 
 double enc(double x);
@@ -40,12 +46,25 @@ double dec(double x);
 /**
  * @brief Create a neural network with the specified architecture.
  *
+ * The output layer is trained with binary cross-entropy when it uses NEURAL_SIGMOID and with squared error otherwise.
+ *
  * @param num_hidden_layers The number of hidden layers in the neural network.
  * @param neuron_counts_array An array containing the number of neurons in each layer, including input and output
  * layers.
+ * @param activations_array An array containing the activation function of each layer after the input layer
+ * (num_hidden_layers + 1 entries), or NULL to use NEURAL_SIGMOID for every layer.
  * @return A pointer to the created neural network, or NULL on failure.
  */
-neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_array[]);
+neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_array[],
+                                const neural_activation_t activations_array[]);
+
+/**
+ * @brief Create a copy of a neural network with the same shape and parameters.
+ *
+ * @param network The neural network to copy.
+ * @return A pointer to the copy, or NULL on failure.
+ */
+neural_network_t *neural_clone(const neural_network_t *network);
 
 /**
  * @brief Calculate the output of the neural network for a given input.
@@ -56,6 +75,18 @@ neural_network_t *neural_create(int num_hidden_layers, const int neuron_counts_a
  */
 const vector_t *neural_run(neural_network_t *network, const vector_t *input);
 
+/**
+ * @brief Calculate the outputs of the neural network for a batch of inputs.
+ *
+ * The matrices are feature-major, one column per sample, the layout the layers compute in, so the inputs are read
+ * in place. The outputs live in the training memory of the network until it runs or trains again.
+ *
+ * @param network The neural network to use for calculation.
+ * @param inputs The inputs, one row per input neuron and one column per sample.
+ * @return The outputs, one row per output neuron and one column per sample, or a matrix without data on failure.
+ */
+matrix_t neural_run_batch(neural_network_t *network, const matrix_t *inputs);
+
 /**
  * @brief Train the neural network using backpropagation.
  *
@@ -71,19 +102,21 @@ double neural_train(neural_network_t *network, const matrix_t *inputs, const mat
  * @brief Randomize the weights of the neural network.
  *
  * @param network The neural network to randomize.
+ * @param rng The random number generator to draw the weights from.
  * @param min_weight The minimum weight value.
  * @param max_weight The maximum weight value.
  */
-void neural_randomize_weights(neural_network_t *network, double min_weight, double max_weight);
+void neural_randomize_weights(neural_network_t *network, rng_t *rng, double min_weight, double max_weight);
 
 /**
  * @brief Randomize the biases of the neural network.
  *
  * @param network The neural network to randomize.
+ * @param rng The random number generator to draw the biases from.
  * @param min_bias The minimum bias value.
  * @param max_bias The maximum bias value.
  */
-void neural_randomize_bias(neural_network_t *network, double min_bias, double max_bias);
+void neural_randomize_bias(neural_network_t *network, rng_t *rng, double min_bias, double max_bias);
 
 /**
  * @brief Get the transposed weights for a specific in-layer in the neural network.
@@ -93,6 +126,26 @@ void neural_randomize_bias(neural_network_t *network, double min_bias, double ma
  */
 matrix_t neural_layer_weightsT(neural_network_t *network, int out_layer);
 
+/**
+ * @brief Get all trainable parameters of the neural network as one vector.
+ *
+ * The weights of every layer are followed by the biases of every layer (including the unused input layer biases),
+ * so networks with the same shape can be combined elementwise.
+ *
+ * @param network The neural network.
+ * @return A vector sharing the parameter memory of the network, empty if the network is NULL.
+ */
+vector_t neural_parameters(neural_network_t *network);
+
+/**
+ * @brief Check whether two neural networks have the same layer sizes and activations.
+ *
+ * @param a The first neural network.
+ * @param b The second neural network.
+ * @return true if the networks have the same shape, false otherwise.
+ */
+bool neural_same_shape(const neural_network_t *a, const neural_network_t *b);
+
 /**
  * @brief Print the structure and weights of the neural network.
  *
@@ -101,22 +154,24 @@ matrix_t neural_layer_weightsT(neural_network_t *network, int out_layer);
  */
 void neural_print(neural_network_t *network, FILE *fp);
 
-// /**
-//  * @brief Write the neural network to a file.
-//  *
-//  * @param network The neural network to write.
-//  * @param filename The name of the file to write the neural network to.
-//  * @return True if the write operation was successful, false otherwise.
-//  */
-// bool neural_write(neural_network_t *network, const char *filename);
-
-// /**
-//  * @brief Read a neural network from a file.
-//  *
-//  * @param filename The name of the file to read the neural network from.
-//  * @return A pointer to the read neural network, or NULL on failure.
-//  */
-// neural_network_t *neural_read(const char *filename);
+/**
+ * @brief Write the neural network to a file.
+ *
+ * The binary format holds the layer sizes, the activations, the weights and the biases in native byte order.
+ *
+ * @param network The neural network to write.
+ * @param filename The name of the file to write the neural network to.
+ * @return True if the write operation was successful, false otherwise.
+ */
+bool neural_write(const neural_network_t *network, const char *filename);
+
+/**
+ * @brief Read a neural network from a file.
+ *
+ * @param filename The name of the file to read the neural network from.
+ * @return A pointer to the read neural network, or NULL on failure.
+ */
+neural_network_t *neural_read(const char *filename);
 
 /**
  * @brief Free the memory allocated for the neural network.
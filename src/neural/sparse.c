@@ -0,0 +1,186 @@
+#include "neural/sparse.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  double magnitude;
+  int index;
+} weight_rank_t;
+
+static int compare_rank(const void *a, const void *b) {
+  const weight_rank_t *rank_a = a;
+  const weight_rank_t *rank_b = b;
+  if (rank_a->magnitude != rank_b->magnitude) {
+    return rank_a->magnitude < rank_b->magnitude ? -1 : 1;
+  }
+  return rank_a->index - rank_b->index;
+}
+
+int neural_prune(neural_network_t *network, double sparsity, bool *mask) {
+  if (!network || !network->weightsT) {
+    return -1;
+  }
+
+  const int total = network->total_weights;
+  const int pruned = (int)(fmax(0.0, fmin(1.0, sparsity)) * total);
+  double *weights = network->weightsT[0].data;
+  weight_rank_t *ranks = malloc(total * sizeof(weight_rank_t));
+  if (!ranks) {
+    return -1;
+  }
+
+  for (int i = 0; i < total; i++) {
+    ranks[i] = (weight_rank_t){fabs(weights[i]), i};
+  }
+  qsort(ranks, total, sizeof(weight_rank_t), compare_rank);
+
+  if (mask) {
+    for (int i = 0; i < total; i++) {
+      mask[i] = true;
+    }
+  }
+  for (int i = 0; i < pruned; i++) {
+    weights[ranks[i].index] = 0.0;
+    if (mask) {
+      mask[ranks[i].index] = false;
+    }
+  }
+
+  free(ranks);
+  return pruned;
+}
+
+void neural_apply_mask(neural_network_t *network, const bool *mask) {
+  if (!network || !network->weightsT || !mask) {
+    return;
+  }
+
+  double *restrict weights = network->weightsT[0].data;
+  for (int i = 0; i < network->total_weights; i++) {
+    weights[i] = mask[i] ? weights[i] : 0.0;
+  }
+}
+
+sparse_network_t *sparse_create(const neural_network_t *network) {
+  if (!network || !network->weightsT || network->num_layers < 2) {
+    return NULL;
+  }
+
+  const int num_layers = network->num_layers;
+  int total_nonzeros = 0;
+  int total_row_starts = 0;
+  for (int i = 0; i < network->total_weights; i++) {
+    total_nonzeros += network->weightsT[0].data[i] != 0.0;
+  }
+  for (int l = 1; l < num_layers; l++) {
+    total_row_starts += network->neuron_counts[l] + 1;
+  }
+
+  // One allocation, structures first and then doubles before ints to keep everything aligned
+  size_t size = sizeof(sparse_network_t);
+  size += (num_layers - 1) * sizeof(sparse_matrix_t) + 2 * num_layers * sizeof(vector_t);
+  size += (total_nonzeros + 2 * network->total_neurons) * sizeof(double);
+  size += (total_nonzeros + total_row_starts + num_layers) * sizeof(int);
+  size += (num_layers - 1) * sizeof(neural_activation_t);
+
+  char *data_ptr = malloc(size);
+  if (!data_ptr) {
+    return NULL;
+  }
+
+  sparse_network_t *sparse = (sparse_network_t *)data_ptr;
+  data_ptr += sizeof(sparse_network_t);
+  sparse->num_layers = num_layers;
+  sparse->total_nonzeros = total_nonzeros;
+  sparse->size = size;
+  sparse->weightsT = (sparse_matrix_t *)data_ptr;
+  data_ptr += (num_layers - 1) * sizeof(sparse_matrix_t);
+  sparse->bias = (vector_t *)data_ptr;
+  data_ptr += num_layers * sizeof(vector_t);
+  sparse->output = (vector_t *)data_ptr;
+  data_ptr += num_layers * sizeof(vector_t);
+
+  double *values = (double *)data_ptr;
+  data_ptr += total_nonzeros * sizeof(double);
+  for (int l = 0; l < num_layers; l++) {
+    sparse->bias[l] = (vector_t){(double *)data_ptr, network->neuron_counts[l]};
+    memcpy(sparse->bias[l].data, network->bias[l].data, network->neuron_counts[l] * sizeof(double));
+    data_ptr += network->neuron_counts[l] * sizeof(double);
+  }
+  for (int l = 0; l < num_layers; l++) {
+    sparse->output[l] = (vector_t){(double *)data_ptr, network->neuron_counts[l]};
+    data_ptr += network->neuron_counts[l] * sizeof(double);
+  }
+
+  int *col_indices = (int *)data_ptr;
+  data_ptr += total_nonzeros * sizeof(int);
+  int *row_starts = (int *)data_ptr;
+  data_ptr += total_row_starts * sizeof(int);
+  sparse->neuron_counts = (int *)data_ptr;
+  data_ptr += num_layers * sizeof(int);
+  memcpy(sparse->neuron_counts, network->neuron_counts, num_layers * sizeof(int));
+  sparse->activations = (neural_activation_t *)data_ptr;
+  memcpy(sparse->activations, network->activations, (num_layers - 1) * sizeof(neural_activation_t));
+
+  // Compress every layer, the value and index arrays of all layers are contiguous
+  for (int l = 0; l < num_layers - 1; l++) {
+    const matrix_t *dense = &network->weightsT[l];
+    sparse_matrix_t *matrix = &sparse->weightsT[l];
+    matrix->values = values;
+    matrix->col_indices = col_indices;
+    matrix->row_starts = row_starts;
+    matrix->rows = dense->rows;
+    matrix->cols = dense->cols;
+
+    int nonzeros = 0;
+    for (int i = 0; i < dense->rows; i++) {
+      row_starts[i] = nonzeros;
+      for (int j = 0; j < dense->cols; j++) {
+        const double value = dense->data[i * dense->cols + j];
+        if (value != 0.0) {
+          values[nonzeros] = value;
+          col_indices[nonzeros] = j;
+          nonzeros++;
+        }
+      }
+    }
+    row_starts[dense->rows] = nonzeros;
+    matrix->nonzeros = nonzeros;
+
+    values += nonzeros;
+    col_indices += nonzeros;
+    row_starts += dense->rows + 1;
+  }
+
+  return sparse;
+}
+
+const vector_t *sparse_run(sparse_network_t *network, const vector_t *input) {
+  if (!network || !input || input->rows != network->neuron_counts[0]) {
+    return NULL;
+  }
+
+  memcpy(network->output[0].data, input->data, network->neuron_counts[0] * sizeof(double));
+  for (int l = 1; l < network->num_layers; l++) {
+    const sparse_matrix_t *W = &network->weightsT[l - 1];
+    const double *restrict in = network->output[l - 1].data;
+    double *restrict out = network->output[l].data;
+    const double *restrict bias = network->bias[l].data;
+
+    // A[l] = f(W[l] * A[l - 1] + b[l]) over the stored weights only
+    for (int i = 0; i < W->rows; i++) {
+      double sum = bias[i];
+      for (int k = W->row_starts[i]; k < W->row_starts[i + 1]; k++) {
+        sum += W->values[k] * in[W->col_indices[k]];
+      }
+      out[i] = sum;
+    }
+    activation_forward(network->activations[l - 1], out, W->rows);
+  }
+
+  return &network->output[network->num_layers - 1];
+}
+
+void sparse_free(sparse_network_t *network) { free(network); }
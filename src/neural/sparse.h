@@ -0,0 +1,87 @@
+/**
+ * @file sparse.h
+ * @brief Magnitude pruning and sparse inference for neural networks.
+ *
+ * A pruned network keeps its smallest weights at zero. Converting it to a sparse network stores only the remaining
+ * weights in compressed sparse row (CSR) form, which shrinks the parameters and the multiply-adds of a forward pass
+ * in proportion to the sparsity.
+ */
+#pragma once
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "neural/nn.h"
+
+/**
+ * @brief Matrix in compressed sparse row (CSR) format.
+ */
+typedef struct {
+  double *values;   /**< Nonzero values, row by row */
+  int *col_indices; /**< Column of each nonzero value */
+  int *row_starts;  /**< Index of the first value of each row, rows + 1 entries */
+  int rows;         /**< Number of rows */
+  int cols;         /**< Number of columns */
+  int nonzeros;     /**< Number of stored values */
+} sparse_matrix_t;
+
+/**
+ * @brief Inference-only neural network with sparse weights.
+ */
+typedef struct {
+  int *neuron_counts;               /**< Number of neurons in each layer */
+  sparse_matrix_t *weightsT;        /**< Transposed weights of each layer, indexed by out layer - 1 */
+  vector_t *bias;                   /**< Biases of each layer, indexed by layer */
+  vector_t *output;                 /**< Output of each layer, indexed by layer */
+  neural_activation_t *activations; /**< Activation of each layer after the input, indexed by layer - 1 */
+  int num_layers;                   /**< Number of layers (input + hidden + output) */
+  int total_nonzeros;               /**< Number of stored weights over all layers */
+  size_t size;                      /**< Bytes allocated for the network */
+} sparse_network_t;
+
+/**
+ * @brief Set the smallest weights of a network to zero.
+ *
+ * Biases are never pruned.
+ *
+ * @param network The network to prune.
+ * @param sparsity The share of weights to prune, clamped to [0, 1].
+ * @param mask Optional output of total_weights entries, false for every pruned weight. Can be NULL.
+ * @return The number of pruned weights, or -1 on failure.
+ */
+int neural_prune(neural_network_t *network, double sparsity, bool *mask);
+
+/**
+ * @brief Set the weights removed by a prune mask back to zero, used after fine-tuning a pruned network.
+ *
+ * @param network The pruned network.
+ * @param mask The mask returned by neural_prune.
+ */
+void neural_apply_mask(neural_network_t *network, const bool *mask);
+
+/**
+ * @brief Create a sparse network from the nonzero weights of a network.
+ *
+ * @param network The network to convert, usually pruned first.
+ * @return The sparse network, or NULL on failure.
+ */
+sparse_network_t *sparse_create(const neural_network_t *network);
+
+/**
+ * @brief Calculate the output of a sparse network for a given input.
+ *
+ * Same contract as neural_run.
+ *
+ * @param network The sparse network.
+ * @param input The input data for the network.
+ * @return A pointer to the output of the network, valid until the next call.
+ */
+const vector_t *sparse_run(sparse_network_t *network, const vector_t *input);
+
+/**
+ * @brief Free a sparse network.
+ *
+ * @param network The sparse network to free.
+ */
+void sparse_free(sparse_network_t *network);
+
+#endif /* SPARSE_H */
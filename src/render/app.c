@@ -0,0 +1,497 @@
+#include "render/app.h"
+
+#include <math.h>
+#include <pthread.h>
+
+#include "main/control.h"
+#include "main/simulation.h"
+#include "raymath.h"
+#include "render/draw.h"
+#include "render/gui.h"
+#include "util/scheduler.h"
+
+#pragma region function_declarations
+
+static void input(void);
+static void update(bool render_due);
+static void render(void);
+static bool is_render_due(void);
+static void initialize_window(void);
+static void resize_window(int w, int h);
+static void render_present(void);
+static void *training_thread_func(void *arg);
+static void start_training_thread(void);
+static void stop_training_thread(void);
+static void sync_training_thread(bool force);
+static void send_command(control_command_t command);
+
+#pragma endregion
+
+typedef enum { SINGLE_THREAD, MULTI_THREAD } simulation_mode_t;
+
+/**
+ * @brief Controls of the GUI the training thread has been told about.
+ */
+typedef struct {
+  simulation_settings_t settings; /**< Training switches */
+  network_topology_t topology;    /**< Network topology */
+  bool paused;                    /**< Whether the simulation is paused */
+  bool warp;                      /**< Whether the simulation runs as fast as possible */
+  bool auto_reset;                /**< Whether sessions restart every RESET_TIME */
+} thread_controls_t;
+
+#pragma region setup
+
+bool reset = false;
+bool auto_reset = true;
+bool warp = false;
+bool paused = false;
+int pending_steps = 0;
+network_topology_t pending_topology = ANN_TOPOLOGY;
+// Training switches of the GUI, the simulation takes them between ticks
+simulation_settings_t settings;
+
+// Splits every frame between ticks and rendering, and measures the achieved ticks per second
+scheduler_t scheduler;
+
+int window_w = 1920;
+int window_h = 1080;
+float zoom = 1.0f;
+Vector2 target = {WORLD_W / 2.0f, WORLD_H / 2.0f};
+Vector2 prev_mouse_pos = {0, 0};
+RenderTexture2D offscreen;
+Texture2D ant_texture;
+Rectangle letterbox = {0, 0, SCREEN_W, SCREEN_H};
+
+// In multi-thread mode the GUI only talks to the training thread through the control channel
+pthread_t training_thread = {0};
+control_channel_t channel;
+thread_controls_t sent_controls;
+simulation_mode_t simulation_mode = SINGLE_THREAD;
+
+#pragma endregion
+
+int start(int argc, char **argv) {
+  simulation_options_t options;
+  if (!simulation_parse_options(argc, argv, &options)) {
+    return EXIT_FAILURE;
+  }
+
+  simulation_init(&options);
+  pending_topology = options.topology;
+  settings = g_settings;
+  if (options.headless) {
+    simulation_run_headless();
+    simulation_cleanup();
+    return EXIT_SUCCESS;
+  }
+
+  initialize_window();
+  scheduler_init(&scheduler, FRAME_BUDGET, monotonic_seconds());
+  while (!WindowShouldClose()) {
+    if (IsWindowResized()) {
+      resize_window(GetScreenWidth(), GetScreenHeight());
+    }
+
+    const bool render_due = is_render_due();
+    input();
+    update(render_due);
+    if (render_due) {
+      const double render_start = monotonic_seconds();
+      render();
+      render_present();
+      scheduler_record_render(&scheduler, monotonic_seconds() - render_start);
+    } else {
+      // Presenting a frame polls the input, skipped frames poll it themselves and do not spin in real time
+      PollInputEvents();
+      if (!warp) {
+        WaitTime(FIXED_DELTA);
+      }
+    }
+    scheduler_end_frame(&scheduler, monotonic_seconds());
+  }
+
+  if (simulation_mode == MULTI_THREAD) {
+    stop_training_thread();
+  }
+
+  UnloadRenderTexture(offscreen);
+  UnloadTexture(ant_texture);
+  CloseWindow();
+
+  simulation_cleanup();
+  return EXIT_SUCCESS;
+}
+
+static void input() {
+  Vector2 dir = (Vector2){0, 0};
+  Vector2 mouse_delta = (Vector2){0, 0};
+  float zoom_delta = 0;
+  Vector2 mouse_pos = GetMousePosition();
+  mouse_pos.x = Remap(mouse_pos.x - letterbox.x, 0, window_w - 2 * letterbox.x, 0, SCREEN_W);
+  mouse_pos.y = Remap(mouse_pos.y - letterbox.y, 0, window_h - 2 * letterbox.y, 0, SCREEN_H);
+  mouse_pos = Vector2Scale(mouse_pos, WORLD_SCALE / (WORLD_SCALE * zoom));
+
+  if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+    mouse_delta = Vector2Subtract(prev_mouse_pos, mouse_pos);
+  }
+
+  if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) {
+    dir.x -= 1;
+  }
+  if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) {
+    dir.x += 1;
+  }
+  if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) {
+    dir.y -= 1;
+  }
+  if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) {
+    dir.y += 1;
+  }
+
+  zoom_delta = GetMouseWheelMove();
+  if (zoom_delta != 0) {
+    Vector2 mouse_world_before_pos =
+        Vector2Add(mouse_pos, Vector2Subtract(target, Vector2Scale((Vector2){SCREEN_W / 2.0f, SCREEN_H / 2.0f},
+                                                                   WORLD_SCALE / (WORLD_SCALE * zoom))));
+
+    zoom += zoom_delta * 0.1f;
+    zoom = fmaxf(1.0f / WORLD_SCALE, fminf(zoom, 2.0f));
+    zoom = roundf(zoom * 100.0f) / 100.0f;
+
+    Vector2 mouse_after_pos = GetMousePosition();
+    mouse_after_pos.x = Remap(mouse_after_pos.x - letterbox.x, 0, window_w - 2 * letterbox.x, 0, SCREEN_W);
+    mouse_after_pos.y = Remap(mouse_after_pos.y - letterbox.y, 0, window_h - 2 * letterbox.y, 0, SCREEN_H);
+    mouse_after_pos = Vector2Scale(mouse_after_pos, WORLD_SCALE / (WORLD_SCALE * zoom));
+    const Vector2 mouse_world_after_pos =
+        Vector2Add(mouse_after_pos, Vector2Subtract(target, Vector2Scale((Vector2){SCREEN_W / 2.0f, SCREEN_H / 2.0f},
+                                                                         WORLD_SCALE / (WORLD_SCALE * zoom))));
+
+    const Vector2 world_delta = Vector2Subtract(mouse_world_before_pos, mouse_world_after_pos);
+    target = Vector2Add(target, world_delta);
+  }
+
+  target = Vector2Add(target, Vector2Scale(dir, CAM_SPEED * GetFrameTime()));
+  target = Vector2Add(target, mouse_delta);
+  // Clamp target to world bounds with respect to zoom
+  target.x = fmaxf((SCREEN_W / 2.0f) * (WORLD_SCALE / (WORLD_SCALE * zoom)),
+                   fminf(WORLD_W - ((SCREEN_W / 2.0f) * (WORLD_SCALE / (WORLD_SCALE * zoom))), target.x));
+  target.y = fmaxf((SCREEN_H / 2.0f) * (WORLD_SCALE / (WORLD_SCALE * zoom)),
+                   fminf(WORLD_H - ((SCREEN_H / 2.0f) * (WORLD_SCALE / (WORLD_SCALE * zoom))), target.y));
+
+  prev_mouse_pos = mouse_pos;
+}
+
+static void update(bool render_due) {
+  settings.verbose = simulation_mode == SINGLE_THREAD && !warp;
+  static double simulated_time = 0.0;
+  static bool first = false;
+  static double last_time = 0.0;
+  static double simulation_time = 0.0;
+
+  if (simulation_mode == MULTI_THREAD) {
+    if (reset) {
+      send_command((control_command_t){.type = CONTROL_RESET});
+    }
+    if (pending_steps > 0) {
+      send_command((control_command_t){.type = CONTROL_STEP, .value = pending_steps});
+    }
+    reset = false;
+    pending_steps = 0;
+    sync_training_thread(false);
+    simulation_time = 0.0;
+    return;
+  }
+
+  g_settings = settings;
+  if (reset) {
+    reset = false;
+    first = false;
+    simulation_time = 0.0;
+    simulated_time = 0.0;
+
+    simulation_reset();
+  }
+
+  if (pending_topology != simulation_get_stats().topology) {
+    simulation_set_topology(pending_topology);
+  }
+
+  if (!first) {
+    last_time = GetTime();
+    first = true;
+  }
+  const double current_time = GetTime();
+  const double delta_time = fmin(current_time - last_time, MAX_DELTA);
+
+  last_time = current_time;
+  simulation_time += delta_time;
+
+  // Warp runs every tick that fits the frame, real time the ticks that are due but never more than fit, so a slow
+  // machine runs slower than real time instead of falling further behind every frame. Paused only runs the steps
+  const int budget = scheduler_plan(&scheduler, render_due);
+  const int due = (int)(simulation_time / FIXED_DELTA);
+  const int ticks = paused ? MIN(pending_steps, budget) : warp ? budget : MIN(due, budget);
+  simulation_time = warp || paused ? 0.0 : simulation_time - due * FIXED_DELTA;
+  pending_steps = paused ? pending_steps - ticks : 0;
+
+  const double start = monotonic_seconds();
+  for (int i = 0; i < ticks; i++) {
+    simulated_time += FIXED_DELTA;
+    // Reset simulation every RESET_TIME of simulated time
+    if (simulated_time >= RESET_TIME && auto_reset) {
+      simulation_reset();
+      simulated_time = 0.0;
+    }
+
+    simulation_tick(FIXED_DELTA);
+  }
+  scheduler_record_ticks(&scheduler, ticks, monotonic_seconds() - start);
+  simulation_publish_snapshot();
+}
+
+static void render() {
+  // The world is drawn from a snapshot, the training thread may be changing it meanwhile
+  const world_snapshot_t *snapshot = simulation_acquire_snapshot();
+  simulation_stats_t stats = snapshot->stats;
+  double ticks_per_second = scheduler.ticks_per_second;
+  // The training thread publishes its status more often than snapshots, the snapshot is newer until the first one
+  if (simulation_mode == MULTI_THREAD) {
+    const control_status_t *status = control_status(&channel);
+    if (status->stats.num_networks > 0) {
+      stats = status->stats;
+      ticks_per_second = status->ticks_per_second;
+    }
+  }
+  Camera2D cam = {0};
+  cam.target = target;
+  cam.offset = (Vector2){SCREEN_W / 2.0f, SCREEN_H / 2.0f};
+  cam.rotation = 0.0f;
+  cam.zoom = zoom;
+
+  Vector2 mouse_pos = GetMousePosition();
+  mouse_pos.x = Remap(mouse_pos.x - letterbox.x, 0, window_w - 2 * letterbox.x, 0, SCREEN_W);
+  mouse_pos.y = Remap(mouse_pos.y - letterbox.y, 0, window_h - 2 * letterbox.y, 0, SCREEN_H);
+
+  BeginTextureMode(offscreen);
+  BeginMode2D(cam);
+  ClearBackground(BROWN);
+
+  DrawCircleV(v2d_to_v2(g_spawn), ANT_SPAWN_RADIUS, DARKBLUE);
+  for (int i = 0; i < snapshot->food.length; i++) {
+    food_draw(&dyn_arr_get(snapshot->food, i));
+  }
+  for (int i = 0; i < snapshot->ants.length; i++) {
+    ant_draw(&dyn_arr_get(snapshot->ants, i), ant_texture);
+  }
+  EndMode2D();
+
+  DrawFPS(0, 0);
+  if (gui_draw_button(mouse_pos, (Rectangle){10, 20, 300, 20}, "Reset Speed")) {
+    warp = false;
+  }
+
+  // Button to start runing the simulation from the network
+  if (gui_draw_button(mouse_pos, (Rectangle){SCREEN_W - 350, 10, 300, 20}, "Reset Simulation")) {
+    reset = true;
+  }
+
+  // Checkbox to start runing the simulation from the network
+  settings.training = gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 40}, "Train", settings.training);
+
+  // Checkbox to enable/disable auto reset
+  auto_reset = gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 65}, "Auto Reset", auto_reset);
+
+  // Checkbox to enable/disable warp
+  warp = gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 90}, "Warp", warp);
+
+  Rectangle thread_button_bounds = {SCREEN_W - 350, 115, 300, 20};
+  // Checkbox to do multiple threads
+  if (simulation_mode == SINGLE_THREAD) {
+    if (gui_draw_button(mouse_pos, thread_button_bounds, "Switch to Multi-Thread")) {
+      start_training_thread();
+    }
+  } else if (gui_draw_button(mouse_pos, thread_button_bounds, "Switch to Single-Thread")) {
+    stop_training_thread();
+  }
+
+  // Button to cycle the network topology, switching replaces all networks
+  if (gui_draw_button(mouse_pos, (Rectangle){SCREEN_W - 350, 145, 300, 20},
+                      TextFormat("Topology: %s", simulation_topology_name(stats.topology)))) {
+    pending_topology = (stats.topology + 1) % TOPOLOGY_COUNT;
+  }
+
+  if (stats.num_networks > 1) {
+    settings.model_averaging =
+        gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 175}, "Model Averaging", settings.model_averaging);
+  }
+
+  settings.auto_freeze =
+      gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 200}, "Auto Freeze", settings.auto_freeze);
+  settings.active_training =
+      gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 225}, "Active Training", settings.active_training);
+
+  gui_draw_label((Vector2){10, 45},
+                 TextFormat("Ticks/s: %.0f (%.1fx)", ticks_per_second, ticks_per_second / TICK_RATE));
+  gui_draw_label((Vector2){SCREEN_W - 350, 255},
+                 TextFormat("Teacher Agreement: %.1f%%", stats.teacher_agreement * 100.0));
+  gui_draw_label((Vector2){SCREEN_W - 350, 280},
+                 TextFormat("Frozen Networks: %d/%d", settings.auto_freeze ? stats.frozen_networks : 0,
+                            stats.num_networks));
+  gui_draw_label((Vector2){SCREEN_W - 350, 305},
+                 TextFormat("Active Skip Rate: %.1f%%", settings.active_training ? stats.skip_rate * 100.0 : 0.0));
+  gui_draw_label((Vector2){SCREEN_W - 350, 330}, TextFormat("Loss: %.5f", stats.loss));
+
+  // Button to print the speed and accuracy of the first network at several sparsity levels
+  if (simulation_mode == SINGLE_THREAD && snapshot->ants.length > 0 &&
+      gui_draw_button(mouse_pos, (Rectangle){SCREEN_W - 350, 360, 300, 20}, "Pruning Report")) {
+    simulation_report_pruning();
+  }
+
+  // Checkbox to pause the simulation, the step button runs one tick at a time while paused
+  paused = gui_draw_checkbox(mouse_pos, (Vector2){SCREEN_W - 350, 390}, "Pause", paused);
+  if (paused && gui_draw_button(mouse_pos, (Rectangle){SCREEN_W - 350, 415, 300, 20}, "Step")) {
+    pending_steps++;
+  }
+
+  if (snapshot->net) {
+    gui_draw_neural_network((Vector2){10, 70}, snapshot->net, !snapshot->training);
+  }
+
+  if (snapshot->training) {
+    const float progress_bar_location_x = SCREEN_W / 2.0f;
+    const float progress_bar_width = 300.0f;
+    const Rectangle progress_bar_bounds = {progress_bar_location_x - progress_bar_width / 2.0f, SCREEN_W / 2.0f + 40,
+                                           progress_bar_width, 20};
+    // Learning rate decays logarithmically, so we need to adjust the progress accordingly
+    float progress = 1.0f - log(stats.learning_rate / LEARN_RATE_MIN) / log(LEARN_RATE / LEARN_RATE_MIN);
+    progress = fmaxf(0.0f, fminf(1.0f, progress));
+    gui_draw_progress_bar(progress_bar_bounds, progress, "Training Progress");
+  }
+
+  EndTextureMode();
+}
+
+// Minimized or unfocused windows render a few frames per second and leave the rest of the time to ticks
+static bool is_render_due() {
+  static double last_render = -BACKGROUND_RENDER_INTERVAL;
+  const double now = GetTime();
+  if ((IsWindowMinimized() || !IsWindowFocused()) && now - last_render < BACKGROUND_RENDER_INTERVAL) {
+    return false;
+  }
+
+  last_render = now;
+  return true;
+}
+
+static void initialize_window() {
+  // Initialize raylib
+  SetConfigFlags(FLAG_VSYNC_HINT | FLAG_WINDOW_RESIZABLE | FLAG_WINDOW_ALWAYS_RUN | FLAG_WINDOW_HIGHDPI);
+  SetTraceLogLevel(LOG_DEBUG);
+  InitWindow(1280, 720, "Ant Matrix");
+  SetTargetFPS(TARGET_FPS);
+
+  ant_texture = LoadTexture("assets/ant.png");
+
+  offscreen = LoadRenderTexture(SCREEN_W, SCREEN_H);
+  SetTextureFilter(offscreen.texture, TEXTURE_FILTER_BILINEAR);
+#ifdef __EMSCRIPTEN__
+  resize_window(GetScreenWidth(), GetScreenHeight());
+#else
+  const int height = nearest_16_by_9_height(GetMonitorWidth(GetCurrentMonitor()));
+  resize_window(height * 16 / 9, height);
+  // Position the window in the center of the screen
+  SetWindowPosition((GetMonitorWidth(GetCurrentMonitor()) - window_w) / 2,
+                    (GetMonitorHeight(GetCurrentMonitor()) - window_h) / 2);
+#endif
+}
+
+static void *training_thread_func(void *arg) {
+  (void)arg; // Unused parameter
+  control_run(&channel);
+  return NULL;
+}
+
+// Hand the simulation to a training thread, running as fast as possible like the warp it replaces
+static void start_training_thread() {
+  control_init(&channel);
+  warp = true;
+  // Every control is sent once so the thread starts from the GUI state
+  sent_controls.topology = simulation_get_stats().topology;
+  sync_training_thread(true);
+
+  const int error = pthread_create(&training_thread, NULL, training_thread_func, NULL);
+  if (error != 0) {
+    fprintf(stderr, "Failed to create training thread: %s\n", strerror(error));
+    exit(EXIT_FAILURE);
+  }
+  simulation_mode = MULTI_THREAD;
+}
+
+// The thread takes commands before every tick, so it stops within a tick
+static void stop_training_thread() {
+  while (!control_send(&channel, (control_command_t){.type = CONTROL_STOP})) {
+    WaitTime(CONTROL_IDLE_SLEEP);
+  }
+  pthread_join(training_thread, NULL);
+  simulation_mode = SINGLE_THREAD;
+}
+
+// Send the controls that changed since the last call, or all of them if forced
+static void sync_training_thread(bool force) {
+  if (force || memcmp(&settings, &sent_controls.settings, sizeof(settings)) != 0) {
+    send_command((control_command_t){.type = CONTROL_SETTINGS, .settings = settings});
+  }
+  // Switching the topology replaces the networks, it is only sent when it changes
+  if (pending_topology != sent_controls.topology) {
+    send_command((control_command_t){.type = CONTROL_TOPOLOGY, .value = pending_topology});
+  }
+  if (force || paused != sent_controls.paused) {
+    send_command((control_command_t){.type = CONTROL_PAUSE, .value = paused});
+  }
+  if (force || warp != sent_controls.warp) {
+    send_command((control_command_t){.type = CONTROL_SPEED, .value = warp ? 0.0 : 1.0});
+  }
+  if (force || auto_reset != sent_controls.auto_reset) {
+    send_command((control_command_t){.type = CONTROL_AUTO_RESET, .value = auto_reset});
+  }
+  sent_controls = (thread_controls_t){settings, pending_topology, paused, warp, auto_reset};
+}
+
+// The queue only fills up if the training thread is stuck in a tick, the command is dropped then
+static void send_command(control_command_t command) {
+  if (!control_send(&channel, command)) {
+    fprintf(stderr, "Training thread busy, dropped a command\n");
+  }
+}
+
+static void resize_window(int w, int h) {
+  SetWindowSize(w, h);
+  window_w = w;
+  window_h = h;
+
+  letterbox.width = SCREEN_W;
+  letterbox.height = SCREEN_H;
+
+  const float ratio_x = window_w / (float)SCREEN_W;
+  const float ratio_y = window_h / (float)SCREEN_H;
+  const float ratio = fminf(ratio_x, ratio_y);
+  const float offset_x = (window_w - ratio * SCREEN_W) * 0.5f;
+  const float offset_y = (window_h - ratio * SCREEN_H) * 0.5f;
+  letterbox = (Rectangle){offset_x, offset_y, ratio * SCREEN_W, ratio * SCREEN_H};
+}
+
+static void render_present() {
+  /* render offscreen to display */
+
+  BeginDrawing();
+  ClearBackground(BROWN);
+  DrawRectangle(0, 0, letterbox.x, GetScreenHeight(), WHITE);
+  DrawRectangle(letterbox.x + letterbox.width, 0, GetScreenWidth() - (letterbox.x + letterbox.width), GetScreenHeight(),
+                WHITE);
+
+  const Rectangle render_src = {0, 0, (float)SCREEN_W, -(float)SCREEN_H};
+  const Vector2 render_origin = {0, 0};
+  DrawTexturePro(offscreen.texture, render_src, letterbox, render_origin, 0.0f, WHITE);
+  EndDrawing();
+}
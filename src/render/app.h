@@ -0,0 +1,26 @@
+/**
+ * @file app.h
+ * @brief Window, input and GUI of the ant simulation program.
+ *
+ * Runs the simulation core (main/simulation.h) in a raylib window, or headless with --headless.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef APP_H
+#define APP_H
+
+/**
+ * @brief Start the simulation.
+ *
+ * Initializes the simulation, sets up the window, and runs the main loop. With --headless no window is created and
+ * the ants train as fast as possible, see --help for all options.
+ *
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @return Exit code of the simulation.
+ */
+int start(int argc, char **argv);
+
+#endif /* APP_H */
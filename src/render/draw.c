@@ -0,0 +1,33 @@
+#include "render/draw.h"
+
+Vector2 v2d_to_v2(vector2d_t v) { return (Vector2){(float)v.x, (float)v.y}; }
+vector2d_t v2_to_v2d(Vector2 v) { return (vector2d_t){(double)v.x, (double)v.y}; }
+
+void ant_draw(const ant_pose_t *ant, Texture2D texture) {
+  if (!ant) {
+    return;
+  }
+
+  const Vector2 center = {(texture.width * ANT_SCALE) / 2.0f, (texture.height * ANT_SCALE) / 2.0f};
+  const Rectangle source = {0, 0, texture.width, texture.height};
+  const Rectangle dest = {ant->pos.x, ant->pos.y, (texture.width * ANT_SCALE), (texture.height * ANT_SCALE)};
+  DrawTexturePro(texture, source, dest, center, ant->rotation * RAD2DEG, WHITE);
+
+  DrawCircleV(v2d_to_v2(ant->detector.center), ant->detector.radius,
+              ant->has_food ? (Color){0, 255, 0, 128} : (Color){255, 0, 0, 128});
+}
+
+void food_draw(const food_t *food) {
+  if (!food) {
+    return;
+  }
+  Vector2 ray_pos = v2d_to_v2(food->pos);
+
+  DrawCircleV(ray_pos, (float)food->radius, PURPLE);
+  DrawCircleLinesV(ray_pos, (float)food->detection_radius, DARKPURPLE);
+
+  const char *text = TextFormat("%d", food->amount);
+  const int font_size = 20;
+  const Vector2 text_size = MeasureTextEx(GetFontDefault(), text, font_size, 2);
+  DrawText(text, ray_pos.x - text_size.x / 2, ray_pos.y - text_size.y / 2, font_size, WHITE);
+}
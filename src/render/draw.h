@@ -0,0 +1,47 @@
+/**
+ * @file draw.h
+ * @brief Drawing of the simulation entities with raylib.
+ *
+ * The entities themselves know nothing about raylib, everything that converts them to raylib types or draws them
+ * lives here so the simulation core builds without it.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef DRAW_H
+#define DRAW_H
+
+#include "main/simulation.h"
+#include "raylib.h"
+
+/** @brief Convert a vector2d_t to a Vector2.
+ *
+ * @param v The vector2d_t to convert.
+ * @return The converted Vector2.
+ */
+Vector2 v2d_to_v2(vector2d_t v);
+
+/** @brief Convert a Vector2 to a vector2d_t.
+ *
+ * @param v The Vector2 to convert.
+ * @return The converted vector2d_t.
+ */
+vector2d_t v2_to_v2d(Vector2 v);
+
+/**
+ * @brief Draw an ant.
+ *
+ * @param ant The pose of the ant to draw.
+ * @param texture The texture of the ant.
+ */
+void ant_draw(const ant_pose_t *ant, Texture2D texture);
+
+/**
+ * @brief Draw the food object
+ *
+ * @param food Pointer to the food object
+ */
+void food_draw(const food_t *food);
+
+#endif /* DRAW_H */
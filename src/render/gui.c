@@ -1,4 +1,4 @@
-#include "gui.h"
+#include "render/gui.h"
 
 #include <math.h>
 
@@ -0,0 +1,443 @@
+/**
+ * @file train.c
+ * @brief Offline trainer of the ant network on a teacher dataset written with --dataset.
+ *
+ * A prefetch thread streams the chunks of the mapped dataset in a new random order every epoch through a shuffle
+ * buffer and assembles mini-batches, while the main thread only runs neural_train on them. A sample of weight w is
+ * drawn w times on average, as often as the simulation trains on it. The learning rate follows a cosine from --lr
+ * towards LEARN_RATE_MIN over the epochs. Every epoch reports its loss and the samples per second, and the trained
+ * network is written with neural_write, so the simulation can start its networks from it with --model-in.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include <math.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "main/simulation.h"
+#include "neural/autotune.h"
+#include "neural/dataset.h"
+#include "util/spsc.h"
+
+#define TRAIN_DEFAULT_EPOCHS 5
+#define TRAIN_DEFAULT_BATCH 256
+#define TRAIN_DEFAULT_SHUFFLE 65536
+#define TRAIN_DEFAULT_MODEL "model.bin"
+// Mini-batches the prefetch thread may prepare ahead of training, a power of two
+#define TRAIN_QUEUE_BATCHES 16
+// Sleep of a thread waiting for the other side of the batch queue
+#define TRAIN_IDLE_SLEEP 0.0001
+// Samples spread over the dataset that the trained network is graded on
+#define TRAIN_EVAL_SAMPLES 20000
+
+/**
+ * @brief Trainer options.
+ */
+typedef struct {
+  const char *data_path; /**< Dataset to train on */
+  const char *model_in;  /**< Network to continue training, or NULL for a new one */
+  const char *model_out; /**< File to write the trained network to */
+  int epochs;            /**< Passes over the dataset */
+  int batch_size;        /**< Samples per training step */
+  int shuffle_size;      /**< Samples in the shuffle buffer */
+  double learning_rate;  /**< Learning rate of the first epoch */
+  unsigned int seed;     /**< Seed of the network initialization and the shuffling */
+} train_options_t;
+
+/**
+ * @brief A mini-batch handed from the prefetch thread to training.
+ */
+typedef struct {
+  double *inputs;  /**< batch_size rows of inputs */
+  double *outputs; /**< batch_size rows of target outputs */
+  int rows;        /**< Samples in the batch, 0 for the end of the data */
+  int epoch;       /**< Epoch the samples belong to */
+} train_batch_t;
+
+/**
+ * @brief State of the prefetch thread.
+ */
+typedef struct {
+  const dataset_t *dataset;                   /**< The dataset */
+  const train_options_t *options;             /**< The options */
+  rng_t rng;                                  /**< Generator of the chunk order, the shuffling and the weights */
+  double *shuffle_inputs;                     /**< Inputs of the samples in the shuffle buffer */
+  double *shuffle_outputs;                    /**< Outputs of the samples in the shuffle buffer */
+  int shuffled;                               /**< Samples in the shuffle buffer */
+  train_batch_t batches[TRAIN_QUEUE_BATCHES]; /**< Batch slots of the queue */
+  spsc_ring_t queue;                          /**< Queue of the filled batch slots */
+  train_batch_t *batch;                       /**< Batch being filled, NULL if none */
+} prefetch_t;
+
+static bool parse_options(int argc, char **argv, train_options_t *options);
+static void print_usage(const char *program);
+static neural_network_t *create_network(const train_options_t *options);
+static void *prefetch_batches(void *arg);
+static void prefetch_epoch(prefetch_t *prefetch, int epoch);
+static void add_sample(prefetch_t *prefetch, const double *inputs, const double *outputs, int epoch);
+static void emit_sample(prefetch_t *prefetch, int index, int epoch);
+static void push_batch(prefetch_t *prefetch, int epoch, bool end);
+static train_batch_t *acquire_batch(prefetch_t *prefetch);
+static double epoch_learning_rate(const train_options_t *options, int epoch);
+static double evaluate_agreement(neural_network_t *network, const dataset_t *dataset);
+static int argmax(const double *values, int count);
+
+/** @brief Train a network on a dataset.
+ *
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @return Exit code of the trainer.
+ */
+int main(int argc, char **argv) {
+  train_options_t options;
+  if (!parse_options(argc, argv, &options)) {
+    return EXIT_FAILURE;
+  }
+
+  dataset_t *dataset = dataset_open(options.data_path);
+  if (!dataset || dataset->samples == 0) {
+    fprintf(stderr, "Could not read any samples from %s\n", options.data_path);
+    return EXIT_FAILURE;
+  }
+  if (dataset->inputs != ANN_INPUTS || dataset->outputs != ANN_OUTPUTS) {
+    fprintf(stderr, "The samples of %s have %d inputs and %d outputs, the network %d and %d\n", options.data_path,
+            dataset->inputs, dataset->outputs, ANN_INPUTS, ANN_OUTPUTS);
+    return EXIT_FAILURE;
+  }
+  // The chunks are read in random order, the pages of all of them are wanted
+  madvise(dataset->map, dataset->map_size, MADV_WILLNEED);
+  printf("Training on %ld samples in %d chunks of %s for %d epochs, batches of %d\n", dataset->samples,
+         dataset->num_chunks, options.data_path, options.epochs, options.batch_size);
+
+  neural_network_t *network = create_network(&options);
+  const bool cached = autotune_load(AUTOTUNE_CACHE_FILE);
+  if (autotune_network(network, options.batch_size) > 0 || !cached) {
+    autotune_save(AUTOTUNE_CACHE_FILE);
+  }
+
+  prefetch_t prefetch = {.dataset = dataset, .options = &options};
+  rng_seed_stream(&prefetch.rng, options.seed, 1);
+  spsc_init(&prefetch.queue, TRAIN_QUEUE_BATCHES);
+  prefetch.shuffle_inputs = malloc((size_t)options.shuffle_size * ANN_INPUTS * sizeof(double));
+  prefetch.shuffle_outputs = malloc((size_t)options.shuffle_size * ANN_OUTPUTS * sizeof(double));
+  bool allocated = prefetch.shuffle_inputs && prefetch.shuffle_outputs;
+  for (int i = 0; i < TRAIN_QUEUE_BATCHES; i++) {
+    prefetch.batches[i].inputs = malloc((size_t)options.batch_size * ANN_INPUTS * sizeof(double));
+    prefetch.batches[i].outputs = malloc((size_t)options.batch_size * ANN_OUTPUTS * sizeof(double));
+    allocated &= prefetch.batches[i].inputs && prefetch.batches[i].outputs;
+  }
+  pthread_t thread;
+  if (!allocated || pthread_create(&thread, NULL, prefetch_batches, &prefetch) != 0) {
+    fprintf(stderr, "Failed to allocate the training buffers\n");
+    return EXIT_FAILURE;
+  }
+
+  const double start = monotonic_seconds();
+  double epoch_start = start;
+  double loss_sum = 0.0;
+  long epoch_samples = 0;
+  long trained = 0;
+  int epoch = 0;
+  while (true) {
+    const int slot = spsc_read_slot(&prefetch.queue);
+    if (slot < 0) {
+      sleep_seconds(TRAIN_IDLE_SLEEP);
+      continue;
+    }
+    const train_batch_t *batch = &prefetch.batches[slot];
+    if (batch->epoch != epoch) {
+      const double now = monotonic_seconds();
+      printf("Epoch %d: loss %.5f, learning rate %.4f, %.0f samples/s\n", epoch + 1,
+             loss_sum / MAX(1, epoch_samples), epoch_learning_rate(&options, epoch),
+             epoch_samples / fmax(now - epoch_start, 1e-9));
+      epoch = batch->epoch;
+      epoch_start = now;
+      loss_sum = 0.0;
+      epoch_samples = 0;
+    }
+    if (batch->rows == 0) {
+      break;
+    }
+
+    const matrix_t inputs = {batch->inputs, batch->rows, ANN_INPUTS};
+    const matrix_t outputs = {batch->outputs, batch->rows, ANN_OUTPUTS};
+    loss_sum += neural_train(network, &inputs, &outputs, epoch_learning_rate(&options, epoch)) * batch->rows;
+    epoch_samples += batch->rows;
+    trained += batch->rows;
+    spsc_pop(&prefetch.queue);
+  }
+  const double elapsed = monotonic_seconds() - start;
+  pthread_join(thread, NULL);
+
+  printf("Trained on %ld samples in %.2f s: %.0f samples/s\n", trained, elapsed, trained / fmax(elapsed, 1e-9));
+  printf("Agreement with the teacher: %.4f\n", evaluate_agreement(network, dataset));
+  const bool written = neural_write(network, options.model_out);
+  if (written) {
+    printf("Wrote the network to %s\n", options.model_out);
+  } else {
+    fprintf(stderr, "Failed to write the network to %s\n", options.model_out);
+  }
+
+  for (int i = 0; i < TRAIN_QUEUE_BATCHES; i++) {
+    free(prefetch.batches[i].inputs);
+    free(prefetch.batches[i].outputs);
+  }
+  free(prefetch.shuffle_inputs);
+  free(prefetch.shuffle_outputs);
+  neural_free(network);
+  dataset_close(dataset);
+  return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Same initialization as the networks of the simulation, or the network to continue training
+static neural_network_t *create_network(const train_options_t *options) {
+  if (options->model_in) {
+    neural_network_t *network = neural_read(options->model_in);
+    if (!network || network->neuron_counts[0] != ANN_INPUTS ||
+        network->neuron_counts[network->num_hidden_layers + 1] != ANN_OUTPUTS) {
+      fprintf(stderr, "Could not read a network with %d inputs and %d outputs from %s\n", ANN_INPUTS, ANN_OUTPUTS,
+              options->model_in);
+      exit(EXIT_FAILURE);
+    }
+    return network;
+  }
+
+  const int neuron_counts[] = ANN_NEURON_COUNTS;
+  const neural_activation_t activations[] = ANN_ACTIVATIONS;
+  neural_network_t *network = neural_create((sizeof(neuron_counts) / sizeof(int)) - 2, neuron_counts, activations);
+  if (!network) {
+    fprintf(stderr, "Failed to create neural network\n");
+    exit(EXIT_FAILURE);
+  }
+  rng_t rng;
+  rng_seed(&rng, options->seed);
+  const double std = sqrt(6) / sqrt(neuron_counts[0] + neuron_counts[network->num_hidden_layers + 1]);
+  neural_randomize_weights(network, &rng, -std, std);
+  neural_randomize_bias(network, &rng, -0.01, 0.01);
+  return network;
+}
+
+// Prefetch thread, fills batches for all epochs and ends with an empty one
+static void *prefetch_batches(void *arg) {
+  prefetch_t *prefetch = arg;
+  for (int epoch = 0; epoch < prefetch->options->epochs; epoch++) {
+    prefetch_epoch(prefetch, epoch);
+  }
+  push_batch(prefetch, prefetch->options->epochs, true);
+  return NULL;
+}
+
+// Stream the chunks in random order through the shuffle buffer, then drain it
+static void prefetch_epoch(prefetch_t *prefetch, int epoch) {
+  const dataset_t *dataset = prefetch->dataset;
+  int *order = malloc(dataset->num_chunks * sizeof(int));
+  if (!order) {
+    fprintf(stderr, "Failed to allocate the chunk order\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < dataset->num_chunks; i++) {
+    order[i] = i;
+  }
+  for (int i = dataset->num_chunks - 1; i > 0; i--) {
+    const int j = rng_int(&prefetch->rng, i + 1);
+    const int swap = order[i];
+    order[i] = order[j];
+    order[j] = swap;
+  }
+
+  for (int c = 0; c < dataset->num_chunks; c++) {
+    const dataset_chunk_t *chunk = &dataset->chunks[order[c]];
+    for (int s = 0; s < chunk->count; s++) {
+      // Whole weights are repeats, the fraction is the chance of one more
+      const double weight = fmax(chunk->weights[s], 0.0);
+      const int repeats = (int)weight + (rng_double(&prefetch->rng) < weight - floor(weight));
+      for (int r = 0; r < repeats; r++) {
+        add_sample(prefetch, chunk->inputs + (size_t)s * ANN_INPUTS, chunk->outputs + (size_t)s * ANN_OUTPUTS,
+                   epoch);
+      }
+    }
+  }
+  free(order);
+
+  while (prefetch->shuffled > 0) {
+    const int index = rng_int(&prefetch->rng, prefetch->shuffled);
+    emit_sample(prefetch, index, epoch);
+    prefetch->shuffled--;
+    memcpy(prefetch->shuffle_inputs + (size_t)index * ANN_INPUTS,
+           prefetch->shuffle_inputs + (size_t)prefetch->shuffled * ANN_INPUTS, ANN_INPUTS * sizeof(double));
+    memcpy(prefetch->shuffle_outputs + (size_t)index * ANN_OUTPUTS,
+           prefetch->shuffle_outputs + (size_t)prefetch->shuffled * ANN_OUTPUTS, ANN_OUTPUTS * sizeof(double));
+  }
+  if (prefetch->batch && prefetch->batch->rows > 0) {
+    push_batch(prefetch, epoch, false);
+  }
+}
+
+// Put a sample into the shuffle buffer, once it is full a random sample leaves for the batch to make room
+static void add_sample(prefetch_t *prefetch, const double *inputs, const double *outputs, int epoch) {
+  int index = prefetch->shuffled;
+  if (prefetch->shuffled < prefetch->options->shuffle_size) {
+    prefetch->shuffled++;
+  } else {
+    index = rng_int(&prefetch->rng, prefetch->shuffled);
+    emit_sample(prefetch, index, epoch);
+  }
+  memcpy(prefetch->shuffle_inputs + (size_t)index * ANN_INPUTS, inputs, ANN_INPUTS * sizeof(double));
+  memcpy(prefetch->shuffle_outputs + (size_t)index * ANN_OUTPUTS, outputs, ANN_OUTPUTS * sizeof(double));
+}
+
+// Copy a sample of the shuffle buffer into the batch being filled, pushing it once full
+static void emit_sample(prefetch_t *prefetch, int index, int epoch) {
+  train_batch_t *batch = acquire_batch(prefetch);
+  memcpy(batch->inputs + (size_t)batch->rows * ANN_INPUTS, prefetch->shuffle_inputs + (size_t)index * ANN_INPUTS,
+         ANN_INPUTS * sizeof(double));
+  memcpy(batch->outputs + (size_t)batch->rows * ANN_OUTPUTS, prefetch->shuffle_outputs + (size_t)index * ANN_OUTPUTS,
+         ANN_OUTPUTS * sizeof(double));
+  batch->rows++;
+  if (batch->rows == prefetch->options->batch_size) {
+    push_batch(prefetch, epoch, false);
+  }
+}
+
+// Hand the batch being filled to training, an end batch has no rows
+static void push_batch(prefetch_t *prefetch, int epoch, bool end) {
+  train_batch_t *batch = acquire_batch(prefetch);
+  if (end) {
+    batch->rows = 0;
+  }
+  batch->epoch = epoch;
+  spsc_push(&prefetch->queue);
+  prefetch->batch = NULL;
+}
+
+// The batch being filled, waiting for a free slot if there is none
+static train_batch_t *acquire_batch(prefetch_t *prefetch) {
+  while (!prefetch->batch) {
+    const int slot = spsc_write_slot(&prefetch->queue);
+    if (slot < 0) {
+      sleep_seconds(TRAIN_IDLE_SLEEP);
+      continue;
+    }
+    prefetch->batch = &prefetch->batches[slot];
+    prefetch->batch->rows = 0;
+  }
+  return prefetch->batch;
+}
+
+// Cosine from the initial learning rate towards LEARN_RATE_MIN, which it would reach after the last epoch
+static double epoch_learning_rate(const train_options_t *options, int epoch) {
+  const double progress = (double)epoch / options->epochs;
+  return LEARN_RATE_MIN + 0.5 * (options->learning_rate - LEARN_RATE_MIN) * (1.0 + cos(TAU / 2.0 * progress));
+}
+
+// Share of the samples whose turn and action the network decides like the teacher
+static double evaluate_agreement(neural_network_t *network, const dataset_t *dataset) {
+  const long stride = MAX(1, dataset->samples / TRAIN_EVAL_SAMPLES);
+  long graded = 0;
+  long agreed = 0;
+  long index = 0;
+  for (int c = 0; c < dataset->num_chunks; c++) {
+    const dataset_chunk_t *chunk = &dataset->chunks[c];
+    for (int s = 0; s < chunk->count; s++, index++) {
+      if (index % stride != 0) {
+        continue;
+      }
+      double inputs[ANN_INPUTS];
+      memcpy(inputs, chunk->inputs + (size_t)s * ANN_INPUTS, sizeof(inputs));
+      const vector_t inputs_vec = {inputs, ANN_INPUTS};
+      const double *pred = neural_run(network, &inputs_vec)->data;
+      const double *target = chunk->outputs + (size_t)s * ANN_OUTPUTS;
+      agreed += argmax(pred, 3) == argmax(target, 3) && argmax(pred + 3, 3) == argmax(target + 3, 3);
+      graded++;
+    }
+  }
+  return graded > 0 ? (double)agreed / graded : 0.0;
+}
+
+static int argmax(const double *values, int count) {
+  int best = 0;
+  for (int i = 1; i < count; i++) {
+    best = values[i] > values[best] ? i : best;
+  }
+  return best;
+}
+
+static bool parse_options(int argc, char **argv, train_options_t *options) {
+  *options = (train_options_t){
+      .model_out = TRAIN_DEFAULT_MODEL,
+      .epochs = TRAIN_DEFAULT_EPOCHS,
+      .batch_size = TRAIN_DEFAULT_BATCH,
+      .shuffle_size = TRAIN_DEFAULT_SHUFFLE,
+      .learning_rate = LEARN_RATE,
+      .seed = 1,
+  };
+
+  bool valid = true;
+  for (int i = 1; valid && i < argc; i++) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      print_usage(argv[0]);
+      exit(EXIT_SUCCESS);
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "Missing value for %s\n", arg);
+      print_usage(argv[0]);
+      return false;
+    }
+
+    const char *value = argv[++i];
+    if (strcmp(arg, "--data") == 0) {
+      options->data_path = value;
+    } else if (strcmp(arg, "--model-in") == 0) {
+      options->model_in = value;
+    } else if (strcmp(arg, "--model-out") == 0) {
+      options->model_out = value;
+    } else if (strcmp(arg, "--epochs") == 0) {
+      options->epochs = atoi(value);
+      valid = options->epochs > 0;
+    } else if (strcmp(arg, "--batch") == 0) {
+      options->batch_size = atoi(value);
+      valid = options->batch_size > 0;
+    } else if (strcmp(arg, "--shuffle") == 0) {
+      options->shuffle_size = atoi(value);
+      valid = options->shuffle_size > 0;
+    } else if (strcmp(arg, "--lr") == 0) {
+      options->learning_rate = atof(value);
+      valid = options->learning_rate > 0.0;
+    } else if (strcmp(arg, "--seed") == 0) {
+      options->seed = (unsigned int)strtoul(value, NULL, 10);
+    } else {
+      fprintf(stderr, "Unknown option %s\n", arg);
+      print_usage(argv[0]);
+      return false;
+    }
+
+    if (!valid) {
+      fprintf(stderr, "Invalid value %s for %s\n", value, arg);
+      print_usage(argv[0]);
+    }
+  }
+
+  if (valid && !options->data_path) {
+    fprintf(stderr, "Missing --data\n");
+    print_usage(argv[0]);
+    return false;
+  }
+  return valid;
+}
+
+static void print_usage(const char *program) {
+  printf("Usage: %s --data PATH [options]\n"
+         "  --data PATH           Dataset written by AntMatrix_headless --dataset\n"
+         "  --model-in PATH       Network to continue training (default: a new one)\n"
+         "  --model-out PATH      File to write the trained network to (default %s)\n"
+         "  --epochs N            Passes over the dataset (default %d)\n"
+         "  --batch N             Samples per training step (default %d)\n"
+         "  --shuffle N           Samples in the shuffle buffer (default %d)\n"
+         "  --lr RATE             Learning rate of the first epoch, decays towards %g (default %g)\n"
+         "  --seed N              Seed of the initialization and the shuffling (default 1)\n"
+         "  --help                Show this help\n",
+         program, TRAIN_DEFAULT_MODEL, TRAIN_DEFAULT_EPOCHS, TRAIN_DEFAULT_BATCH, TRAIN_DEFAULT_SHUFFLE, LEARN_RATE_MIN,
+         LEARN_RATE);
+}
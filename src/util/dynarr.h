@@ -39,7 +39,7 @@
 #define dyn_arr_push(dyn_arr, elem)                                                                                    \
   do {                                                                                                                 \
     if ((dyn_arr).length >= (dyn_arr).capacity) {                                                                      \
-      (dyn_arr).capacity *= 2;                                                                                         \
+      (dyn_arr).capacity = (dyn_arr).capacity > 0 ? (dyn_arr).capacity * 2 : DYN_ARR_INIT_CAPACITY;                    \
       (dyn_arr).data = realloc((dyn_arr).data, (dyn_arr).capacity * sizeof(*(dyn_arr).data));                          \
     }                                                                                                                  \
     (dyn_arr).data[(dyn_arr).length++] = (elem);                                                                       \
@@ -49,7 +49,7 @@
   do {                                                                                                                 \
     if ((dyn_arr).length + (n) > (dyn_arr).capacity) {                                                                 \
       while ((dyn_arr).length + (n) > (dyn_arr).capacity) {                                                            \
-        (dyn_arr).capacity *= 2;                                                                                       \
+        (dyn_arr).capacity = (dyn_arr).capacity > 0 ? (dyn_arr).capacity * 2 : DYN_ARR_INIT_CAPACITY;                  \
       }                                                                                                                \
       (dyn_arr).data = realloc((dyn_arr).data, (dyn_arr).capacity * sizeof(*(dyn_arr).data));                          \
     }                                                                                                                  \
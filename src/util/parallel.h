@@ -0,0 +1,30 @@
+/**
+ * @file parallel.h
+ * @brief Helpers for the optional OpenMP parallel regions (ANTMATRIX_OPENMP).
+ *
+ * Without OpenMP the macros expand to nothing and every loop runs serially.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Minimum number of elements (or multiply-adds) of work before a loop is split across threads. Forking a team costs
+// a few microseconds, so the m = 1 per-ant calls always stay serial.
+#define PARALLEL_MIN_WORK 32768
+
+#ifdef _OPENMP
+#define PARALLEL_PRAGMA(x) _Pragma(#x)
+/** @brief Parallelize the following for loop when the condition holds. */
+#define PARALLEL_FOR_IF(condition) PARALLEL_PRAGMA(omp parallel for if (condition))
+#else
+#define PARALLEL_FOR_IF(condition)
+#endif
+
+#endif /* PARALLEL_H */
@@ -0,0 +1,51 @@
+#include "util/rng.h"
+
+static uint64_t splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+void rng_seed(rng_t *rng, uint64_t seed) {
+  if (!rng) {
+    return;
+  }
+
+  // splitmix64 never yields four zero words in a row, the all-zero state would only ever produce zeros
+  for (int i = 0; i < 4; i++) {
+    rng->s[i] = splitmix64(&seed);
+  }
+}
+
+void rng_seed_stream(rng_t *rng, uint64_t seed, uint64_t stream) {
+  // Hash the stream index first so neighbouring streams start far apart in the splitmix64 sequence
+  uint64_t stream_state = stream;
+  rng_seed(rng, seed ^ splitmix64(&stream_state));
+}
+
+void rng_fill_uniform(rng_t *rng, double *out, size_t count, double min, double max) {
+  if (!rng || !out) {
+    return;
+  }
+
+  // Work on a local copy of the state so it can stay in registers
+  rng_t local = *rng;
+  const double scale = (max - min) * 0x1.0p-53;
+  for (size_t i = 0; i < count; i++) {
+    out[i] = min + (double)(rng_next(&local) >> 11) * scale;
+  }
+  *rng = local;
+}
+
+void rng_fill_u64(rng_t *rng, uint64_t *out, size_t count) {
+  if (!rng || !out) {
+    return;
+  }
+
+  rng_t local = *rng;
+  for (size_t i = 0; i < count; i++) {
+    out[i] = rng_next(&local);
+  }
+  *rng = local;
+}
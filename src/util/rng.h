@@ -0,0 +1,120 @@
+/**
+ * @file rng.h
+ * @brief Fast seedable pseudo random number generator (xoshiro256**).
+ *
+ * Every generator is a small value owned by its user, so threads (or ants) never share state and a run is
+ * reproducible from its seed no matter how the work is split. Generators for different streams of the same seed are
+ * independent.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief State of a xoshiro256** generator.
+ */
+typedef struct {
+  uint64_t s[4];
+} rng_t;
+
+/**
+ * @brief Seed a generator, the state is expanded from the seed with splitmix64.
+ *
+ * @param rng The generator to seed.
+ * @param seed The seed.
+ */
+void rng_seed(rng_t *rng, uint64_t seed);
+
+/**
+ * @brief Seed one of many independent generators derived from the same seed.
+ *
+ * @param rng The generator to seed.
+ * @param seed The seed shared by all streams, usually the run seed.
+ * @param stream The index of the stream, for example the ant or thread index.
+ */
+void rng_seed_stream(rng_t *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Get the next 64 random bits.
+ *
+ * @param rng The generator.
+ * @return The random bits.
+ */
+static inline uint64_t rng_next(rng_t *rng) {
+  uint64_t *s = rng->s;
+  const uint64_t x = s[1] * 5;
+  const uint64_t result = ((x << 7) | (x >> 57)) * 9;
+  const uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = (s[3] << 45) | (s[3] >> 19);
+
+  return result;
+}
+
+/**
+ * @brief Get a random double in [0, 1) with 53 random bits.
+ *
+ * @param rng The generator.
+ * @return The random double.
+ */
+static inline double rng_double(rng_t *rng) { return (double)(rng_next(rng) >> 11) * 0x1.0p-53; }
+
+/**
+ * @brief Get a random double in [min, max).
+ *
+ * @param rng The generator.
+ * @param min The lower bound.
+ * @param max The upper bound.
+ * @return The random double.
+ */
+static inline double rng_uniform(rng_t *rng, double min, double max) { return min + (max - min) * rng_double(rng); }
+
+/**
+ * @brief Get a random integer in [0, bound).
+ *
+ * Uses a multiply-shift instead of a modulo, the bias is below bound / 2^32.
+ *
+ * @param rng The generator.
+ * @param bound The exclusive upper bound, at least 1.
+ * @return The random integer, 0 if bound is not positive.
+ */
+static inline int rng_int(rng_t *rng, int bound) {
+  return bound > 0 ? (int)(((rng_next(rng) >> 32) * (uint64_t)bound) >> 32) : 0;
+}
+
+/**
+ * @brief Fill a buffer with random doubles in [min, max).
+ *
+ * Produces the same values as count calls to rng_uniform.
+ *
+ * @param rng The generator.
+ * @param out The buffer to fill.
+ * @param count The number of values.
+ * @param min The lower bound.
+ * @param max The upper bound.
+ */
+void rng_fill_uniform(rng_t *rng, double *out, size_t count, double min, double max);
+
+/**
+ * @brief Fill a buffer with random 64 bit values.
+ *
+ * Produces the same values as count calls to rng_next.
+ *
+ * @param rng The generator.
+ * @param out The buffer to fill.
+ * @param count The number of values.
+ */
+void rng_fill_u64(rng_t *rng, uint64_t *out, size_t count);
+
+#endif /* RNG_H */
@@ -0,0 +1,55 @@
+#include "util/scheduler.h"
+
+#include <math.h>
+
+static double smooth(double average, double sample);
+
+void scheduler_init(scheduler_t *scheduler, double frame_budget, double now) {
+  if (!scheduler) {
+    return;
+  }
+
+  *scheduler = (scheduler_t){0};
+  scheduler->frame_budget = frame_budget;
+  scheduler->frame_start = now;
+}
+
+int scheduler_plan(const scheduler_t *scheduler, bool render) {
+  // Nothing measured yet, one tick to measure
+  if (scheduler->tick_cost <= 0.0) {
+    return 1;
+  }
+
+  const double budget = scheduler->frame_budget - (render ? scheduler->render_cost : 0.0);
+  const double ticks = floor(budget / scheduler->tick_cost);
+  return (int)fmax(1.0, fmin(ticks, SCHEDULER_MAX_TICKS));
+}
+
+void scheduler_record_ticks(scheduler_t *scheduler, long ticks, double seconds) {
+  if (ticks <= 0) {
+    return;
+  }
+
+  scheduler->frame_ticks += ticks;
+  if (seconds > 0.0) {
+    const double cost = seconds / ticks;
+    scheduler->tick_cost = scheduler->tick_cost > 0.0 ? smooth(scheduler->tick_cost, cost) : cost;
+  }
+}
+
+void scheduler_record_render(scheduler_t *scheduler, double seconds) {
+  scheduler->render_cost = scheduler->render_cost > 0.0 ? smooth(scheduler->render_cost, seconds) : seconds;
+}
+
+void scheduler_end_frame(scheduler_t *scheduler, double now) {
+  const double elapsed = now - scheduler->frame_start;
+  if (elapsed <= 0.0) {
+    return;
+  }
+
+  scheduler->ticks_per_second = smooth(scheduler->ticks_per_second, scheduler->frame_ticks / elapsed);
+  scheduler->frame_ticks = 0;
+  scheduler->frame_start = now;
+}
+
+static double smooth(double average, double sample) { return average + SCHEDULER_SMOOTHING * (sample - average); }
@@ -0,0 +1,78 @@
+/**
+ * @file scheduler.h
+ * @brief Frame scheduler that splits a frame time budget between fixed simulation ticks and rendering.
+ *
+ * The scheduler measures what a tick and a rendered frame cost and plans as many ticks per frame as fit the budget
+ * next to the rendering. Frames that skip rendering give the whole budget to ticks. It needs no tuning: a slower
+ * machine or a bigger world simply gets fewer ticks per frame.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+
+// Weight of the newest measurement in the smoothed costs and rate
+#define SCHEDULER_SMOOTHING 0.1
+// Most ticks planned for one frame, bounds the frame time when a measured cost is far too low
+#define SCHEDULER_MAX_TICKS 100000
+
+/**
+ * @brief Costs and throughput of the frames so far.
+ */
+typedef struct {
+  double frame_budget;     /**< Target seconds per frame */
+  double tick_cost;        /**< Smoothed seconds per tick, 0 before the first measurement */
+  double render_cost;      /**< Smoothed seconds per rendered frame */
+  double ticks_per_second; /**< Smoothed ticks per second achieved */
+  long frame_ticks;        /**< Ticks counted since the last scheduler_end_frame */
+  double frame_start;      /**< Time of the last scheduler_end_frame */
+} scheduler_t;
+
+/**
+ * @brief Initialize a scheduler.
+ *
+ * @param scheduler The scheduler.
+ * @param frame_budget The target seconds per frame.
+ * @param now The current time in seconds.
+ */
+void scheduler_init(scheduler_t *scheduler, double frame_budget, double now);
+
+/**
+ * @brief Get how many ticks fit the budget of the coming frame.
+ *
+ * @param scheduler The scheduler.
+ * @param render Whether the frame is rendered, its cost is taken from the budget.
+ * @return The number of ticks, at least 1 and at most SCHEDULER_MAX_TICKS.
+ */
+int scheduler_plan(const scheduler_t *scheduler, bool render);
+
+/**
+ * @brief Count ticks and measure their cost.
+ *
+ * @param scheduler The scheduler.
+ * @param ticks The number of ticks run.
+ * @param seconds The time the ticks took, 0 to count ticks another thread ran without measuring them.
+ */
+void scheduler_record_ticks(scheduler_t *scheduler, long ticks, double seconds);
+
+/**
+ * @brief Measure the cost of rendering a frame.
+ *
+ * @param scheduler The scheduler.
+ * @param seconds The time rendering and presenting took.
+ */
+void scheduler_record_render(scheduler_t *scheduler, double seconds);
+
+/**
+ * @brief End a frame and update the achieved ticks per second.
+ *
+ * @param scheduler The scheduler.
+ * @param now The current time in seconds.
+ */
+void scheduler_end_frame(scheduler_t *scheduler, double now);
+
+#endif /* SCHEDULER_H */
@@ -0,0 +1,42 @@
+#include "util/spsc.h"
+
+bool spsc_init(spsc_ring_t *ring, unsigned capacity) {
+  if (!ring || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+    return false;
+  }
+
+  atomic_init(&ring->head, 0u);
+  atomic_init(&ring->tail, 0u);
+  ring->capacity = capacity;
+  return true;
+}
+
+int spsc_write_slot(const spsc_ring_t *ring) {
+  // Acquire pairs with spsc_pop, the consumer is done reading the slot before it is reused
+  const unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  const unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail == ring->capacity) {
+    return -1;
+  }
+  return (int)(head & (ring->capacity - 1));
+}
+
+void spsc_push(spsc_ring_t *ring) {
+  // Release makes the slot contents visible to the consumer that sees the new head
+  const unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+int spsc_read_slot(const spsc_ring_t *ring) {
+  const unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  const unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  if (head == tail) {
+    return -1;
+  }
+  return (int)(tail & (ring->capacity - 1));
+}
+
+void spsc_pop(spsc_ring_t *ring) {
+  const unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file spsc.h
+ * @brief Lock-free bounded queue index ring between one producer and one consumer thread.
+ *
+ * The producer fills the slot at the head and pushes it, the consumer reads the slot at the tail and pops it. Each
+ * side only writes its own counter, so neither ever waits or takes a lock. Like the triple buffer, the ring only hands
+ * out slot indices and the caller owns the slot data.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+/**
+ * @brief Counters of a single-producer single-consumer ring.
+ */
+typedef struct {
+  _Alignas(64) atomic_uint head; /**< Slots pushed so far, only the producer writes it */
+  _Alignas(64) atomic_uint tail; /**< Slots popped so far, only the consumer writes it */
+  unsigned capacity;             /**< Number of slots, a power of two */
+} spsc_ring_t;
+
+/**
+ * @brief Initialize an empty ring.
+ *
+ * @param ring The ring.
+ * @param capacity The number of slots, a power of two.
+ * @return true on success, false if the capacity is not a power of two.
+ */
+bool spsc_init(spsc_ring_t *ring, unsigned capacity);
+
+/**
+ * @brief Get the slot the producer fills next.
+ *
+ * @param ring The ring.
+ * @return The slot index, or -1 if the ring is full.
+ */
+int spsc_write_slot(const spsc_ring_t *ring);
+
+/**
+ * @brief Hand the slot from spsc_write_slot to the consumer.
+ *
+ * @param ring The ring.
+ */
+void spsc_push(spsc_ring_t *ring);
+
+/**
+ * @brief Get the oldest slot the consumer has not popped.
+ *
+ * @param ring The ring.
+ * @return The slot index, or -1 if the ring is empty.
+ */
+int spsc_read_slot(const spsc_ring_t *ring);
+
+/**
+ * @brief Give the slot from spsc_read_slot back to the producer.
+ *
+ * @param ring The ring.
+ */
+void spsc_pop(spsc_ring_t *ring);
+
+#endif /* SPSC_H */
@@ -0,0 +1,163 @@
+#include "util/threadpool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct threadpool {
+  pthread_t *threads;
+  int num_threads;
+  pthread_mutex_t mutex;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long generation;
+  int pending;
+  bool stop;
+
+  // The current job, only changed while no worker is running
+  threadpool_task_t task;
+  void *arg;
+  int count;
+  int ranges;
+};
+
+typedef struct {
+  threadpool_t *pool;
+  int worker;
+} worker_arg_t;
+
+static void run_range(threadpool_t *pool, int worker) {
+  if (worker < pool->ranges) {
+    const int begin = (int)((long)pool->count * worker / pool->ranges);
+    const int end = (int)((long)pool->count * (worker + 1) / pool->ranges);
+    pool->task(pool->arg, begin, end, worker);
+  }
+}
+
+static void *worker_main(void *arg) {
+  worker_arg_t *worker_arg = arg;
+  threadpool_t *pool = worker_arg->pool;
+  const int worker = worker_arg->worker;
+  free(worker_arg);
+
+  unsigned long seen = 0;
+  pthread_mutex_lock(&pool->mutex);
+  while (true) {
+    while (pool->generation == seen && !pool->stop) {
+      pthread_cond_wait(&pool->start, &pool->mutex);
+    }
+    if (pool->stop) {
+      break;
+    }
+    seen = pool->generation;
+    pthread_mutex_unlock(&pool->mutex);
+
+    run_range(pool, worker);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->pending == 0) {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return NULL;
+}
+
+threadpool_t *threadpool_create(int num_threads) {
+  if (num_threads <= 0) {
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = online > 0 ? (int)online : 1;
+  }
+
+  threadpool_t *pool = calloc(1, sizeof(threadpool_t));
+  if (!pool) {
+    return NULL;
+  }
+  pool->threads = calloc(num_threads, sizeof(pthread_t));
+  if (!pool->threads) {
+    free(pool);
+    return NULL;
+  }
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  // Thread 0 is the caller of threadpool_parallel_for
+  pool->num_threads = 1;
+  for (int i = 1; i < num_threads; i++) {
+    worker_arg_t *worker_arg = malloc(sizeof(worker_arg_t));
+    if (!worker_arg) {
+      break;
+    }
+    *worker_arg = (worker_arg_t){pool, i};
+    const int error = pthread_create(&pool->threads[i], NULL, worker_main, worker_arg);
+    if (error != 0) {
+      fprintf(stderr, "Failed to create worker thread: %s\n", strerror(error));
+      free(worker_arg);
+      break;
+    }
+    pool->num_threads++;
+  }
+
+  return pool;
+}
+
+int threadpool_size(const threadpool_t *pool) { return pool ? pool->num_threads : 1; }
+
+void threadpool_parallel_for(threadpool_t *pool, int count, int grain, threadpool_task_t task, void *arg) {
+  if (count <= 0 || !task) {
+    return;
+  }
+
+  grain = grain < 1 ? 1 : grain;
+  int ranges = count / grain;
+  ranges = ranges < 1 ? 1 : ranges;
+  ranges = ranges > threadpool_size(pool) ? threadpool_size(pool) : ranges;
+  if (ranges == 1) {
+    task(arg, 0, count, 0);
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->task = task;
+  pool->arg = arg;
+  pool->count = count;
+  pool->ranges = ranges;
+  // Every worker checks in, also the ones without a range, so the job is not replaced while one still reads it
+  pool->pending = pool->num_threads - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+
+  run_range(pool, 0);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->pending > 0) {
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+void threadpool_free(threadpool_t *pool) {
+  if (!pool) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+  for (int i = 1; i < pool->num_threads; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+  free(pool->threads);
+  free(pool);
+}
@@ -0,0 +1,64 @@
+/**
+ * @file threadpool.h
+ * @brief Persistent worker threads with a blocking parallel for.
+ *
+ * The workers are created once and sleep between jobs, so splitting a simulation tick across cores costs a wake-up
+ * instead of a thread creation. Work is split into contiguous static ranges, worker w always gets the same range for
+ * the same count, which keeps results independent of timing.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/**
+ * @brief A range of a parallel for, run by one worker.
+ *
+ * @param arg The argument given to threadpool_parallel_for.
+ * @param begin The first index of the range.
+ * @param end One past the last index of the range.
+ * @param worker The index of the worker, in [0, threadpool_size), the caller is worker 0.
+ */
+typedef void (*threadpool_task_t)(void *arg, int begin, int end, int worker);
+
+typedef struct threadpool threadpool_t;
+
+/**
+ * @brief Create a thread pool.
+ *
+ * @param num_threads The number of threads including the calling thread, 0 for one per online core.
+ * @return The thread pool, or NULL on failure.
+ */
+threadpool_t *threadpool_create(int num_threads);
+
+/**
+ * @brief Get the number of threads of a pool, including the calling thread.
+ *
+ * @param pool The thread pool.
+ * @return The number of threads, 1 if pool is NULL.
+ */
+int threadpool_size(const threadpool_t *pool);
+
+/**
+ * @brief Split [0, count) into contiguous ranges, run the task on all of them and wait for every range to finish.
+ *
+ * The calling thread runs the first range. Only one thread may call this on a pool at a time.
+ *
+ * @param pool The thread pool, NULL runs everything on the calling thread.
+ * @param count The number of items.
+ * @param grain The minimum number of items per range, fewer items run on fewer threads.
+ * @param task The task to run for every range.
+ * @param arg The argument passed to the task.
+ */
+void threadpool_parallel_for(threadpool_t *pool, int count, int grain, threadpool_task_t task, void *arg);
+
+/**
+ * @brief Stop the workers and free a thread pool.
+ *
+ * @param pool The thread pool to free.
+ */
+void threadpool_free(threadpool_t *pool);
+
+#endif /* THREADPOOL_H */
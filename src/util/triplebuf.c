@@ -0,0 +1,39 @@
+#include "util/triplebuf.h"
+
+// Set on the exchange slot from publishing until the reader takes it
+#define TRIPLE_BUFFER_FRESH 4u
+#define TRIPLE_BUFFER_INDEX 3u
+
+void triple_buffer_init(triple_buffer_t *buffer) {
+  if (!buffer) {
+    return;
+  }
+
+  buffer->write = 0;
+  atomic_init(&buffer->exchange, 1u);
+  buffer->read = 2;
+}
+
+int triple_buffer_write_slot(const triple_buffer_t *buffer) { return buffer->write; }
+
+int triple_buffer_publish(triple_buffer_t *buffer) {
+  // Release makes the slot contents visible to the reader that acquires it
+  const unsigned previous =
+      atomic_exchange_explicit(&buffer->exchange, (unsigned)buffer->write | TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+  buffer->write = (int)(previous & TRIPLE_BUFFER_INDEX);
+  return buffer->write;
+}
+
+bool triple_buffer_pending(const triple_buffer_t *buffer) {
+  return (atomic_load_explicit(&buffer->exchange, memory_order_relaxed) & TRIPLE_BUFFER_FRESH) != 0;
+}
+
+int triple_buffer_acquire(triple_buffer_t *buffer) {
+  if (!triple_buffer_pending(buffer)) {
+    return buffer->read;
+  }
+
+  const unsigned previous = atomic_exchange_explicit(&buffer->exchange, (unsigned)buffer->read, memory_order_acq_rel);
+  buffer->read = (int)(previous & TRIPLE_BUFFER_INDEX);
+  return buffer->read;
+}
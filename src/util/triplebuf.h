@@ -0,0 +1,70 @@
+/**
+ * @file triplebuf.h
+ * @brief Lock-free triple buffer index exchange between one writer and one reader thread.
+ *
+ * Three slots are owned by the writer, the reader and the exchange. Publishing swaps the writer slot with the
+ * exchange, acquiring swaps the reader slot with the exchange if something new was published. Neither side ever
+ * waits, the writer can publish at any rate and the reader always gets the newest complete slot. The buffer only
+ * hands out slot indices, the caller owns the slot data.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#ifndef TRIPLEBUF_H
+#define TRIPLEBUF_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define TRIPLE_BUFFER_SLOTS 3
+
+/**
+ * @brief Slot ownership of a triple buffer.
+ */
+typedef struct {
+  atomic_uint exchange; /**< Slot in the exchange, flagged fresh until the reader takes it */
+  int write;            /**< Slot of the writer, only the writer touches it */
+  int read;             /**< Slot of the reader, only the reader touches it */
+} triple_buffer_t;
+
+/**
+ * @brief Initialize a triple buffer, nothing is published yet.
+ *
+ * @param buffer The triple buffer.
+ */
+void triple_buffer_init(triple_buffer_t *buffer);
+
+/**
+ * @brief Get the slot the writer fills next.
+ *
+ * @param buffer The triple buffer.
+ * @return The slot index, in [0, TRIPLE_BUFFER_SLOTS).
+ */
+int triple_buffer_write_slot(const triple_buffer_t *buffer);
+
+/**
+ * @brief Publish the filled writer slot and get a new one to fill.
+ *
+ * @param buffer The triple buffer.
+ * @return The slot the writer fills next.
+ */
+int triple_buffer_publish(triple_buffer_t *buffer);
+
+/**
+ * @brief Check whether a published slot has not been acquired yet, the writer can skip filling until it has.
+ *
+ * @param buffer The triple buffer.
+ * @return true if the reader has not taken the last published slot.
+ */
+bool triple_buffer_pending(const triple_buffer_t *buffer);
+
+/**
+ * @brief Take the newest published slot, or keep the current one if nothing new was published.
+ *
+ * @param buffer The triple buffer.
+ * @return The slot the reader may use until the next call.
+ */
+int triple_buffer_acquire(triple_buffer_t *buffer);
+
+#endif /* TRIPLEBUF_H */
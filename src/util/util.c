@@ -1,6 +1,7 @@
 #include "util/util.h"
 
 #include <math.h>
+#include <time.h>
 
 int nearest_16_by_9_height(int width) {
   // Nearest 16:9 standard resolution, 1 res below
@@ -21,13 +22,26 @@ int nearest_16_by_9_height(int width) {
   }
 }
 
+double monotonic_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void sleep_seconds(double seconds) {
+  if (!(seconds > 0.0)) {
+    return;
+  }
+
+  const struct timespec ts = {(time_t)seconds, (long)((seconds - floor(seconds)) * 1e9)};
+  nanosleep(&ts, NULL);
+}
+
 double constrain_angle(double angle) {
   // angle - TAU * floor((angle * PI) * 1/TAU);
   return angle - TAU * floor((angle + M_PI) * 0.15915494309189535);
 }
 
-Vector2 v2d_to_v2(vector2d_t v) { return (Vector2){(float)v.x, (float)v.y}; }
-vector2d_t v2_to_v2d(Vector2 v) { return (vector2d_t){(double)v.x, (double)v.y}; }
 vector2d_t v2d_add(vector2d_t a, vector2d_t b) { return (vector2d_t){a.x + b.x, a.y + b.y}; }
 vector2d_t v2d_subtract(vector2d_t a, vector2d_t b) { return (vector2d_t){a.x - b.x, a.y - b.y}; }
 double v2d_length(vector2d_t v) { return sqrt(v.x * v.x + v.y * v.y); }
@@ -42,6 +56,11 @@ vector2d_t v2d_normalize(vector2d_t v) {
   return (vector2d_t){v.x / len, v.y / len};
 }
 
+double v2d_dot(vector2d_t a, vector2d_t b) { return a.x * b.x + a.y * b.y; }
+double v2d_cross(vector2d_t a, vector2d_t b) { return a.x * b.y - a.y * b.x; }
+vector2d_t v2d_from_angle(double angle) { return (vector2d_t){cos(angle), sin(angle)}; }
+double v2d_angle(vector2d_t v) { return atan2(v.y, v.x); }
+
 bool circle_collide_point(circled_t c, vector2d_t p) { return v2d_distance_sqr(p, c.center) <= (c.radius * c.radius); }
 
 bool circle_collide_circle(circled_t a, circled_t b) {
@@ -10,7 +10,7 @@
 #ifndef UTIL_H
 #define UTIL_H
 
-#include "raylib.h"
+#include <stdbool.h>
 
 #define TAU 6.28318530717958647693
 
@@ -47,26 +47,26 @@ typedef struct {
 int nearest_16_by_9_height(int width);
 
 /**
- * @brief Constrain an angle to the range [-π, π).
+ * @brief Get the time of a monotonic clock.
  *
- * @param angle The angle in radians to constrain.
- * @return The constrained angle in radians.
+ * @return The current time in seconds, only meaningful relative to another call.
  */
-double constrain_angle(double angle);
+double monotonic_seconds(void);
 
-/** @brief Convert a Vector2 to a vector2d_t.
+/**
+ * @brief Sleep the calling thread.
  *
- * @param v The Vector2 to convert.
- * @return The converted vector2d_t.
+ * @param seconds The time to sleep, nothing happens if it is not positive.
  */
-Vector2 v2d_to_v2(vector2d_t v);
+void sleep_seconds(double seconds);
 
-/** @brief Convert a vector2d_t to a Vector2.
+/**
+ * @brief Constrain an angle to the range [-π, π).
  *
- * @param v The vector2d_t to convert.
- * @return The converted Vector2.
+ * @param angle The angle in radians to constrain.
+ * @return The constrained angle in radians.
  */
-vector2d_t v2_to_v2d(Vector2 v);
+double constrain_angle(double angle);
 
 /**
  * @brief Add two vector2d_t structures together.
@@ -128,6 +128,40 @@ double v2d_distance_sqr(vector2d_t a, vector2d_t b);
  */
 vector2d_t v2d_normalize(vector2d_t v);
 
+/**
+ * @brief Get the dot product of two vector2d_t structures.
+ *
+ * @param a First vector2d_t.
+ * @param b Second vector2d_t.
+ * @return The dot product, the cosine of the angle between unit vectors.
+ */
+double v2d_dot(vector2d_t a, vector2d_t b);
+
+/**
+ * @brief Get the cross product of two vector2d_t structures.
+ *
+ * @param a First vector2d_t.
+ * @param b Second vector2d_t.
+ * @return The z component of the cross product, positive if b is counterclockwise of a.
+ */
+double v2d_cross(vector2d_t a, vector2d_t b);
+
+/**
+ * @brief Get the unit vector of an angle.
+ *
+ * @param angle The angle in radians.
+ * @return The vector (cos, sin) of the angle.
+ */
+vector2d_t v2d_from_angle(double angle);
+
+/**
+ * @brief Get the angle of a vector2d_t.
+ *
+ * @param v The vector2d_t.
+ * @return The angle in radians, in the range [-π, π].
+ */
+double v2d_angle(vector2d_t v);
+
 /**
  * @brief Check if a circle and point collide.
  *
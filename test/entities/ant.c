@@ -0,0 +1,71 @@
+#include "entities/ant.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "main/simulation.h"
+
+#define TURNS 100000
+
+// Turning rotates the heading by the turn angle and keeps it a unit vector over many turns
+int test_turn() {
+  ant_t *ant = ant_create((vector2d_t){100.0, 100.0}, (vector2d_t){100.0, 100.0}, 0.5, 1);
+  assert(ant);
+
+  for (int i = 0; i < TURNS; i++) {
+    ant_turn(ant, i % 3 == 0 ? ANT_TURN_RIGHT : ANT_TURN_LEFT, FIXED_DELTA);
+  }
+  ant_turn(ant, ANT_TURN_NONE, FIXED_DELTA);
+  const double turned = 0.5 + (TURNS - 2 * ((TURNS + 2) / 3)) * ANT_TURN_SPEED * FIXED_DELTA;
+  const vector2d_t expected = v2d_from_angle(turned);
+  assert(fabs(v2d_length(ant->heading) - 1.0) < 1e-12);
+  assert(fabs(ant->heading.x - expected.x) < 1e-9 && fabs(ant->heading.y - expected.y) < 1e-9);
+  assert(fabs(constrain_angle(ant_get_rotation(ant) - turned)) < 1e-9);
+  (void)expected;
+  (void)turned;
+
+  ant_free(ant);
+  return EXIT_SUCCESS;
+}
+
+// The teacher turns to the side of its target and goes straight once it faces it
+int test_decision() {
+  const vector2d_t spawn = {500.0, 500.0};
+  ant_t *ant = ant_create((vector2d_t){500.0, 800.0}, spawn, 0.0, 2);
+  assert(ant);
+  ant->has_food = true;
+
+  // The spawn is clockwise of a heading of 0, a quarter turn away
+  assert(ant_decision(ant, FIXED_DELTA).turn_action == ANT_TURN_RIGHT);
+  ant->heading = v2d_from_angle(-M_PI);
+  assert(ant_decision(ant, FIXED_DELTA).turn_action == ANT_TURN_LEFT);
+
+  // Turning towards it until it is within 3/4 of a turn, then straight ahead
+  int turns = 0;
+  while (ant_decision(ant, FIXED_DELTA).turn_action == ANT_TURN_LEFT) {
+    ant_turn(ant, ANT_TURN_LEFT, FIXED_DELTA);
+    turns++;
+  }
+  assert(turns == (int)ceil((M_PI / 2.0 - 0.75 * ANT_TURN_SPEED * FIXED_DELTA) / (ANT_TURN_SPEED * FIXED_DELTA)));
+  assert(ant_decision(ant, FIXED_DELTA).turn_action == ANT_TURN_NONE);
+  (void)turns;
+
+  // Dropping at the spawn keeps turning
+  ant->pos = spawn;
+  const ant_logic_t drop = ant_decision(ant, FIXED_DELTA);
+  assert(drop.action == ANT_DROP_ACTION && drop.turn_action == ANT_TURN_LEFT);
+  (void)drop;
+
+  ant_free(ant);
+  printf("Ant tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_turn() != EXIT_SUCCESS || test_decision() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+#include "entities/command.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_BUFFERS 3
+
+// Ants contesting the last unit of food: the first buffer wins, the food is removed and the others get nothing
+int test_contested_food() {
+  command_buffer_t buffers[NUM_BUFFERS];
+  for (int i = 0; i < NUM_BUFFERS; i++) {
+    dyn_arr_init(buffers[i]);
+  }
+  dyn_arr_food_t food_list;
+  dyn_arr_init(food_list);
+
+  const vector2d_t pos = {100.0, 100.0};
+  food_t *contested = food_create(pos, 10.0, 50.0, 1);
+  food_t *plenty = food_create((vector2d_t){500.0, 500.0}, 10.0, 50.0, 5);
+  dyn_arr_push(food_list, contested);
+  dyn_arr_push(food_list, plenty);
+
+  ant_t *ants[NUM_BUFFERS];
+  for (int i = 0; i < NUM_BUFFERS; i++) {
+    ants[i] = ant_create(pos, pos, 0.0, i);
+    ants[i]->nearest_food = contested;
+  }
+
+  // Record from the last buffer first, the order of recording must not matter
+  for (int i = NUM_BUFFERS - 1; i >= 0; i--) {
+    const bool recorded = command_gather(&buffers[i], ants[i]);
+    assert(recorded);
+    (void)recorded;
+  }
+  assert(contested->amount == 1);
+
+  int removed = command_apply(buffers, NUM_BUFFERS, &food_list);
+  assert(removed == 1);
+  assert(ants[0]->has_food);
+  for (int i = 1; i < NUM_BUFFERS; i++) {
+    assert(!ants[i]->has_food);
+    assert(buffers[i].length == 0);
+  }
+  assert(food_list.length == 1 && dyn_arr_get(food_list, 0) == plenty);
+
+  // Removing food explicitly, nothing else changes
+  command_remove_food(&buffers[1], plenty);
+  removed = command_apply(buffers, NUM_BUFFERS, &food_list);
+  assert(removed == 1 && food_list.length == 0);
+  removed = command_apply(buffers, NUM_BUFFERS, &food_list);
+  assert(removed == 0);
+  (void)removed;
+
+  for (int i = 0; i < NUM_BUFFERS; i++) {
+    ant_free(ants[i]);
+    dyn_arr_free(buffers[i]);
+  }
+  dyn_arr_free(food_list);
+
+  printf("Command buffer tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() { return test_contested_food(); }
@@ -0,0 +1,73 @@
+#include "main/env.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main/simulation.h"
+
+#define NUM_WORLDS 4
+#define ANTS 16
+#define STEPS ((int)(RESET_TIME * TICK_RATE) + 10)
+
+static env_t *create_env(int threads) {
+  const env_config_t config = {
+      .num_worlds = NUM_WORLDS, .ants = ANTS, .food = 5, .seed = 7, .threads = threads, .scatter = false};
+  env_t *env = env_create(&config);
+  assert(env && env->num_agents == NUM_WORLDS * ANTS);
+  env_reset(env);
+  return env;
+}
+
+// Worlds stepped on any number of threads give the same observations, different worlds different ones
+int test_lockstep() {
+  env_t *serial = create_env(1);
+  env_t *parallel = create_env(3);
+  const size_t observation_bytes = (size_t)serial->num_agents * ENV_OBSERVATION_SIZE * sizeof(double);
+
+  int session_resets = 0;
+  for (int step = 0; step < STEPS; step++) {
+    // Follow the teacher, the buffers are written in place
+    memcpy(serial->actions, serial->teacher, serial->num_agents * sizeof(ant_logic_t));
+    memcpy(parallel->actions, parallel->teacher, parallel->num_agents * sizeof(ant_logic_t));
+    env_step(serial);
+    env_step(parallel);
+
+    assert(memcmp(serial->observations, parallel->observations, observation_bytes) == 0);
+    for (int w = 0; w < NUM_WORLDS; w++) {
+      assert(serial->session_reset[w] == (step == STEPS - 11));
+      session_resets += serial->session_reset[w];
+    }
+  }
+  assert(session_resets == NUM_WORLDS);
+  (void)session_resets;
+  (void)observation_bytes;
+
+  const size_t world_bytes = (size_t)ANTS * ENV_OBSERVATION_SIZE * sizeof(double);
+  assert(memcmp(serial->observations, serial->observations + ANTS * ENV_OBSERVATION_SIZE, world_bytes) != 0);
+  (void)world_bytes;
+
+  env_free(serial);
+  env_free(parallel);
+  return EXIT_SUCCESS;
+}
+
+int test_invalid() {
+  const env_config_t config = {.num_worlds = 0, .ants = ANTS};
+  env_t *env = env_create(&config);
+  assert(env == NULL);
+  env = env_create(NULL);
+  assert(env == NULL);
+  env_free(env);
+
+  printf("Environment tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_lockstep() != EXIT_SUCCESS || test_invalid() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
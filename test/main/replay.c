@@ -0,0 +1,104 @@
+#include "main/replay.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "main/simulation.h"
+
+#define ANTS 37
+#define SESSION_TICKS 700
+#define SESSIONS 3
+
+// Ticks of the teacher, scattered in random sessions as training does, with the world state after every tick
+static void record_run(const char *path, uint64_t *checksums) {
+  world_t *world = world_create(ANTS, 4, 3);
+  replay_recorder_t *recorder = replay_recorder_open(path, world, 3);
+  assert(world && recorder);
+  unsigned char actions[ANTS];
+
+  for (int session = 0; session < SESSIONS; session++) {
+    world_reset(world);
+    replay_record_session(recorder, world);
+    for (int tick = 0; tick < SESSION_TICKS; tick++) {
+      const bool scattered = tick % 2 == 0;
+      for (int i = 0; i < ANTS; i++) {
+        ant_t *ant = dyn_arr_get(world->ants, i);
+        if (scattered) {
+          world_scatter(world, ant);
+        }
+        ant_update_nearest_food(ant, &world->food);
+        const ant_logic_t logic = ant_decision(ant, FIXED_DELTA);
+        actions[i] = replay_encode_action(logic);
+        world_act(ant, logic, FIXED_DELTA, &world->commands);
+      }
+      world_finish_tick(world, &world->commands, 1);
+      replay_record_tick(recorder, world, actions, scattered);
+      checksums[session * SESSION_TICKS + tick] = world_checksum(world);
+    }
+  }
+
+  const long recorded = replay_recorder_close(recorder);
+  assert(recorded == SESSIONS * SESSION_TICKS);
+  (void)recorded;
+  world_free(world);
+}
+
+// Playback without the teacher ends in the same states and reports no divergence
+int test_playback() {
+  const char *path = "replay_test.amrp";
+  static uint64_t checksums[SESSIONS * SESSION_TICKS];
+  record_run(path, checksums);
+
+  FILE *file = fopen(path, "rb");
+  assert(file);
+  fseek(file, 0, SEEK_END);
+  // Less than the 4 bits per ant and tick of the raw actions
+  assert(ftell(file) < SESSIONS * SESSION_TICKS * ANTS / 2);
+  fclose(file);
+
+  replay_player_t *player = replay_player_open(path);
+  assert(player && player->world->ants.length == ANTS);
+  for (int tick = 0; tick < SESSIONS * SESSION_TICKS; tick++) {
+    const bool played = replay_player_step(player);
+    assert(played && world_checksum(player->world) == checksums[tick]);
+    (void)played;
+  }
+  const bool played = replay_player_step(player);
+  assert(!played);
+  (void)played;
+  assert(player->done && player->complete && player->diverged_tick < 0);
+  assert(player->ticks == SESSIONS * SESSION_TICKS);
+  replay_player_close(player);
+  remove(path);
+  return EXIT_SUCCESS;
+}
+
+int test_actions_and_invalid() {
+  for (int turn = ANT_TURN_RIGHT; turn <= ANT_TURN_LEFT; turn++) {
+    for (int action = ANT_STEP_ACTION; action <= ANT_DROP_ACTION; action++) {
+      const ant_logic_t logic = replay_decode_action(replay_encode_action((ant_logic_t){turn, action}));
+      assert((int)logic.turn_action == turn && (int)logic.action == action);
+      (void)logic;
+    }
+  }
+
+  const char *path = "replay_invalid.amrp";
+  FILE *file = fopen(path, "wb");
+  assert(file);
+  fputs("not a replay", file);
+  fclose(file);
+  assert(replay_player_open(path) == NULL);
+  assert(replay_player_open("missing.amrp") == NULL);
+  remove(path);
+
+  printf("Replay tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_playback() != EXIT_SUCCESS || test_actions_and_invalid() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
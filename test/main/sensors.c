@@ -0,0 +1,85 @@
+#include "main/sensors.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main/simulation.h"
+
+#define ANTS 300
+#define TICKS 400
+
+// The batch matches world_observe bit for bit for every ant
+static void check_observations(world_t *world, sensor_batch_t *batch, double *data) {
+  matrix_t observations = {data, 0, 0};
+  sensor_batch_load(batch, world, world->ants.data, world->ants.length);
+  sensor_batch_observe(batch, &observations);
+  assert(observations.rows == WORLD_OBSERVATION_SIZE && observations.cols == ANTS);
+
+  for (int i = 0; i < ANTS; i++) {
+    double expected[WORLD_OBSERVATION_SIZE];
+    world_observe(world, dyn_arr_get(world->ants, i), expected);
+    for (int f = 0; f < WORLD_OBSERVATION_SIZE; f++) {
+      assert(memcmp(&expected[f], &data[f * ANTS + i], sizeof(double)) == 0);
+    }
+  }
+}
+
+// Ants following the teacher through scattered and regular sessions, and ants sitting on the spawn and on food
+int test_matches_world_observe() {
+  world_t *world = world_create(ANTS, 6, 11);
+  sensor_batch_t batch;
+  const bool initialized = sensor_batch_init(&batch, ANTS);
+  static double data[WORLD_OBSERVATION_SIZE * ANTS];
+  assert(world && initialized);
+  (void)initialized;
+
+  for (int tick = 0; tick < TICKS; tick++) {
+    if (tick % 100 == 0) {
+      world_reset(world);
+    }
+    for (int i = 0; i < ANTS; i++) {
+      world_scatter(world, dyn_arr_get(world->ants, i));
+    }
+    check_observations(world, &batch, data);
+    for (int i = 0; i < ANTS; i++) {
+      ant_t *ant = dyn_arr_get(world->ants, i);
+      world_act(ant, ant_decision(ant, FIXED_DELTA), FIXED_DELTA, &world->commands);
+    }
+    world_finish_tick(world, &world->commands, 1);
+  }
+
+  // No direction to the spawn or the food, the observations fall back to the heading
+  const food_t food[2] = {{{200.0, 300.0}, 40.0, 300.0, 50}, {{900.0, 700.0}, 40.0, 300.0, 50}};
+  world_restore_session(world, false, food, 2);
+  for (int i = 0; i < ANTS; i++) {
+    ant_t *ant = dyn_arr_get(world->ants, i);
+    ant->pos = i % 3 == 0 ? ant->spawn : food[i % 3 - 1].pos;
+  }
+  check_observations(world, &batch, data);
+
+  sensor_batch_free(&batch);
+  world_free(world);
+  return EXIT_SUCCESS;
+}
+
+int test_invalid() {
+  sensor_batch_t batch;
+  bool initialized = sensor_batch_init(&batch, 0);
+  assert(!initialized);
+  initialized = sensor_batch_init(NULL, 4);
+  assert(!initialized);
+  (void)initialized;
+  sensor_batch_free(NULL);
+
+  printf("Sensors tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_matches_world_observe() != EXIT_SUCCESS || test_invalid() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
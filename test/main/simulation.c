@@ -0,0 +1,79 @@
+#include "main/simulation.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DRIVE_TICKS 10
+
+// The activations of every layer of the published network are those of a run on its inputs, and finite
+static void check_published_activations(void) {
+  simulation_publish_snapshot();
+  const world_snapshot_t *snapshot = simulation_acquire_snapshot();
+  neural_network_t *net = snapshot->net;
+  assert(net && !snapshot->training);
+
+  const matrix_t inputs = {net->output[0].data, net->neuron_counts[0], 1};
+  const matrix_t preds = neural_run_batch(net, &inputs);
+  assert(preds.data && preds.rows == ANN_OUTPUTS);
+  for (int l = 0; l < net->num_layers; l++) {
+    for (int j = 0; j < net->neuron_counts[l]; j++) {
+      assert(isfinite(net->output[l].data[j]));
+    }
+  }
+  const double *outputs = net->output[net->num_layers - 1].data;
+  for (int j = 0; j < ANN_OUTPUTS; j++) {
+    assert(fabs(outputs[j] - preds.data[j]) < 1e-9);
+  }
+  (void)preds;
+  (void)outputs;
+}
+
+// Without training the networks drive the ants in batches, the snapshot still shows the first ant's prediction
+int test_drive_snapshot() {
+  char *argv[] = {"simulation", "--ants", "24", "--seed", "7", "--threads", "1"};
+  simulation_options_t options;
+  const bool parsed = simulation_parse_options(sizeof(argv) / sizeof(argv[0]), argv, &options);
+  assert(parsed);
+  (void)parsed;
+  simulation_init(&options);
+
+  // Nothing ran a network before the first drive tick
+  g_settings.training = false;
+  simulation_tick(FIXED_DELTA);
+  check_published_activations();
+
+  // A training tick, then the inputs keep following the ant while it drives
+  g_settings.training = true;
+  simulation_tick(FIXED_DELTA);
+  g_settings.training = false;
+  simulation_publish_snapshot();
+  double trained_inputs[ANN_INPUTS];
+  const neural_network_t *net = simulation_acquire_snapshot()->net;
+  for (int j = 0; j < ANN_INPUTS; j++) {
+    trained_inputs[j] = net->output[0].data[j];
+  }
+  for (int t = 0; t < DRIVE_TICKS; t++) {
+    simulation_tick(FIXED_DELTA);
+  }
+  check_published_activations();
+  net = simulation_acquire_snapshot()->net;
+  bool changed = false;
+  for (int j = 0; j < ANN_INPUTS; j++) {
+    changed |= net->output[0].data[j] != trained_inputs[j];
+  }
+  assert(changed);
+  (void)changed;
+
+  simulation_cleanup();
+  printf("Simulation tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_drive_snapshot() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
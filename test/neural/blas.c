@@ -0,0 +1,57 @@
+#include "neural/blas.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Odd sizes so the unrolled loops also run their remainder
+int test_blas(void) {
+  double x_data[7] = {1, 2, 3, 4, 5, 6, 7};
+  double y_data[7] = {7, 6, 5, 4, 3, 2, 1};
+  vector_t x = {x_data, 7};
+  vector_t y = {y_data, 7};
+
+  assert(fabs(blas_dot(&x, &y) - 84.0) < 1e-12);
+
+  blas_axpy(2.0, &x, &y);
+  for (int i = 0; i < 7; i++) {
+    assert(fabs(y_data[i] - (7 - i + 2.0 * (i + 1))) < 1e-12);
+  }
+
+  blas_scaled_difference(0.5, &y, &x, &y);
+  for (int i = 0; i < 7; i++) {
+    assert(fabs(y_data[i] - 0.5 * (7 - i + (i + 1))) < 1e-12);
+  }
+
+  blas_hadamard(&x, &y);
+  blas_scale(0.25, &y);
+  for (int i = 0; i < 7; i++) {
+    assert(fabs(y_data[i] - (i + 1)) < 1e-12);
+  }
+
+  // A (3 x 5) with every column equal to b, row sums are 5 * b
+  double A_data[15];
+  double b_data[3] = {1, -2, 0.5};
+  double sum_data[3] = {1, 1, 1};
+  matrix_t A = {A_data, 3, 5};
+  vector_t b = {b_data, 3};
+  vector_t sum = {sum_data, 3};
+  blas_broadcast_columns(&b, &A);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 5; j++) {
+      assert(A_data[i * 5 + j] == b_data[i]);
+    }
+  }
+  blas_row_sum_axpy(-1.0, &A, &sum);
+  for (int i = 0; i < 3; i++) {
+    assert(fabs(sum_data[i] - (1.0 - 5.0 * b_data[i])) < 1e-12);
+  }
+
+  const vector_t flat = matrix_flatten(&A);
+  assert(flat.data == A_data && flat.rows == 15);
+  (void)flat;
+
+  return EXIT_SUCCESS;
+}
+
+int main() { return test_blas(); }
@@ -0,0 +1,95 @@
+#include "neural/convergence.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WINDOW 100
+
+// Feed samples agreeing except every period-th one, return the number of frozen state changes
+static int feed(convergence_t *convergence, int samples, int period, double loss) {
+  int changes = 0;
+  for (int i = 0; i < samples; i++) {
+    const bool agreed = period == 0 || (i + 1) % period != 0;
+    changes += convergence_update(convergence, agreed, loss) ? 1 : 0;
+  }
+  return changes;
+}
+
+// Freezing needs the window of samples, the agreement and the loss, never just one of them
+int test_freeze() {
+  convergence_t convergence;
+  convergence_init(&convergence, WINDOW);
+  assert(!convergence.frozen && convergence.samples == 0);
+
+  // Agreeing with a high loss never freezes
+  const int lossy_changes = feed(&convergence, 20 * WINDOW, 0, 0.5);
+  assert(lossy_changes == 0);
+  (void)lossy_changes;
+  assert(!convergence.frozen && convergence.agreement > CONVERGENCE_FREEZE_AGREEMENT);
+
+  // Fresh monitor, perfect samples: frozen on the first sample meeting both thresholds
+  convergence_init(&convergence, WINDOW);
+  int frozen_at = 0;
+  for (int i = 1; i <= 10 * WINDOW && !frozen_at; i++) {
+    if (convergence_update(&convergence, true, 0.0)) {
+      frozen_at = i;
+      assert(convergence.frozen);
+      assert(convergence.agreement >= CONVERGENCE_FREEZE_AGREEMENT && convergence.loss <= CONVERGENCE_FREEZE_LOSS);
+    } else {
+      assert(!convergence.frozen);
+    }
+  }
+  // 1 - 0.99^n reaches 0.97 after 349 samples, 0.99^n falls to 0.02 after 390
+  assert(frozen_at == 390);
+  (void)frozen_at;
+
+  // Windows are at least one sample, the averages then follow every sample fully
+  convergence_init(&convergence, 0);
+  assert(convergence.window == 1);
+  const bool changed = convergence_update(&convergence, true, 0.0);
+  assert(changed && convergence.frozen);
+  (void)changed;
+  return EXIT_SUCCESS;
+}
+
+// Between the thresholds nothing changes, frozen networks stay frozen and others keep training
+int test_hysteresis() {
+  convergence_t convergence;
+  convergence_init(&convergence, WINDOW);
+  int changes = feed(&convergence, 10 * WINDOW, 0, 0.0);
+  assert(changes == 1 && convergence.frozen);
+
+  // One disagreement in 15 keeps the agreement between 0.90 and 0.97
+  changes = feed(&convergence, 20 * WINDOW, 15, 0.0);
+  assert(changes == 0 && convergence.frozen);
+  assert(convergence.agreement < CONVERGENCE_FREEZE_AGREEMENT);
+
+  // Disagreeing unfreezes as soon as the agreement drops below 0.90
+  int unfrozen_at = 0;
+  for (int i = 1; i <= WINDOW && !unfrozen_at; i++) {
+    if (convergence_update(&convergence, false, 0.0)) {
+      unfrozen_at = i;
+    }
+  }
+  assert(unfrozen_at > 0 && !convergence.frozen && convergence.agreement < CONVERGENCE_UNFREEZE_AGREEMENT);
+  (void)unfrozen_at;
+
+  // The same noisy stream does not freeze it again, agreeing does
+  changes = feed(&convergence, 20 * WINDOW, 15, 0.0);
+  assert(changes == 0 && !convergence.frozen);
+  changes = feed(&convergence, 10 * WINDOW, 0, 0.0);
+  assert(changes == 1 && convergence.frozen);
+  (void)changes;
+
+  assert(!convergence_update(NULL, true, 0.0));
+  printf("Convergence tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_freeze() != EXIT_SUCCESS || test_hysteresis() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "neural/dataset.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define INPUTS 3
+#define OUTPUTS 2
+#define SAMPLES (2 * DATASET_CHUNK_SAMPLES + 1000)
+
+static const char *path = "dataset_test.amds";
+
+// Two producers take turns, sample i has inputs i, i + 1, i + 2, outputs -i, i and weight i % 7
+static void write_samples(void) {
+  dataset_writer_t *writer = dataset_writer_open(path, INPUTS, OUTPUTS, 2);
+  assert(writer);
+  for (int i = 0; i < SAMPLES; i++) {
+    const double inputs[INPUTS] = {i, i + 1, i + 2};
+    const double outputs[OUTPUTS] = {-i, i};
+    dataset_write(writer, i % 3 == 0, inputs, outputs, i % 7);
+  }
+  long dropped = -1;
+  const long written = dataset_writer_close(writer, &dropped);
+  assert(written + dropped == SAMPLES);
+  assert(dropped == 0);
+  (void)written;
+}
+
+// Every sample comes back once, the columns are aligned
+int test_round_trip() {
+  write_samples();
+  dataset_t *dataset = dataset_open(path);
+  assert(dataset && dataset->inputs == INPUTS && dataset->outputs == OUTPUTS && dataset->samples == SAMPLES);
+
+  static bool seen[SAMPLES];
+  for (int c = 0; c < dataset->num_chunks; c++) {
+    const dataset_chunk_t *chunk = &dataset->chunks[c];
+    assert(chunk->count > 0 && chunk->count <= DATASET_CHUNK_SAMPLES);
+    assert((uintptr_t)chunk->inputs % DATASET_ALIGNMENT == 0 && (uintptr_t)chunk->outputs % DATASET_ALIGNMENT == 0 &&
+           (uintptr_t)chunk->weights % DATASET_ALIGNMENT == 0);
+    for (int s = 0; s < chunk->count; s++) {
+      const int i = (int)chunk->inputs[s * INPUTS];
+      assert(i >= 0 && i < SAMPLES && !seen[i]);
+      seen[i] = true;
+      assert(chunk->inputs[s * INPUTS + 2] == i + 2);
+      assert(chunk->outputs[s * OUTPUTS] == -i && chunk->outputs[s * OUTPUTS + 1] == i);
+      assert(chunk->weights[s] == i % 7);
+    }
+  }
+  (void)seen;
+  dataset_close(dataset);
+  return EXIT_SUCCESS;
+}
+
+// A file cut inside a chunk is read up to the last complete chunk, other files are rejected
+int test_truncated_and_invalid() {
+  dataset_t *dataset = dataset_open(path);
+  assert(dataset && dataset->num_chunks >= 2);
+  const long first_chunk = dataset->chunks[0].count;
+  const off_t cut = (const char *)dataset->chunks[1].inputs - (const char *)dataset->map;
+  dataset_close(dataset);
+
+  const int truncated = truncate(path, cut);
+  assert(truncated == 0);
+  (void)truncated;
+  dataset = dataset_open(path);
+  assert(dataset && dataset->num_chunks == 1 && dataset->samples == first_chunk);
+  (void)first_chunk;
+  dataset_close(dataset);
+
+  FILE *file = fopen(path, "wb");
+  assert(file);
+  fputs("not a dataset", file);
+  fclose(file);
+  assert(dataset_open(path) == NULL);
+  assert(dataset_open("missing.amds") == NULL);
+  assert(dataset_writer_open(path, 0, OUTPUTS, 1) == NULL);
+  remove(path);
+
+  printf("Dataset tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_round_trip() != EXIT_SUCCESS || test_truncated_and_invalid() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+#include "neural/autotune.h"
+#include "neural/matrix.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void fill_random(double *data, int count) {
+  for (int i = 0; i < count; i++) {
+    data[i] = (double)rand() / RAND_MAX * 2.0 - 1.0;
+  }
+}
+
+static void assert_close(const matrix_t *a, const matrix_t *b) {
+  for (int i = 0; i < a->rows * a->cols; i++) {
+    assert(fabs(a->data[i] - b->data[i]) < 1e-9);
+  }
+}
+
+// Every kernel must produce the same result as the naive kernel
+int test_kernels(int n, int k, int p) {
+  double *A_data = malloc(n * k * sizeof(double));
+  double *B_data = malloc(k * p * sizeof(double));
+  double *expected_data = malloc(n * p * sizeof(double));
+  double *result_data = malloc(n * p * sizeof(double));
+  assert(A_data && B_data && expected_data && result_data);
+  fill_random(A_data, n * k);
+  fill_random(B_data, k * p);
+
+  for (int kernel = 0; kernel < MATRIX_KERNEL_COUNT; kernel++) {
+    // A (n x k) * B (k x p), accumulated on top of a non-zero result
+    matrix_t A = {A_data, n, k};
+    matrix_t B = {B_data, k, p};
+    matrix_t expected = {expected_data, n, p};
+    matrix_t result = {result_data, n, p};
+    for (int i = 0; i < n * p; i++) {
+      expected_data[i] = result_data[i] = 0.5;
+    }
+    matrix_multiply_append(&A, &B, &expected);
+    matrix_multiply_append_kernel(&A, &B, &result, (matrix_kernel_t)kernel);
+    assert_close(&expected, &result);
+
+    // A^T (k x n)^T * B (k x p), A reinterpreted as k x n
+    matrix_t A_T = {A_data, k, n};
+    matrix_t B_A = {B_data, k, p};
+    matrix_t expected_A = {expected_data, n, p};
+    matrix_t result_A = {result_data, n, p};
+    matrix_multiply_transformA(&A_T, &B_A, &expected_A, true);
+    matrix_multiply_transformA_kernel(&A_T, &B_A, &result_A, true, (matrix_kernel_t)kernel);
+    assert_close(&expected_A, &result_A);
+
+    // A (n x k) * B^T, B reinterpreted as p x k
+    matrix_t B_T = {B_data, p, k};
+    matrix_multiply_transformB(&A, &B_T, &expected, false);
+    matrix_multiply_transformB_kernel(&A, &B_T, &result, false, (matrix_kernel_t)kernel);
+    assert_close(&expected, &result);
+  }
+
+  free(A_data);
+  free(B_data);
+  free(expected_data);
+  free(result_data);
+  return EXIT_SUCCESS;
+}
+
+int test_autotune_cache() {
+  const char *path = "autotune_test.cache";
+  autotune_clear();
+  const matrix_kernel_t kernel = autotune_benchmark(MATRIX_OP_MULTIPLY, 16, 10, 1);
+  assert(autotune_lookup(MATRIX_OP_MULTIPLY, 16, 10, 1) == kernel);
+  const bool saved = autotune_save(path);
+  assert(saved);
+
+  autotune_clear();
+  assert(autotune_lookup(MATRIX_OP_MULTIPLY, 16, 10, 1) == MATRIX_KERNEL_NAIVE);
+  const bool loaded = autotune_load(path);
+  assert(loaded);
+  assert(autotune_lookup(MATRIX_OP_MULTIPLY, 16, 10, 1) == kernel);
+  remove(path);
+  (void)kernel; // Suppress unused variable warning
+  (void)saved;
+  (void)loaded;
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  const int shapes[][3] = {{1, 1, 1}, {16, 10, 1}, {6, 16, 1}, {16, 10, 7}, {6, 16, 1000}, {70, 130, 67}};
+  for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+    if (test_kernels(shapes[i][0], shapes[i][1], shapes[i][2]) != EXIT_SUCCESS) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (test_autotune_cache() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,29 +1,35 @@
+#include "neural/fedavg.h"
 #include "neural/nn.h"
+#include "neural/sparse.h"
 
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+
+// Fixed seed, every run trains the same networks on the same samples
+#define TEST_SEED 42
+
+static rng_t rng;
 
 int test_xor() {
   int neuron_counts[] = {2, 2, 1};
-  neural_network_t *network = neural_create(1, neuron_counts);
+  neural_network_t *network = neural_create(1, neuron_counts, NULL);
   assert(network != NULL);
 
   double std = sqrt(6) / sqrt(network->neuron_counts[0] + network->neuron_counts[2]);
-  neural_randomize_weights(network, -std, std);
-  neural_randomize_bias(network, 0, 0);
+  neural_randomize_weights(network, &rng, -std, std);
+  neural_randomize_bias(network, &rng, 0, 0);
 
   const double inputs[4][2] = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
   const double expected_outputs[4][1] = {{0}, {1}, {1}, {0}};
 
   for (int i = 0; i < 1000000; i++) {
     // Randomly select 2 inputs and their expected output
-    int rand_index = rand() % 4;
+    int rand_index = rng_int(&rng, 4);
     int prev_index = rand_index;
     while (rand_index == prev_index) {
-      rand_index = rand() % 4;
+      rand_index = rng_int(&rng, 4);
     }
 
     const double inputs_ptr[4] = {inputs[rand_index][0], inputs[rand_index][1], inputs[prev_index][0],
@@ -53,49 +59,232 @@ int test_xor() {
   return EXIT_SUCCESS;
 }
 
-// int test_read_write() {
-//   int neuron_counts[] = {3, 20, 4, 3, 4, 5};
-//   neural_network_t *network = neural_create((sizeof(neuron_counts) / sizeof(int)) - 2, neuron_counts);
-//   assert(network != NULL);
-
-//   neural_randomize_weights(network, -1.0, 1.0);
-//   neural_randomize_bias(network, -0.5, 0.5);
-
-//   if (!neural_write(network, "neural_write_test.bin")) {
-//     return EXIT_FAILURE;
-//   }
-
-//   neural_network_t *read_network = neural_read("neural_write_test.bin");
-//   if (!read_network) {
-//     return EXIT_FAILURE;
-//   }
-
-//   assert(read_network->num_hidden_layers == network->num_hidden_layers);
-//   assert(read_network->total_neurons == network->total_neurons);
-//   assert(read_network->total_weights == network->total_weights);
-//   assert(read_network->neuron_counts != NULL);
-//   for (int i = 0; i < read_network->num_hidden_layers + 2; i++) {
-//     assert(read_network->neuron_counts[i] == network->neuron_counts[i]);
-//   }
-//   assert(read_network->output != NULL);
-//   assert(read_network->weightsT != NULL);
-//   for (int i = 0; i < read_network->total_weights; i++) {
-//     assert(read_network->weightsT[i] == network->weightsT[i]);
-//   }
-//   assert(read_network->bias != NULL);
-//   for (int i = 0; i < read_network->total_neurons; i++) {
-//     assert(read_network->bias[i] == network->bias[i]);
-//   }
-//   assert(read_network->data != NULL);
-
-//   neural_free(read_network);
-//   neural_free(network);
-//   return EXIT_SUCCESS;
-// }
+// The derivative kernels must match a finite difference of the forward kernels
+int test_activations() {
+  const double points[] = {-3.0, -0.7, -0.1, 0.2, 0.9, 4.0};
+  const int count = sizeof(points) / sizeof(points[0]);
+  const double h = 1e-6;
+
+  for (int activation = 0; activation < NEURAL_ACTIVATION_COUNT; activation++) {
+    double outputs[sizeof(points) / sizeof(points[0])];
+    double plus[sizeof(points) / sizeof(points[0])];
+    double minus[sizeof(points) / sizeof(points[0])];
+    double delta[sizeof(points) / sizeof(points[0])];
+    for (int i = 0; i < count; i++) {
+      outputs[i] = points[i];
+      plus[i] = points[i] + h;
+      minus[i] = points[i] - h;
+      delta[i] = 1.0;
+    }
+
+    activation_forward((neural_activation_t)activation, outputs, count);
+    activation_forward((neural_activation_t)activation, plus, count);
+    activation_forward((neural_activation_t)activation, minus, count);
+    activation_backward((neural_activation_t)activation, outputs, delta, count);
+
+    for (int i = 0; i < count; i++) {
+      const double numeric = (plus[i] - minus[i]) / (2.0 * h);
+      printf("%s'(%.2f) = %f (numeric %f)\n", activation_name((neural_activation_t)activation), points[i], delta[i],
+             numeric);
+      assert(fabs(delta[i] - numeric) < 1e-5);
+    }
+  }
+
+  // A ReLU hidden layer with a sigmoid head has to train without producing NaNs
+  int neuron_counts[] = {2, 8, 1};
+  neural_activation_t activations[] = {NEURAL_RELU, NEURAL_SIGMOID};
+  neural_network_t *network = neural_create(1, neuron_counts, activations);
+  assert(network != NULL);
+  assert(network->activations[0] == NEURAL_RELU && network->activations[1] == NEURAL_SIGMOID);
+  neural_randomize_weights(network, &rng, -1.0, 1.0);
+  neural_randomize_bias(network, &rng, 0.0, 0.1);
+
+  const double inputs[4] = {0.0, 1.0, 1.0, 0.0};
+  const double outputs[2] = {1.0, 1.0};
+  const matrix_t inputs_matrix = {(double *)inputs, 2, 2};
+  const matrix_t outputs_matrix = {(double *)outputs, 2, 1};
+  for (int i = 0; i < 1000; i++) {
+    const double cost = neural_train(network, &inputs_matrix, &outputs_matrix, 0.1);
+    assert(!isnan(cost) && cost >= 0.0);
+    (void)cost; // Suppress unused variable warning
+  }
+
+  neural_free(network);
+  return EXIT_SUCCESS;
+}
+
+int test_read_write() {
+  int neuron_counts[] = {3, 20, 4, 3, 4, 5};
+  const neural_activation_t activations[] = {NEURAL_RELU, NEURAL_TANH, NEURAL_LEAKY_RELU, NEURAL_RELU, NEURAL_SIGMOID};
+  neural_network_t *network = neural_create((sizeof(neuron_counts) / sizeof(int)) - 2, neuron_counts, activations);
+  assert(network != NULL);
+
+  neural_randomize_weights(network, &rng, -1.0, 1.0);
+  neural_randomize_bias(network, &rng, -0.5, 0.5);
+
+  if (!neural_write(network, "neural_write_test.bin")) {
+    return EXIT_FAILURE;
+  }
+
+  neural_network_t *read_network = neural_read("neural_write_test.bin");
+  remove("neural_write_test.bin");
+  if (!read_network) {
+    return EXIT_FAILURE;
+  }
+
+  assert(read_network->num_hidden_layers == network->num_hidden_layers);
+  assert(read_network->total_neurons == network->total_neurons);
+  assert(read_network->total_weights == network->total_weights);
+  assert(neural_same_shape(read_network, network));
+  assert(read_network->output != NULL);
+  assert(read_network->weightsT != NULL);
+  for (int i = 0; i < read_network->total_weights; i++) {
+    assert(read_network->weightsT[0].data[i] == network->weightsT[0].data[i]);
+  }
+  assert(read_network->bias != NULL);
+  for (int i = 0; i < read_network->total_neurons; i++) {
+    assert(read_network->bias[0].data[i] == network->bias[0].data[i]);
+  }
+  assert(read_network->data != NULL);
+
+  neural_free(read_network);
+  neural_free(network);
+  return EXIT_SUCCESS;
+}
+
+// Averaging must pull every network to the mean and refuse networks of another shape
+int test_fedavg() {
+  const int neuron_counts[] = {3, 5, 2};
+  const int other_counts[] = {3, 4, 2};
+  neural_network_t *networks[3];
+  for (int i = 0; i < 3; i++) {
+    networks[i] = neural_create(1, neuron_counts, NULL);
+    assert(networks[i] != NULL);
+    neural_randomize_weights(networks[i], &rng, -1.0, 1.0);
+    neural_randomize_bias(networks[i], &rng, -1.0, 1.0);
+  }
+
+  const vector_t p0 = neural_parameters(networks[0]);
+  const vector_t p1 = neural_parameters(networks[1]);
+  const vector_t p2 = neural_parameters(networks[2]);
+  assert(p0.rows == 3 * 5 + 5 * 2 + 3 + 5 + 2);
+  const double before0 = p0.data[7];
+  const double mean = (p0.data[7] + p1.data[7] + p2.data[7]) / 3.0;
+
+  bool mixed = fedavg_mix(networks, 3, 0.5);
+  assert(mixed && fabs(p0.data[7] - (before0 + 0.5 * (mean - before0))) < 1e-12);
+
+  mixed = fedavg_mix(networks, 3, 1.0);
+  assert(mixed);
+  for (int i = 0; i < p0.rows; i++) {
+    assert(fabs(p0.data[i] - p1.data[i]) < 1e-12 && fabs(p0.data[i] - p2.data[i]) < 1e-12);
+  }
+  assert(fabs(p0.data[7] - mean) < 1e-12);
+  (void)before0;
+  (void)mean;
+
+  neural_network_t *other = neural_create(1, other_counts, NULL);
+  neural_network_t *mismatched[] = {networks[0], other};
+  mixed = fedavg_mix(mismatched, 2, 1.0);
+  assert(!mixed);
+  (void)mixed;
+
+  neural_free(other);
+  for (int i = 0; i < 3; i++) {
+    neural_free(networks[i]);
+  }
+  return EXIT_SUCCESS;
+}
+
+// A pruned network must give the same outputs dense and sparse
+int test_sparse() {
+  const int neuron_counts[] = {6, 9, 7, 4};
+  const neural_activation_t activations[] = {NEURAL_RELU, NEURAL_TANH, NEURAL_SIGMOID};
+  neural_network_t *network = neural_create(2, neuron_counts, activations);
+  assert(network != NULL);
+  neural_randomize_weights(network, &rng, -1.0, 1.0);
+  neural_randomize_bias(network, &rng, -0.5, 0.5);
+
+  bool mask[6 * 9 + 9 * 7 + 7 * 4];
+  const int pruned = neural_prune(network, 0.7, mask);
+  assert(pruned == (int)(0.7 * network->total_weights));
+  (void)pruned;
+  int kept = 0;
+  for (int i = 0; i < network->total_weights; i++) {
+    kept += mask[i];
+    assert(mask[i] || network->weightsT[0].data[i] == 0.0);
+  }
+
+  sparse_network_t *sparse = sparse_create(network);
+  assert(sparse != NULL);
+  assert(sparse->total_nonzeros <= kept);
+
+  vector_t input = {(double[6]){0.3, -0.2, 0.9, 0.0, -1.0, 0.5}, 6};
+  const vector_t *sparse_output = sparse_run(sparse, &input);
+  const vector_t *dense_output = neural_run(network, &input);
+  assert(sparse_output->rows == dense_output->rows);
+  for (int i = 0; i < dense_output->rows; i++) {
+    assert(fabs(sparse_output->data[i] - dense_output->data[i]) < 1e-12);
+  }
+  (void)sparse_output;
+
+  // A clone matches the original until one of them changes
+  neural_network_t *clone = neural_clone(network);
+  assert(clone != NULL && neural_same_shape(clone, network));
+  const vector_t *clone_output = neural_run(clone, &input);
+  for (int i = 0; i < clone_output->rows; i++) {
+    assert(clone_output->data[i] == dense_output->data[i]);
+  }
+
+  neural_free(clone);
+  sparse_free(sparse);
+  neural_free(network);
+  return EXIT_SUCCESS;
+}
+
+// A batch gives the outputs of running every column on its own
+int test_run_batch() {
+  const int neuron_counts[] = {4, 7, 3};
+  const neural_activation_t activations[] = {NEURAL_LEAKY_RELU, NEURAL_SIGMOID};
+  neural_network_t *network = neural_create(1, neuron_counts, activations);
+  assert(network != NULL);
+  neural_randomize_weights(network, &rng, -1.0, 1.0);
+  neural_randomize_bias(network, &rng, -0.5, 0.5);
+
+  enum { samples = 37 };
+  double inputs[4 * samples];
+  for (int i = 0; i < 4 * samples; i++) {
+    inputs[i] = rng_uniform(&rng, -1.0, 1.0);
+  }
+  const matrix_t input_matrix = {inputs, 4, samples};
+  const matrix_t outputs = neural_run_batch(network, &input_matrix);
+  assert(outputs.data != NULL && outputs.rows == 3 && outputs.cols == samples);
+
+  for (int j = 0; j < samples; j++) {
+    double column[4];
+    for (int i = 0; i < 4; i++) {
+      column[i] = inputs[i * samples + j];
+    }
+    const vector_t input = {column, 4};
+    const vector_t *output = neural_run(network, &input);
+    for (int i = 0; i < 3; i++) {
+      assert(fabs(output->data[i] - outputs.data[i * samples + j]) < 1e-12);
+    }
+    (void)output;
+  }
+  (void)outputs;
+
+  const matrix_t wrong_shape = {inputs, 3, samples};
+  const matrix_t rejected = neural_run_batch(network, &wrong_shape);
+  assert(rejected.data == NULL);
+  (void)rejected;
+  neural_free(network);
+  return EXIT_SUCCESS;
+}
 
 int main() {
   int neuron_counts[] = {3, 20, 4, 3, 4, 5};
-  neural_network_t *network = neural_create((sizeof(neuron_counts) / sizeof(int)) - 2, neuron_counts);
+  neural_network_t *network = neural_create((sizeof(neuron_counts) / sizeof(int)) - 2, neuron_counts, NULL);
 
   assert(network != NULL);
   assert(network->num_hidden_layers == (sizeof(neuron_counts) / sizeof(int)) - 2);
@@ -104,9 +293,9 @@ int main() {
   assert(network->weightsT != NULL);
   assert(network->bias != NULL);
 
-  srand(time(NULL));
-  neural_randomize_weights(network, -1.0, 1.0);
-  neural_randomize_bias(network, -0.5, 0.5);
+  rng_seed(&rng, TEST_SEED);
+  neural_randomize_weights(network, &rng, -1.0, 1.0);
+  neural_randomize_bias(network, &rng, -0.5, 0.5);
 
   // vector_t input = {(double[3]){0.1, 0.2, 0.3}, 3};
   // const vector_t *output = neural_run(network, &input);
@@ -127,7 +316,8 @@ int main() {
 
   neural_free(network);
   fflush(stdout);
-  if (test_xor() != EXIT_SUCCESS /* || test_read_write() != EXIT_SUCCESS */) {
+  if (test_activations() != EXIT_SUCCESS || test_fedavg() != EXIT_SUCCESS || test_sparse() != EXIT_SUCCESS ||
+      test_run_batch() != EXIT_SUCCESS || test_read_write() != EXIT_SUCCESS || test_xor() != EXIT_SUCCESS) {
     return EXIT_FAILURE;
   }
 
@@ -0,0 +1,82 @@
+#include "util/rng.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLES 100000
+
+// The same seed and stream must always give the same sequence, different streams different ones
+int test_streams() {
+  rng_t a, b, c;
+  rng_seed_stream(&a, 1234, 7);
+  rng_seed_stream(&b, 1234, 7);
+  rng_seed_stream(&c, 1234, 8);
+
+  int same_as_other_stream = 0;
+  for (int i = 0; i < 1000; i++) {
+    const uint64_t value = rng_next(&a);
+    assert(value == rng_next(&b));
+    same_as_other_stream += value == rng_next(&c);
+  }
+  assert(same_as_other_stream == 0);
+  (void)same_as_other_stream;
+
+  return EXIT_SUCCESS;
+}
+
+// Bulk generation must match one value at a time
+int test_fill() {
+  rng_t single, bulk;
+  rng_seed(&single, 99);
+  rng_seed(&bulk, 99);
+
+  double values[257];
+  rng_fill_uniform(&bulk, values, 257, -2.0, 3.0);
+  for (int i = 0; i < 257; i++) {
+    assert(values[i] == rng_uniform(&single, -2.0, 3.0));
+  }
+
+  uint64_t bits[64];
+  rng_fill_u64(&bulk, bits, 64);
+  for (int i = 0; i < 64; i++) {
+    assert(bits[i] == rng_next(&single));
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// Values must stay in range and be roughly uniform
+int test_ranges() {
+  rng_t rng;
+  rng_seed(&rng, 5);
+
+  int counts[10] = {0};
+  double sum = 0.0;
+  for (int i = 0; i < SAMPLES; i++) {
+    const double value = rng_double(&rng);
+    assert(value >= 0.0 && value < 1.0);
+    sum += value;
+
+    const int index = rng_int(&rng, 10);
+    assert(index >= 0 && index < 10);
+    counts[index]++;
+  }
+  assert(fabs(sum / SAMPLES - 0.5) < 0.01);
+  for (int i = 0; i < 10; i++) {
+    assert(abs(counts[i] - SAMPLES / 10) < SAMPLES / 100);
+  }
+  assert(rng_int(&rng, 0) == 0);
+  (void)sum;
+
+  printf("RNG tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_streams() != EXIT_SUCCESS || test_fill() != EXIT_SUCCESS || test_ranges() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
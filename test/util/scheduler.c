@@ -0,0 +1,41 @@
+#include "util/scheduler.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// The plan fills the budget left next to rendering, and the rate follows the ticks counted per frame
+int test_plan() {
+  scheduler_t scheduler;
+  scheduler_init(&scheduler, 0.1, 0.0);
+  assert(scheduler_plan(&scheduler, true) == 1);
+
+  // 1 ms per tick and 20 ms per rendered frame
+  scheduler_record_ticks(&scheduler, 10, 0.01);
+  scheduler_record_render(&scheduler, 0.02);
+  assert(scheduler_plan(&scheduler, true) == 80);
+  assert(scheduler_plan(&scheduler, false) == 100);
+
+  // Rendering slower than the budget still runs a tick
+  scheduler_record_render(&scheduler, 10.0);
+  assert(scheduler_plan(&scheduler, true) == 1);
+
+  // Costs are smoothed, a single slow tick does not halve the plan
+  scheduler_record_ticks(&scheduler, 1, 0.002);
+  assert(fabs(scheduler.tick_cost - 0.0011) < 1e-12);
+
+  // Ticks another thread ran are counted without changing the cost
+  scheduler_record_ticks(&scheduler, 1000, 0.0);
+  assert(fabs(scheduler.tick_cost - 0.0011) < 1e-12);
+  for (int frame = 1; frame <= 100; frame++) {
+    scheduler_record_ticks(&scheduler, 300, 0.0);
+    scheduler_end_frame(&scheduler, frame * 0.1);
+  }
+  assert(fabs(scheduler.ticks_per_second - 3000.0) < 1.0);
+
+  printf("Scheduler tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() { return test_plan(); }
@@ -0,0 +1,87 @@
+#include "util/spsc.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CAPACITY 8
+#define ITEMS 20000
+
+// Slots come out in the order they went in, and a full ring refuses more
+int test_order() {
+  spsc_ring_t ring;
+  int slots[CAPACITY];
+  bool initialized = spsc_init(&ring, 6);
+  assert(!initialized);
+  initialized = spsc_init(&ring, CAPACITY);
+  assert(initialized);
+  (void)initialized;
+  assert(spsc_read_slot(&ring) == -1);
+
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < CAPACITY; i++) {
+      const int slot = spsc_write_slot(&ring);
+      assert(slot >= 0);
+      slots[slot] = round * CAPACITY + i;
+      spsc_push(&ring);
+    }
+    assert(spsc_write_slot(&ring) == -1);
+
+    for (int i = 0; i < CAPACITY; i++) {
+      const int slot = spsc_read_slot(&ring);
+      assert(slot >= 0 && slots[slot] == round * CAPACITY + i);
+      (void)slot;
+      spsc_pop(&ring);
+    }
+    assert(spsc_read_slot(&ring) == -1);
+  }
+  (void)slots;
+  return EXIT_SUCCESS;
+}
+
+static spsc_ring_t shared_ring;
+static int shared_slots[CAPACITY];
+
+static void *produce(void *arg) {
+  (void)arg;
+  for (int i = 0; i < ITEMS; i++) {
+    int slot;
+    while ((slot = spsc_write_slot(&shared_ring)) < 0) {
+      sched_yield();
+    }
+    shared_slots[slot] = i;
+    spsc_push(&shared_ring);
+  }
+  return NULL;
+}
+
+// A producer thread and the consumer never lose, repeat or reorder an item
+int test_threads() {
+  spsc_init(&shared_ring, CAPACITY);
+  pthread_t producer;
+  const int created = pthread_create(&producer, NULL, produce, NULL);
+  assert(created == 0);
+  (void)created;
+
+  for (int i = 0; i < ITEMS; i++) {
+    int slot;
+    while ((slot = spsc_read_slot(&shared_ring)) < 0) {
+      sched_yield();
+    }
+    assert(shared_slots[slot] == i);
+    spsc_pop(&shared_ring);
+  }
+  pthread_join(producer, NULL);
+
+  printf("SPSC ring tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (test_order() != EXIT_SUCCESS || test_threads() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
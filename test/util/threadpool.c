@@ -0,0 +1,142 @@
+#include "util/threadpool.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THREADS 4
+#define MAX_COUNT 1000
+#define JOBS 1000
+
+// What the ranges of one job touched, every worker only writes its own slots and the items of its range
+typedef struct {
+  int hits[MAX_COUNT];
+  int calls[THREADS];
+  int begin[THREADS];
+  int end[THREADS];
+  pthread_t thread[THREADS];
+} job_t;
+
+// Workers that exited, counted by a thread-specific destructor the tasks register
+static pthread_key_t exit_key;
+static atomic_int exited_workers = 0;
+
+static void count_exit(void *value) {
+  (void)value;
+  atomic_fetch_add(&exited_workers, 1);
+}
+
+static void record_range(void *arg, int begin, int end, int worker) {
+  job_t *job = arg;
+  assert(worker >= 0 && worker < THREADS);
+  job->calls[worker]++;
+  job->begin[worker] = begin;
+  job->end[worker] = end;
+  job->thread[worker] = pthread_self();
+  for (int i = begin; i < end; i++) {
+    job->hits[i]++;
+  }
+  if (worker > 0) {
+    pthread_setspecific(exit_key, job);
+  }
+}
+
+// Run one job and check its ranges cover [0, count) once, in worker order, and return how many there were
+static int run_job(threadpool_t *pool, job_t *job, int count, int grain) {
+  memset(job, 0, sizeof(*job));
+  threadpool_parallel_for(pool, count, grain, record_range, job);
+
+  int ranges = 0;
+  for (int w = 0; w < THREADS; w++) {
+    assert(job->calls[w] <= 1);
+    if (job->calls[w] == 1) {
+      assert(w == ranges);
+      assert(job->begin[w] == (w == 0 ? 0 : job->end[w - 1]) && job->begin[w] < job->end[w]);
+      ranges++;
+    }
+  }
+  assert(ranges > 0 && job->end[ranges - 1] == count);
+  for (int i = 0; i < count; i++) {
+    assert(job->hits[i] == 1);
+  }
+  return ranges;
+}
+
+// Fewer items than threads, more items than threads and ranges limited by the grain
+int test_ranges() {
+  threadpool_t *pool = threadpool_create(THREADS);
+  assert(pool && threadpool_size(pool) == THREADS);
+  static job_t job;
+
+  int ranges = run_job(pool, &job, 3, 1);
+  assert(ranges == 3);
+  ranges = run_job(pool, &job, MAX_COUNT, 1);
+  assert(ranges == THREADS);
+  ranges = run_job(pool, &job, 1, 1);
+  assert(ranges == 1);
+  ranges = run_job(pool, &job, 100, 40);
+  assert(ranges == 2);
+  ranges = run_job(pool, &job, 100, 1000);
+  assert(ranges == 1 && pthread_equal(job.thread[0], pthread_self()));
+  (void)ranges;
+
+  // Nothing to do runs nothing
+  memset(&job, 0, sizeof(job));
+  threadpool_parallel_for(pool, 0, 1, record_range, &job);
+  assert(job.calls[0] == 0);
+
+  threadpool_free(pool);
+  return EXIT_SUCCESS;
+}
+
+// Without a pool everything runs on the calling thread as one range
+int test_inline() {
+  static job_t job;
+  assert(threadpool_size(NULL) == 1);
+  const int ranges = run_job(NULL, &job, MAX_COUNT, 1);
+  assert(ranges == 1 && pthread_equal(job.thread[0], pthread_self()));
+  (void)ranges;
+  return EXIT_SUCCESS;
+}
+
+// Jobs keep running on the same workers, freeing the pool waits for all of them to exit
+int test_reuse_and_free() {
+  const int exited = atomic_load(&exited_workers);
+  threadpool_t *pool = threadpool_create(THREADS);
+  assert(pool);
+  static job_t first;
+  static job_t job;
+
+  run_job(pool, &first, MAX_COUNT, 1);
+  for (int j = 0; j < JOBS; j++) {
+    const int count = 1 + j % MAX_COUNT;
+    run_job(pool, &job, count, 1);
+    for (int w = 0; w < THREADS; w++) {
+      assert(job.calls[w] == 0 || pthread_equal(job.thread[w], first.thread[w]));
+    }
+  }
+  for (int w = 1; w < THREADS; w++) {
+    assert(!pthread_equal(first.thread[w], pthread_self()));
+  }
+
+  threadpool_free(pool);
+  assert(atomic_load(&exited_workers) == exited + THREADS - 1);
+  (void)exited;
+
+  printf("Threadpool tests passed\n");
+  return EXIT_SUCCESS;
+}
+
+int main() {
+  if (pthread_key_create(&exit_key, count_exit) != 0) {
+    return EXIT_FAILURE;
+  }
+  if (test_ranges() != EXIT_SUCCESS || test_inline() != EXIT_SUCCESS || test_reuse_and_free() != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}